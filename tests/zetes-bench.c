@@ -0,0 +1,656 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "zetes.h"
+
+
+#define BENCH_STACK_DEPTH		512
+#define BENCH_CHUNK_SIZE		4096
+#define BENCH_BATCHES			5
+#define BENCH_LOOKUP_ROUNDS		16
+
+
+typedef enum {
+	FORMAT_TEXT,
+	FORMAT_CSV,
+	FORMAT_JSON
+} format_t;
+
+
+typedef struct {
+	const char* name;
+	char* data;
+	size_t size;
+} doc_t;
+
+
+typedef struct {
+	char* data;
+	size_t size;
+	size_t capacity;
+} text_t;
+
+
+typedef struct {
+	const char* data;
+	size_t size;
+	size_t pos;
+	size_t chunk;
+	size_t calls;
+} source_t;
+
+
+typedef struct {
+	size_t bytes;
+	size_t calls;
+} sink_t;
+
+
+typedef struct {
+	double ns;
+	size_t ops;
+	size_t bytes;
+	size_t arena;
+	size_t calls;
+} result_t;
+
+
+typedef struct {
+	const char** keys;
+	size_t* lengths;
+	size_t count;
+	size_t capacity;
+	double ns;
+	size_t ops;
+} lookup_t;
+
+
+static format_t g_format = FORMAT_TEXT;
+static double g_min_time = 0.5;
+static size_t g_chunk = BENCH_CHUNK_SIZE;
+static char g_read_buffer[BENCH_CHUNK_SIZE];
+static char g_write_buffer[BENCH_CHUNK_SIZE];
+static void* g_arena;
+static size_t g_arena_size;
+static bool g_first_row = true;
+
+
+static double now_ns(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double) ts.tv_sec * 1e9 + (double) ts.tv_nsec;
+}
+
+
+static void* checked_realloc(void* ptr, size_t size) {
+	ptr = realloc(ptr, size);
+
+	if ( !ptr ) {
+		fprintf(stderr, "zetes-bench: out of memory\n");
+		exit(EXIT_FAILURE);
+	}
+
+	return ptr;
+}
+
+
+static void text_append(text_t* text, const char* format, ...) {
+	va_list args;
+	int length;
+
+	for (;;) {
+		size_t space = text->capacity - text->size;
+
+		va_start(args, format);
+		length = vsnprintf(text->data + text->size, space, format, args);
+		va_end(args);
+
+		if ( length >= 0 && (size_t) length < space ) {
+			text->size += length;
+			return;
+		}
+
+		text->capacity = text->capacity ? text->capacity * 2 : 65536;
+		text->data = (char*) checked_realloc(text->data, text->capacity);
+	}
+}
+
+
+static void make_deep(doc_t* doc) {
+	// many chains nested just short of the default depth limit
+	text_t text = {NULL, 0, 0};
+	int i, j;
+
+	text_append(&text, "[");
+
+	for (i = 0; i < 2000; i++) {
+		text_append(&text, i ? ",\n" : "\n");
+
+		for (j = 0; j < 120; j++) {
+			text_append(&text, (j & 1) ? "{\"k%d\":" : "[%d,", j);
+		}
+
+		text_append(&text, "\"leaf\"");
+
+		for (j = 119; j >= 0; j--) {
+			text_append(&text, (j & 1) ? "}" : "]");
+		}
+	}
+
+	text_append(&text, "\n]\n");
+
+	doc->name = "synthetic-deep";
+	doc->data = text.data;
+	doc->size = text.size;
+}
+
+
+static void make_wide(doc_t* doc) {
+	// one large object, so its members are found through the index
+	text_t text = {NULL, 0, 0};
+	int i;
+
+	text_append(&text, "{");
+
+	for (i = 0; i < 100000; i++) {
+		text_append(&text, "%s\"member_%d\":{\"id\":%d,\"name\":\"item %d\",\"on\":%s}", i ? ",\n" : "\n", i, i, i, (i & 1) ? "true" : "false");
+	}
+
+	text_append(&text, "\n}\n");
+
+	doc->name = "synthetic-wide";
+	doc->data = text.data;
+	doc->size = text.size;
+}
+
+
+static void make_numeric(doc_t* doc) {
+	// integers, short decimals and full-precision doubles, as in coordinate and sensor data
+	text_t text = {NULL, 0, 0};
+	unsigned long seed = 12345;
+	int i;
+
+	text_append(&text, "[");
+
+	for (i = 0; i < 200000; i++) {
+		seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+
+		switch ( i % 3 ) {
+			case 0:
+				text_append(&text, "%s%ld", i ? "," : "", (long) (seed >> 33) - 0x40000000L);
+				break;
+
+			case 1:
+				text_append(&text, "%s%.3f", i ? "," : "", (double) (seed >> 40) / 1000.0);
+				break;
+
+			default:
+				text_append(&text, "%s%.17g", i ? "," : "", (double) (seed >> 11) / 9007199254740992.0 * 360.0 - 180.0);
+				break;
+		}
+	}
+
+	text_append(&text, "]\n");
+
+	doc->name = "synthetic-numeric";
+	doc->data = text.data;
+	doc->size = text.size;
+}
+
+
+static bool load_file(doc_t* doc, const char* path) {
+	FILE* file = fopen(path, "rb");
+	const char* name;
+	long size;
+
+	if ( !file ) {
+		return false;
+	}
+
+	fseek(file, 0, SEEK_END);
+	size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	// a directory opens on some systems, but can't be read
+	if ( size <= 0 ) {
+		fclose(file);
+		return false;
+	}
+
+	doc->data = (char*) checked_realloc(NULL, (size_t) size);
+	doc->size = fread(doc->data, 1, (size_t) size, file);
+	fclose(file);
+
+	if ( doc->size != (size_t) size ) {
+		free(doc->data);
+		return false;
+	}
+
+	name = strrchr(path, '/');
+	doc->name = name ? name + 1 : path;
+
+	return true;
+}
+
+
+static int source_func(void* buffer, int length, void* user_data) {
+	source_t* source = (source_t*) user_data;
+	size_t n = source->size - source->pos;
+
+	n = n < source->chunk ? n : source->chunk;
+	n = n < (size_t) length ? n : (size_t) length;
+
+	memcpy(buffer, source->data + source->pos, n);
+	source->pos += n;
+	source->calls++;
+
+	return (int) n;
+}
+
+
+static int sink_func(const void* buffer, int length, void* user_data) {
+	sink_t* sink = (sink_t*) user_data;
+
+	(void) buffer;
+	sink->bytes += length;
+	sink->calls++;
+
+	return length;
+}
+
+
+static void init_context(zetes_t* ctx) {
+	zetes_init(ctx, BENCH_STACK_DEPTH, g_arena, g_arena_size);
+	zetes_set_read_buffer(ctx, g_read_buffer, g_chunk);
+	zetes_set_write_buffer(ctx, g_write_buffer, sizeof(g_write_buffer));
+}
+
+
+static size_t arena_used(const zetes_t* ctx) {
+	return (size_t) ((char*) ctx->buffer_ptr - (char*) ctx->buffer_begin);
+}
+
+
+static zetes_result_t parse(zetes_t* ctx, const doc_t* doc) {
+	// the arena is a single buffer so that its use can be read off directly; it's doubled until
+	// the document fits
+	zetes_result_t result;
+
+	for (;;) {
+		init_context(ctx);
+		result = zetes_read_buffer(ctx, doc->data, doc->size);
+
+		if ( result != ZETES_RESULT_OUT_OF_MEMORY ) {
+			return result;
+		}
+
+		zetes_cleanup(ctx);
+		g_arena_size *= 2;
+		g_arena = checked_realloc(g_arena, g_arena_size);
+	}
+}
+
+
+static double run_read_buffer(zetes_t* ctx, const doc_t* doc, size_t iterations, result_t* result) {
+	double start = now_ns();
+	size_t i;
+
+	for (i = 0; i < iterations; i++) {
+		zetes_reset(ctx);
+		zetes_read_buffer(ctx, doc->data, doc->size);
+	}
+
+	result->arena = arena_used(ctx);
+	result->calls = 0;
+
+	return now_ns() - start;
+}
+
+
+static double run_read(zetes_t* ctx, const doc_t* doc, size_t iterations, result_t* result) {
+	source_t source = {doc->data, doc->size, 0, g_chunk, 0};
+	double start = now_ns();
+	size_t i;
+
+	for (i = 0; i < iterations; i++) {
+		source.pos = 0;
+		zetes_reset(ctx);
+		zetes_read(ctx, source_func, &source);
+	}
+
+	result->arena = arena_used(ctx);
+	result->calls = source.calls / iterations;
+
+	return now_ns() - start;
+}
+
+
+static double run_write_buffer(zetes_t* ctx, const doc_t* doc, size_t iterations, result_t* result) {
+	static char* output;
+	static size_t output_size;
+	size_t length = zetes_measure(ctx);
+	double start;
+	size_t i;
+
+	(void) doc;
+
+	if ( output_size < length + 1 ) {
+		output_size = length + 1;
+		output = (char*) checked_realloc(output, output_size);
+	}
+
+	start = now_ns();
+
+	for (i = 0; i < iterations; i++) {
+		zetes_write_buffer(ctx, output, output_size);
+	}
+
+	result->arena = arena_used(ctx);
+	result->calls = 0;
+	result->bytes = length;
+
+	return now_ns() - start;
+}
+
+
+static double run_write(zetes_t* ctx, const doc_t* doc, size_t iterations, result_t* result) {
+	sink_t sink = {0, 0};
+	double start = now_ns();
+	size_t i;
+
+	(void) doc;
+
+	for (i = 0; i < iterations; i++) {
+		zetes_write(ctx, sink_func, &sink);
+	}
+
+	result->arena = arena_used(ctx);
+	result->calls = sink.calls / iterations;
+	result->bytes = sink.bytes / iterations;
+
+	return now_ns() - start;
+}
+
+
+typedef double (*run_func_t) (zetes_t* ctx, const doc_t* doc, size_t iterations, result_t* result);
+
+
+static zetes_result_t measure(zetes_t* ctx, const doc_t* doc, run_func_t run, result_t* result) {
+	// calibrates a batch to a fraction of the time budget, then keeps the fastest of several
+	// batches, which is steadier than the mean for tracking regressions
+	size_t iterations = 1;
+	double elapsed;
+	int batch;
+
+	result->bytes = doc->size;
+
+	for (;;) {
+		elapsed = run(ctx, doc, iterations, result);
+
+		if ( zetes_result(ctx) != ZETES_RESULT_OK ) {
+			return zetes_result(ctx);
+		}
+
+		if ( elapsed >= g_min_time * 1e9 / BENCH_BATCHES ) {
+			break;
+		}
+
+		iterations *= 2;
+	}
+
+	result->ns = elapsed / iterations;
+	result->ops = iterations;
+
+	for (batch = 1; batch < BENCH_BATCHES; batch++) {
+		elapsed = run(ctx, doc, iterations, result) / iterations;
+
+		if ( elapsed < result->ns ) {
+			result->ns = elapsed;
+		}
+	}
+
+	result->ops = iterations * BENCH_BATCHES;
+
+	return zetes_result(ctx);
+}
+
+
+static void lookup_object(zetes_t* ctx, lookup_t* lookup) {
+	// the object is on top of the stack; its keys are collected first so only the lookups are timed
+	size_t size = zetes_object_size(ctx);
+	size_t base = lookup->count;
+	size_t round;
+	size_t i;
+	double start;
+
+	for (i = 0; i < size; i++) {
+		if ( lookup->count == lookup->capacity ) {
+			lookup->capacity = lookup->capacity ? lookup->capacity * 2 : 1024;
+			lookup->keys = (const char**) checked_realloc(lookup->keys, lookup->capacity * sizeof(*lookup->keys));
+			lookup->lengths = (size_t*) checked_realloc(lookup->lengths, lookup->capacity * sizeof(*lookup->lengths));
+		}
+
+		zetes_object_index(ctx, i);
+		lookup->keys[lookup->count] = zetes_pop_string_n(ctx, &lookup->lengths[lookup->count]);
+		lookup->count++;
+		zetes_pop(ctx);
+	}
+
+	start = now_ns();
+
+	for (round = 0; round < BENCH_LOOKUP_ROUNDS; round++) {
+		for (i = base; i < lookup->count; i++) {
+			zetes_object_get_n(ctx, lookup->keys[i], lookup->lengths[i]);
+			zetes_pop(ctx);
+		}
+	}
+
+	lookup->ns += now_ns() - start;
+	lookup->ops += size * BENCH_LOOKUP_ROUNDS;
+	lookup->count = base;
+}
+
+
+static void lookup_tree(zetes_t* ctx, lookup_t* lookup) {
+	zetes_type_t type = zetes_type(ctx);
+	size_t size;
+	size_t i;
+
+	if ( type == ZETES_TYPE_ARRAY ) {
+		size = zetes_array_size(ctx);
+
+		for (i = 0; i < size && zetes_ok(ctx); i++) {
+			zetes_array_index(ctx, i);
+			lookup_tree(ctx, lookup);
+			zetes_pop(ctx);
+		}
+	} else if ( type == ZETES_TYPE_OBJECT ) {
+		lookup_object(ctx, lookup);
+		size = zetes_object_size(ctx);
+
+		for (i = 0; i < size && zetes_ok(ctx); i++) {
+			zetes_object_index(ctx, i);
+			zetes_pop(ctx);
+			lookup_tree(ctx, lookup);
+			zetes_pop(ctx);
+		}
+	}
+}
+
+
+static zetes_result_t measure_lookup(zetes_t* ctx, const doc_t* doc, result_t* result) {
+	lookup_t lookup;
+
+	memset(&lookup, 0, sizeof(lookup));
+
+	if ( parse(ctx, doc) == ZETES_RESULT_OK ) {
+		lookup_tree(ctx, &lookup);
+	}
+
+	result->ns = lookup.ops ? lookup.ns / lookup.ops : 0.0;
+	result->ops = lookup.ops;
+	result->bytes = 0;
+	result->arena = arena_used(ctx);
+	result->calls = 0;
+
+	free(lookup.keys);
+	free(lookup.lengths);
+
+	return zetes_result(ctx);
+}
+
+
+static void report(const doc_t* doc, const char* op, const result_t* result) {
+	double mbps = result->bytes && result->ns > 0.0 ? (double) result->bytes / result->ns * 1e9 / 1e6 : 0.0;
+
+	switch ( g_format ) {
+		case FORMAT_CSV:
+			if ( g_first_row ) {
+				printf("doc,op,bytes,ops,ns_per_op,mb_per_s,arena_bytes,callbacks\n");
+			}
+
+			printf("%s,%s,%zu,%zu,%.1f,%.2f,%zu,%zu\n", doc->name, op, result->bytes, result->ops, result->ns, mbps, result->arena, result->calls);
+			break;
+
+		case FORMAT_JSON:
+			printf("{\"doc\":\"%s\",\"op\":\"%s\",\"bytes\":%zu,\"ops\":%zu,\"ns_per_op\":%.1f,\"mb_per_s\":%.2f,\"arena_bytes\":%zu,\"callbacks\":%zu}\n",
+				doc->name, op, result->bytes, result->ops, result->ns, mbps, result->arena, result->calls);
+			break;
+
+		default:
+			if ( g_first_row ) {
+				printf("%-20s %-14s %12s %14s %10s %12s %10s\n", "doc", "op", "bytes", "ns/op", "MB/s", "arena", "callbacks");
+			}
+
+			printf("%-20s %-14s %12zu %14.1f %10.2f %12zu %10zu\n", doc->name, op, result->bytes, result->ns, mbps, result->arena, result->calls);
+			break;
+	}
+
+	g_first_row = false;
+}
+
+
+static void bench(const doc_t* doc) {
+	static const struct {
+		const char* name;
+		run_func_t run;
+	} ops[] = {
+		{"read_buffer", run_read_buffer},
+		{"read", run_read},
+		{"write_buffer", run_write_buffer},
+		{"write", run_write}
+	};
+
+	zetes_t ctx;
+	result_t result;
+	zetes_result_t r = parse(&ctx, doc);
+	size_t i;
+
+	if ( r != ZETES_RESULT_OK ) {
+		fprintf(stderr, "zetes-bench: %s: parse failed (%d)\n", doc->name, (int) r);
+		zetes_cleanup(&ctx);
+		return;
+	}
+
+	for (i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+		// the write benchmarks need the tree, which the reads leave behind
+		r = measure(&ctx, doc, ops[i].run, &result);
+
+		if ( r != ZETES_RESULT_OK ) {
+			fprintf(stderr, "zetes-bench: %s: %s failed (%d)\n", doc->name, ops[i].name, (int) r);
+			continue;
+		}
+
+		report(doc, ops[i].name, &result);
+	}
+
+	zetes_cleanup(&ctx);
+
+	r = measure_lookup(&ctx, doc, &result);
+
+	if ( r == ZETES_RESULT_OK && result.ops ) {
+		report(doc, "object_get", &result);
+	}
+
+	zetes_cleanup(&ctx);
+}
+
+
+static void usage(void) {
+	fprintf(stderr,
+		"usage: zetes-bench [-f text|csv|json] [-t seconds] [-c chunk] [path...]\n"
+		"\n"
+		"Benchmarks each file named, or twitter.json, canada.json and citm_catalog.json\n"
+		"in each directory named, then the synthetic deep, wide and numeric documents.\n"
+		"-c sets the size of the chunks handed to zetes_read(), at most %d.\n", BENCH_CHUNK_SIZE);
+	exit(EXIT_FAILURE);
+}
+
+
+int main(int argc, char* argv[]) {
+	static const char* corpora[] = {"twitter.json", "canada.json", "citm_catalog.json"};
+	void (*synthetic[])(doc_t*) = {make_deep, make_wide, make_numeric};
+	char path[4096];
+	doc_t doc;
+	int i;
+	size_t j;
+
+	for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+		if ( i + 1 >= argc ) {
+			usage();
+		} else if ( strcmp(argv[i], "-f") == 0 ) {
+			i++;
+			g_format = strcmp(argv[i], "csv") == 0 ? FORMAT_CSV : strcmp(argv[i], "json") == 0 ? FORMAT_JSON : FORMAT_TEXT;
+		} else if ( strcmp(argv[i], "-t") == 0 ) {
+			g_min_time = atof(argv[++i]);
+		} else if ( strcmp(argv[i], "-c") == 0 ) {
+			g_chunk = (size_t) atol(argv[++i]);
+
+			if ( g_chunk == 0 || g_chunk > BENCH_CHUNK_SIZE ) {
+				usage();
+			}
+		} else {
+			usage();
+		}
+	}
+
+	g_arena_size = 1 << 20;
+	g_arena = checked_realloc(NULL, g_arena_size);
+
+	for (; i < argc; i++) {
+		if ( load_file(&doc, argv[i]) ) {
+			bench(&doc);
+			free(doc.data);
+			continue;
+		}
+
+		// not a readable file, so treat it as a directory holding the standard corpora
+		for (j = 0; j < sizeof(corpora) / sizeof(corpora[0]); j++) {
+			snprintf(path, sizeof(path), "%s/%s", argv[i], corpora[j]);
+
+			if ( load_file(&doc, path) ) {
+				doc.name = corpora[j];
+				bench(&doc);
+				free(doc.data);
+			} else {
+				fprintf(stderr, "zetes-bench: %s not found, skipped\n", path);
+			}
+		}
+	}
+
+	for (j = 0; j < sizeof(synthetic) / sizeof(synthetic[0]); j++) {
+		synthetic[j](&doc);
+		bench(&doc);
+		free(doc.data);
+	}
+
+	free(g_arena);
+
+	return EXIT_SUCCESS;
+}
@@ -1,4 +1,1225 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "zetes.h"
+
+
+#define CHECK(expr)				check((expr), #expr, __FILE__, __LINE__)
+
+
+static int g_failures;
+static char g_arena[1 << 20];
+static char g_output[1 << 16];
+
+
+static void check(bool passed, const char* expr, const char* file, int line) {
+	if ( !passed ) {
+		fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expr);
+		g_failures++;
+	}
+}
+
+
+static const char* write_string(zetes_t* ctx) {
+	// the value on top of the stack as JSON, or an empty string if it can't be written
+	size_t length = zetes_measure(ctx);
+
+	if ( length >= sizeof(g_output) || zetes_write_buffer(ctx, g_output, sizeof(g_output)) != ZETES_RESULT_OK ) {
+		length = 0;
+	}
+
+	g_output[length] = '\0';
+
+	return g_output;
+}
+
+
+static const char* events_string(zetes_t* ctx) {
+	// the remaining events in a compact form, with the depth after each container event
+	static char trace[4096];
+	size_t length = 0;
+	zetes_event_t event;
+
+	trace[0] = '\0';
+
+	while ( (event = zetes_next_event(ctx)) != ZETES_EVENT_NONE && event != ZETES_EVENT_END && length < sizeof(trace) - 256 ) {
+		size_t n = 0;
+		const char* str;
+
+		switch ( event ) {
+			case ZETES_EVENT_OBJECT_BEGIN:
+			case ZETES_EVENT_ARRAY_BEGIN:
+				length += snprintf(trace + length, sizeof(trace) - length, "%c%zu ", event == ZETES_EVENT_OBJECT_BEGIN ? '{' : '[', zetes_event_depth(ctx));
+				break;
+
+			case ZETES_EVENT_OBJECT_END:
+			case ZETES_EVENT_ARRAY_END:
+				length += snprintf(trace + length, sizeof(trace) - length, "%c%zu ", event == ZETES_EVENT_OBJECT_END ? '}' : ']', zetes_event_depth(ctx));
+				break;
+
+			case ZETES_EVENT_KEY:
+				str = zetes_event_string_n(ctx, &n);
+				length += snprintf(trace + length, sizeof(trace) - length, "%.*s: ", (int) n, str);
+				break;
+
+			default:
+				zetes_push_event_value(ctx);
+				length += snprintf(trace + length, sizeof(trace) - length, "%s ", write_string(ctx));
+				zetes_pop(ctx);
+				break;
+		}
+	}
+
+	if ( length > 0 ) {
+		trace[length - 1] = '\0';
+	}
+
+	return trace;
+}
+
+
+static const char* events_of(const char* json) {
+	zetes_t ctx;
+
+	zetes_init(&ctx, 8, g_arena, sizeof(g_arena));
+	zetes_begin_events_buffer(&ctx, json, strlen(json));
+
+	return events_string(&ctx);
+}
+
+
+static void test_events(void) {
+	zetes_t ctx;
+	zetes_event_t event;
+	size_t n;
+
+	CHECK(strcmp(events_of("{\"a\":1,\"b\":[true,null,\"x\"],\"c\":{}}"), "{1 a: 1 b: [2 true null \"x\" ]1 c: {2 }1 }0") == 0);
+	CHECK(strcmp(events_of(" [ [ ] , { } , -1.5e3 ] "), "[1 [2 ]1 {2 }1 -1500 ]0") == 0);
+	CHECK(strcmp(events_of("\"top\""), "\"top\"") == 0);
+
+	// keys and strings come out unescaped
+	zetes_init(&ctx, 8, g_arena, sizeof(g_arena));
+	zetes_begin_events_buffer(&ctx, "{\"k\\u00e9y\":\"a\\nb\"}", 20);
+	CHECK(zetes_next_event(&ctx) == ZETES_EVENT_OBJECT_BEGIN);
+	CHECK(zetes_next_event(&ctx) == ZETES_EVENT_KEY);
+	CHECK(strcmp(zetes_event_string_n(&ctx, &n), "k\xc3\xa9y") == 0 && n == 4);
+	CHECK(zetes_next_event(&ctx) == ZETES_EVENT_VALUE);
+	CHECK(zetes_event_type(&ctx) == ZETES_TYPE_STRING);
+	CHECK(strcmp(zetes_event_string_n(&ctx, &n), "a\nb") == 0 && n == 3);
+	CHECK(zetes_next_event(&ctx) == ZETES_EVENT_OBJECT_END);
+	CHECK(zetes_next_event(&ctx) == ZETES_EVENT_END);
+	CHECK(zetes_result(&ctx) == ZETES_RESULT_OK);
+
+	// malformed input stops the events with the error
+	zetes_init(&ctx, 8, g_arena, sizeof(g_arena));
+	zetes_begin_events_buffer(&ctx, "[1,]", 4);
+	CHECK(strcmp(events_string(&ctx), "[1 1") == 0);
+	CHECK(zetes_result(&ctx) != ZETES_RESULT_OK);
+
+	zetes_init(&ctx, 8, g_arena, sizeof(g_arena));
+	zetes_begin_events_buffer(&ctx, "{\"a\" 1}", 7);
+	events_string(&ctx);
+	CHECK(zetes_result(&ctx) != ZETES_RESULT_OK);
+
+	zetes_init(&ctx, 8, g_arena, sizeof(g_arena));
+	zetes_begin_events_buffer(&ctx, "[1] 2", 5);
+	events_string(&ctx);
+	CHECK(zetes_result(&ctx) != ZETES_RESULT_OK);
+
+	// a string value is no key
+	zetes_init(&ctx, 8, g_arena, sizeof(g_arena));
+	zetes_begin_events_buffer(&ctx, "[\"a\"]", 5);
+	event = zetes_next_event(&ctx);
+	event = zetes_next_event(&ctx);
+	CHECK(event == ZETES_EVENT_VALUE);
+	CHECK(zetes_event_type(&ctx) == ZETES_TYPE_STRING);
+}
+
+
+static void test_event_depth_limit(void) {
+	zetes_t ctx;
+
+	zetes_init(&ctx, 8, g_arena, sizeof(g_arena));
+	zetes_set_max_depth(&ctx, 3);
+	zetes_begin_events_buffer(&ctx, "[[[1]]]", 7);
+	CHECK(strcmp(events_string(&ctx), "[1 [2 [3 1 ]2 ]1 ]0") == 0);
+	CHECK(zetes_result(&ctx) == ZETES_RESULT_OK);
+
+	zetes_init(&ctx, 8, g_arena, sizeof(g_arena));
+	zetes_set_max_depth(&ctx, 3);
+	zetes_begin_events_buffer(&ctx, "[[{\"a\":[1]}]]", 13);
+	CHECK(strcmp(events_string(&ctx), "[1 [2 {3 a:") == 0);
+	CHECK(zetes_result(&ctx) == ZETES_RESULT_NESTING_TOO_DEEP);
+
+	// the same limit applies when building a tree
+	zetes_init(&ctx, 8, g_arena, sizeof(g_arena));
+	zetes_set_max_depth(&ctx, 3);
+	CHECK(zetes_read_buffer(&ctx, "[[[[1]]]]", 9) == ZETES_RESULT_NESTING_TOO_DEEP);
+
+	// and a limit beyond ZETES_MAX_DEPTH takes its nesting bits from the arena; open containers
+	// are held on the value stack, which needs to be as deep
+	zetes_init(&ctx, 2 * ZETES_MAX_DEPTH + 200, g_arena, sizeof(g_arena));
+	zetes_set_max_depth(&ctx, ZETES_MAX_DEPTH + 100);
+	{
+		static char deep[2 * (ZETES_MAX_DEPTH + 100) + 1];
+
+		memset(deep, '[', ZETES_MAX_DEPTH + 100);
+		memset(deep + ZETES_MAX_DEPTH + 100, ']', ZETES_MAX_DEPTH + 100);
+		CHECK(zetes_read_buffer(&ctx, deep, sizeof(deep) - 1) == ZETES_RESULT_OK);
+		zetes_reset(&ctx);
+		deep[0] = ' ';
+		CHECK(zetes_read_buffer(&ctx, deep, sizeof(deep) - 1) != ZETES_RESULT_OK);
+	}
+
+	zetes_init(&ctx, 2 * ZETES_MAX_DEPTH + 200, g_arena, sizeof(g_arena));
+	{
+		static char deep[2 * (ZETES_MAX_DEPTH + 1)];
+
+		memset(deep, '[', ZETES_MAX_DEPTH + 1);
+		memset(deep + ZETES_MAX_DEPTH + 1, ']', ZETES_MAX_DEPTH + 1);
+		CHECK(zetes_read_buffer(&ctx, deep, sizeof(deep)) == ZETES_RESULT_NESTING_TOO_DEEP);
+	}
+}
+
+
+static void test_event_skip(void) {
+	zetes_t ctx;
+	size_t n;
+
+	// skipping a key skips its value, however deep
+	zetes_init(&ctx, 8, g_arena, sizeof(g_arena));
+	zetes_begin_events_buffer(&ctx, "{\"a\":[1,{\"b\":[2]},3],\"c\":4,\"d\":5}", 33);
+	CHECK(zetes_next_event(&ctx) == ZETES_EVENT_OBJECT_BEGIN);
+	CHECK(zetes_next_event(&ctx) == ZETES_EVENT_KEY);
+	zetes_skip_event(&ctx);
+	CHECK(zetes_event_depth(&ctx) == 1);
+	CHECK(zetes_next_event(&ctx) == ZETES_EVENT_KEY);
+	CHECK(strcmp(zetes_event_string_n(&ctx, &n), "c") == 0);
+	zetes_skip_event(&ctx);
+	CHECK(strcmp(events_string(&ctx), "d: 5 }0") == 0);
+	CHECK(zetes_result(&ctx) == ZETES_RESULT_OK);
+
+	// skipping a container begin leaves the reader after its end
+	zetes_init(&ctx, 8, g_arena, sizeof(g_arena));
+	zetes_begin_events_buffer(&ctx, "[[1,[2]],{\"x\":[]},\"y\"]", 22);
+	CHECK(zetes_next_event(&ctx) == ZETES_EVENT_ARRAY_BEGIN);
+	CHECK(zetes_next_event(&ctx) == ZETES_EVENT_ARRAY_BEGIN);
+	zetes_skip_event(&ctx);
+	CHECK(zetes_next_event(&ctx) == ZETES_EVENT_OBJECT_BEGIN);
+	zetes_skip_event(&ctx);
+	CHECK(strcmp(events_string(&ctx), "\"y\" ]0") == 0);
+
+	// skipping a scalar does nothing more
+	zetes_init(&ctx, 8, g_arena, sizeof(g_arena));
+	zetes_begin_events_buffer(&ctx, "[1,2]", 5);
+	CHECK(zetes_next_event(&ctx) == ZETES_EVENT_ARRAY_BEGIN);
+	CHECK(zetes_next_event(&ctx) == ZETES_EVENT_VALUE);
+	zetes_skip_event(&ctx);
+	CHECK(strcmp(events_string(&ctx), "2 ]0") == 0);
+
+	// skipped containers are still checked
+	zetes_init(&ctx, 8, g_arena, sizeof(g_arena));
+	zetes_begin_events_buffer(&ctx, "[[1,,2],3]", 10);
+	CHECK(zetes_next_event(&ctx) == ZETES_EVENT_ARRAY_BEGIN);
+	CHECK(zetes_next_event(&ctx) == ZETES_EVENT_ARRAY_BEGIN);
+	zetes_skip_event(&ctx);
+	CHECK(zetes_result(&ctx) != ZETES_RESULT_OK);
+}
+
+
+static bool parses_as(const char* json, double expected) {
+	zetes_t ctx;
+	double value;
+
+	zetes_init(&ctx, 8, g_arena, sizeof(g_arena));
+
+	if ( zetes_read_buffer(&ctx, json, strlen(json)) != ZETES_RESULT_OK ) {
+		return false;
+	}
+
+	value = zetes_pop_number(&ctx);
+
+	return memcmp(&value, &expected, sizeof(value)) == 0;
+}
+
+
+static void test_numbers(void) {
+	// when more than 19 digits are given the rest still decide the rounding, including just either
+	// side of a halfway point and past the digits kept in full
+	static const char* const NUMBERS[] = {
+		"9007199254740993.0000000000000000001",
+		"9007199254740993.0000000000000000000",
+		"9007199254740992.9999999999999999999",
+		"1.00000000000000011102230246251565404236316680908203125001",
+		"1.00000000000000011102230246251565404236316680908203125",
+		"1.00000000000000011102230246251565404236316680908203124999",
+		"2.4703282292062327208828439643411068618252990130716238221279284125033775363e-324",
+		"2.4703282292062327208828439643411068618252990130716238221279284125033775364e-324",
+		"1.7976931348623158079372897140530341507993413271003782693617377898044496829275e308",
+		"1.7976931348623158079372897140530341507993413271003782693617377898044496829276e308",
+		"123456789012345678901234567890e-10",
+		"0.1000000000000000055511151231257827021181583404541015625",
+		"7.2057594037927933e16",
+		"12345678901234567890123456789012345678901234567890"
+	};
+
+	static const char SHORT_FORM[] = "[{\"a\":\"b\"},1.0000000000000002,[2]]";
+	static const char LONG_FORM[] = "[{\"a\":\"b\"},1.00000000000000011102230246251565404236316680908203125001,[2]]";
+	static char halfway[1000];
+	char expected[64];
+	zetes_t ctx;
+	size_t i;
+
+	for (i = 0; i < sizeof(NUMBERS) / sizeof(NUMBERS[0]); i++) {
+		CHECK(parses_as(NUMBERS[i], strtod(NUMBERS[i], NULL)));
+	}
+
+	// 1 + 2^-53, the halfway point after 1.0, then hundreds of zeros before a deciding digit
+	strcpy(halfway, "1.00000000000000011102230246251565404236316680908203125");
+	memset(halfway + strlen(halfway), '0', 900);
+	strcpy(halfway + 955, "1");
+	CHECK(parses_as(halfway, 1.0000000000000002));
+	halfway[955] = '\0';
+	CHECK(parses_as(halfway, 1.0));
+
+	// the digits past those kept in full go in free arena space only while the number is lexed,
+	// so the values around one in a container are read as they would be otherwise
+	zetes_init(&ctx, 8, g_arena, sizeof(g_arena));
+	zetes_read_buffer(&ctx, SHORT_FORM, sizeof(SHORT_FORM) - 1);
+	strcpy(expected, write_string(&ctx));
+	zetes_init(&ctx, 8, g_arena, sizeof(g_arena));
+	zetes_read_buffer(&ctx, LONG_FORM, sizeof(LONG_FORM) - 1);
+	CHECK(strcmp(write_string(&ctx), expected) == 0);
+}
+
+
+static void test_object_set(void) {
+	// new keys are appended and existing ones overwritten, with and without interning, and on
+	// either side of the index threshold
+	int interning;
+
+	for (interning = 0; interning < 2; interning++) {
+		zetes_t ctx;
+		char key[16];
+		int i;
+
+		zetes_init(&ctx, 8, g_arena, sizeof(g_arena));
+
+		if ( interning ) {
+			zetes_enable_interning(&ctx, 64);
+		}
+
+		CHECK(zetes_read_buffer(&ctx, "{\"a\":1}", 7) == ZETES_RESULT_OK);
+
+		for (i = 0; i < 40; i++) {
+			snprintf(key, sizeof(key), "k%d", i % 20);
+			zetes_push_int(&ctx, i);
+			zetes_object_set(&ctx, key);
+		}
+
+		zetes_push_string(&ctx, "b");
+		zetes_object_set(&ctx, "a");
+
+		CHECK(zetes_object_size(&ctx) == 21);
+		zetes_object_get(&ctx, "k7");
+		CHECK(zetes_pop_int(&ctx) == 27);
+		zetes_object_get(&ctx, "a");
+		CHECK(strcmp(zetes_pop_string(&ctx), "b") == 0);
+		CHECK(strncmp(write_string(&ctx), "{\"a\":\"b\",\"k0\":20,\"k1\":21,", 25) == 0);
+		CHECK(zetes_result(&ctx) == ZETES_RESULT_OK);
+	}
+}
+
+
+static void test_key_prefix(void) {
+	// a key given by the same pointer as a member's still has to be the same length
+	static char doc[] = "{\"abc\":1}";
+	const char* interned;
+	zetes_t ctx;
+
+	zetes_init(&ctx, 8, g_arena, sizeof(g_arena));
+	CHECK(zetes_read_insitu(&ctx, doc, sizeof(doc) - 1) == ZETES_RESULT_OK);
+	CHECK(zetes_object_has_n(&ctx, doc + 2, 3));
+	CHECK(!zetes_object_has_n(&ctx, doc + 2, 1));
+
+	zetes_init(&ctx, 8, g_arena, sizeof(g_arena));
+	zetes_enable_interning(&ctx, 16);
+	interned = zetes_intern(&ctx, "abc");
+	CHECK(zetes_read_buffer(&ctx, "{\"abc\":1}", 9) == ZETES_RESULT_OK);
+	CHECK(zetes_object_has_n(&ctx, interned, 3));
+	CHECK(!zetes_object_has_n(&ctx, interned, 2));
+}
+
+
+static const char* const DOCUMENTS[] = {
+	"{\"a\":1,\"b\":[true,false,null],\"c\":{\"d\":\"e\"}}",
+	"[1.5,-0,1e300,-2.5e-300,12345678901234567890,-9223372036854775808,0.1]",
+	"  {\"long string\" : \"abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz\",\n\t\"k\":[[],{},[[]]]}  ",
+	"\"\\u00e9\\u20ac\\ud83d\\ude00\\n\\\"\\\\\\/\"",
+	"[\"a\",\"b\",\"c\",\"d\",\"e\",\"f\",\"g\",\"h\",\"i\",\"j\",\"k\",\"l\",\"m\",\"n\",\"o\",\"p\",\"q\",\"r\"]",
+	"{\"k00\":0,\"k01\":1,\"k02\":2,\"k03\":3,\"k04\":4,\"k05\":5,\"k06\":6,\"k07\":7,\"k08\":8,\"k09\":9,"
+		"\"k10\":10,\"k11\":11,\"k12\":12,\"k13\":13,\"k14\":14,\"k15\":15,\"k16\":16,\"k17\":{\"x\":[1,2,3]}}",
+	"true",
+	"-12.75e-1",
+	"[1,]",
+	"{\"a\" 1}",
+	"[\"unterminated",
+	"[1] 2",
+	"{\"a\":[1,2}"
+};
+
+
+static void test_feed_matches_read(void) {
+	// every way of cutting a document into chunks gives the same tree, or the same error; the
+	// chunks after the document are fed too, as only whitespace may follow it
+	size_t i;
+
+	for (i = 0; i < sizeof(DOCUMENTS) / sizeof(DOCUMENTS[0]); i++) {
+		const char* json = DOCUMENTS[i];
+		size_t length = strlen(json);
+		static char expected[4096];
+		zetes_result_t expected_result;
+		zetes_t ctx;
+		size_t chunk;
+
+		zetes_init(&ctx, 8, g_arena, sizeof(g_arena));
+		expected_result = zetes_read_buffer(&ctx, json, length);
+		strcpy(expected, expected_result == ZETES_RESULT_OK ? write_string(&ctx) : "");
+
+		for (chunk = 1; chunk <= length; chunk++) {
+			zetes_result_t result = ZETES_RESULT_NEED_MORE;
+			size_t pos = 0;
+
+			zetes_init(&ctx, 8, g_arena, sizeof(g_arena));
+
+			while ( pos < length && (result == ZETES_RESULT_NEED_MORE || result == ZETES_RESULT_OK) ) {
+				size_t n = length - pos < chunk ? length - pos : chunk;
+
+				result = zetes_feed(&ctx, json + pos, n);
+				pos += n;
+			}
+
+			if ( result == ZETES_RESULT_NEED_MORE || result == ZETES_RESULT_OK ) {
+				result = zetes_feed(&ctx, "", 0);
+			}
+
+			CHECK(result == expected_result);
+
+			if ( result == ZETES_RESULT_OK && expected_result == ZETES_RESULT_OK ) {
+				CHECK(strcmp(write_string(&ctx), expected) == 0);
+			}
+		}
+	}
+}
+
+
+static void test_write_full_arena(void) {
+	// writing allocates nothing, so a document read into an arena just big enough for it must still write
+	static const char json[] = "{\"a\":[1,2,[3,{\"b\":[]}]],\"c\":{\"d\":\"e\",\"f\":[[[true]]]},\"g\":null}";
+	static char deep[2 * (ZETES_MAX_DEPTH + 100) + 1];
+	size_t depth = ZETES_MAX_DEPTH + 100;
+	size_t size;
+
+	for (size = 64; size < sizeof(g_arena); size += 8) {
+		zetes_t ctx;
+
+		if ( zetes_init(&ctx, 64, g_arena, size) == ZETES_RESULT_OK &&
+				zetes_read_buffer(&ctx, json, sizeof(json) - 1) == ZETES_RESULT_OK ) {
+			CHECK(zetes_measure(&ctx) == sizeof(json) - 1);
+			CHECK(strcmp(write_string(&ctx), json) == 0);
+			break;
+		}
+	}
+
+	CHECK(size < sizeof(g_arena));
+
+	// the same beyond ZETES_MAX_DEPTH, where the value stack deep enough to read it holds the frames
+	memset(deep, '[', depth);
+	deep[depth] = '0';
+	memset(deep + depth + 1, ']', depth);
+
+	for (size = 1024; size < sizeof(g_arena); size += 64) {
+		zetes_t ctx;
+
+		if ( zetes_init(&ctx, depth + 1, g_arena, size) != ZETES_RESULT_OK ) {
+			continue;
+		}
+
+		zetes_set_max_depth(&ctx, depth);
+
+		if ( zetes_read_buffer(&ctx, deep, sizeof(deep)) == ZETES_RESULT_OK ) {
+			CHECK(zetes_measure(&ctx) == sizeof(deep));
+			CHECK(strncmp(write_string(&ctx), deep, sizeof(deep)) == 0);
+			break;
+		}
+	}
+
+	CHECK(size < sizeof(g_arena));
+}
+
+
+static void test_rollback_writer(void) {
+	// a streaming write abandoned by a rollback leaves the writer idle, as it is after zetes_init()
+	static char buffer[64];
+	zetes_t idle;
+	zetes_t ctx;
+	zetes_mark_t mark;
+	size_t length = 0;
+
+	zetes_init(&idle, 4, g_arena, sizeof(g_arena) / 2);
+	zetes_init(&ctx, 4, g_arena + sizeof(g_arena) / 2, sizeof(g_arena) / 2);
+	mark = zetes_mark(&ctx);
+	zetes_writer_begin_buffer(&ctx, buffer, sizeof(buffer));
+	zetes_writer_begin_array(&ctx);
+	zetes_rollback(&ctx, mark);
+	CHECK(ctx.writer.state == idle.writer.state);
+
+	zetes_writer_begin_buffer(&ctx, buffer, sizeof(buffer));
+	zetes_writer_int(&ctx, 1);
+	CHECK(zetes_writer_finish(&ctx, &length) == ZETES_RESULT_OK && length == 1 && buffer[0] == '1');
+}
+
+
+static int g_live_allocations;
+
+
+static void* counting_alloc(size_t size, void* user_data) {
+	(void) user_data;
+	g_live_allocations++;
+
+	return malloc(size);
+}
+
+
+static void counting_free(void* ptr, size_t size, void* user_data) {
+	(void) size;
+	(void) user_data;
+	g_live_allocations--;
+	free(ptr);
+}
+
+
+static void test_extract_bad_path(void) {
+	// a malformed escape fails the extraction without keeping the memory the paths were decoded into
+	static const char json[] = "{\"a\":{\"b\":1},\"c\":2}";
+	static const char* const paths[] = {"/c", "/a~2"};
+	zetes_t ctx;
+	void* end;
+
+	zetes_init(&ctx, 16, g_arena, sizeof(g_arena));
+	zetes_begin_events_buffer(&ctx, json, sizeof(json) - 1);
+	end = ctx.buffer_end;
+	zetes_extract(&ctx, paths, 2);
+	CHECK(ctx.result == ZETES_RESULT_INVALID_PATH);
+	CHECK(ctx.buffer_end == end);
+
+	zetes_reset(&ctx);
+	zetes_begin_events_buffer(&ctx, json, sizeof(json) - 1);
+	zetes_extract(&ctx, paths, 1);
+	CHECK(strcmp(write_string(&ctx), "{\"\\/c\":2}") == 0);
+
+	zetes_init(&ctx, 16, g_arena, 256);
+	zetes_set_allocator(&ctx, counting_alloc, counting_free, NULL);
+	zetes_begin_events_buffer(&ctx, json, sizeof(json) - 1);
+	zetes_extract(&ctx, paths, 2);
+	CHECK(ctx.result == ZETES_RESULT_INVALID_PATH);
+	zetes_cleanup(&ctx);
+	CHECK(g_live_allocations == 0);
+}
+
+
+static void test_write_no_alloc(void) {
+	// writing takes no arena space for a tree that was read, so an allocator is never called for it
+	static const char json[] = "[[[[[[[[[[[[[[[[[[[[{\"a\":[1,{\"b\":2}]}]]]]]]]]]]]]]]]]]]]]";
+	static char buffer[256];
+	zetes_t ctx;
+	size_t length;
+	int live;
+
+	zetes_init(&ctx, 64, g_arena, 2048);
+	zetes_set_allocator(&ctx, counting_alloc, counting_free, NULL);
+	CHECK(zetes_read_buffer(&ctx, json, sizeof(json) - 1) == ZETES_RESULT_OK);
+	live = g_live_allocations;
+
+	CHECK(zetes_measure(&ctx) == sizeof(json) - 1);
+	CHECK(zetes_write_buffer(&ctx, buffer, sizeof(buffer)) == ZETES_RESULT_OK);
+	CHECK(memcmp(buffer, json, sizeof(json) - 1) == 0);
+	zetes_writer_begin_buffer(&ctx, buffer, sizeof(buffer));
+	zetes_writer_value(&ctx);
+	CHECK(zetes_writer_finish(&ctx, &length) == ZETES_RESULT_OK && length == sizeof(json) - 1);
+	CHECK(g_live_allocations == live);
+
+	zetes_cleanup(&ctx);
+	CHECK(g_live_allocations == 0);
+}
+
+
+static void test_read_lazy(void) {
+	// deferred containers are written out as their source text, so that must reject whatever
+	// zetes_read_buffer() does and write the rest the same way
+	static const char* const documents[] = {
+		"[1,]", "{\"a\"}", "{,}", "{\"a\":[1,,2]}", "[1 2]", "{\"a\":{\"b\":[true false]}}", "[[1],[2]",
+		"[\"x\" ]", "{\"a\":1,}", "[01]", "[\"\\q\"]", "{\"a\":[\"b c\"]}[]",
+		" { \"a\" : [ 1 , { \"b\" : \" x y \" } , [ ] ] , \"c\" : null } ", "[\"\xff\"]", "[\"\xc3\xa9/\\n\"]", "[]",
+	};
+	static const char SOURCE_TEXT[] = "[1e400,\"\\u00e9\"]";
+	static char expected[4096];
+	size_t length;
+	zetes_t ctx;
+	size_t i;
+
+	for (i = 0; i < sizeof(documents) / sizeof(documents[0]); i++) {
+		const char* json = documents[i];
+		zetes_result_t read_result;
+		zetes_result_t write_result;
+
+		zetes_init(&ctx, 16, g_arena, sizeof(g_arena));
+		read_result = zetes_read_buffer(&ctx, json, strlen(json));
+		strcpy(expected, write_string(&ctx));
+		write_result = ctx.result;
+
+		// an error within a container surfaces when it's written out, or when it's resolved
+		zetes_init(&ctx, 16, g_arena, sizeof(g_arena));
+		zetes_read_lazy(&ctx, json, strlen(json));
+		CHECK(strcmp(write_string(&ctx), expected) == 0);
+		CHECK(ctx.result == write_result);
+
+		zetes_init(&ctx, 16, g_arena, sizeof(g_arena));
+		zetes_read_lazy(&ctx, json, strlen(json));
+		zetes_snapshot(&ctx, NULL, 0, &length);
+		CHECK(ctx.result == read_result);
+	}
+
+	// unresolved, numbers and escapes are copied as they were written
+	zetes_init(&ctx, 16, g_arena, sizeof(g_arena));
+	zetes_read_lazy(&ctx, SOURCE_TEXT, sizeof(SOURCE_TEXT) - 1);
+	CHECK(strcmp(write_string(&ctx), SOURCE_TEXT) == 0);
+}
+
+
+typedef struct {
+	const char* data;
+	size_t length;
+	size_t pos;
+	size_t chunk;
+} source_t;
+
+
+static int read_source(void* buffer, int length, void* user_data) {
+	// at most chunk bytes at a time
+	source_t* source = (source_t*) user_data;
+	size_t n = source->length - source->pos;
+
+	if ( n > source->chunk ) {
+		n = source->chunk;
+	}
+
+	if ( n > (size_t) length ) {
+		n = (size_t) length;
+	}
+
+	memcpy(buffer, source->data + source->pos, n);
+	source->pos += n;
+
+	return (int) n;
+}
+
+
+static void test_validate(void) {
+	// an error is reported at the offset of the byte at fault however the input is read, strings
+	// must be well formed UTF-8, and a NUL is a character like any other
+	static const struct {
+		const char* json;
+		size_t length;
+		zetes_result_t result;
+		size_t offset;
+	} CASES[] = {
+		{"{\"a\":[1,{\"b\":null}],\"c\":\"\xf0\x9f\x98\x80\"}", 31, ZETES_RESULT_OK, 0},
+		{"[1,]", 4, ZETES_RESULT_SYNTAX_ERROR, 3},
+		{"{\"a\" 1}", 7, ZETES_RESULT_SYNTAX_ERROR, 5},
+		{"[01]", 4, ZETES_RESULT_SYNTAX_ERROR, 2},
+		{"{\"a\":1,\"b\":[true,fals]}", 23, ZETES_RESULT_UNKNOWN_KEYWORD, 17},
+		{"  [", 3, ZETES_RESULT_SYNTAX_ERROR, 3},
+		{"[1] x", 5, ZETES_RESULT_INVALID_CHARACTER, 4},
+		{"[\"\xff\"]", 5, ZETES_RESULT_INVALID_STRING, 2},
+		{"[\"\xc3\x28\"]", 6, ZETES_RESULT_INVALID_STRING, 2},
+		{"[\"\xc0\xaf\"]", 6, ZETES_RESULT_INVALID_STRING, 2},
+		{"[\"\xed\xa0\x80\"]", 7, ZETES_RESULT_INVALID_STRING, 2},
+		{"[\"a\0b\"]", 7, ZETES_RESULT_INVALID_CHARACTER, 3},
+		{"[1]\0", 4, ZETES_RESULT_INVALID_CHARACTER, 3},
+	};
+
+	zetes_t ctx;
+	size_t i;
+
+	for (i = 0; i < sizeof(CASES) / sizeof(CASES[0]); i++) {
+		size_t offset = 0;
+		size_t chunk;
+
+		CHECK(zetes_validate_buffer(CASES[i].json, CASES[i].length, &offset) == CASES[i].result);
+		CHECK(CASES[i].result == ZETES_RESULT_OK || offset == CASES[i].offset);
+
+		for (chunk = 1; chunk <= 5; chunk++) {
+			source_t source = {CASES[i].json, CASES[i].length, 0, chunk};
+			char window[4];
+
+			offset = 0;
+			CHECK(zetes_validate(read_source, &source, window, sizeof(window), &offset) == CASES[i].result);
+			CHECK(CASES[i].result == ZETES_RESULT_OK || offset == CASES[i].offset);
+		}
+	}
+
+	// the reader takes a string's bytes as they are, only the validator insists on UTF-8
+	zetes_init(&ctx, 8, g_arena, sizeof(g_arena));
+	CHECK(zetes_read_buffer(&ctx, CASES[7].json, CASES[7].length) == ZETES_RESULT_OK);
+}
+
+
+static const char* documents_string(zetes_t* ctx, bool reset) {
+	// each document zetes_read_next() reads, written out and separated by spaces, then the result
+	static char documents[1024];
+	size_t length = 0;
+
+	while ( zetes_read_next(ctx) ) {
+		length += (size_t) snprintf(documents + length, sizeof(documents) - length, "%s ", write_string(ctx));
+
+		if ( reset ) {
+			zetes_reset(ctx);
+			CHECK(ctx->buffer_ptr == ctx->buffer_base);
+		} else {
+			zetes_pop(ctx);
+		}
+	}
+
+	snprintf(documents + length, sizeof(documents) - length, "%d", (int) zetes_result(ctx));
+
+	return documents;
+}
+
+
+static void test_read_next(void) {
+	// documents need nothing between them where they can't run together, a top level number ends at
+	// whatever can't continue it, and the stream carries on across a zetes_reset()
+	static const char* const CASES[][2] = {
+		{"[1][2]{}", "[1] [2] {} 1"},
+		{"1 2\t3\n", "1 2 3 1"},
+		{"[1]2[3]", "[1] 2 [3] 1"},
+		{"\"a\"\"b\"-1.5e1true", "\"a\" \"b\" -15 true 1"},
+		{"12", "12 1"},
+		{"[1]\n\n{\"a\":2}\n", "[1] {\"a\":2} 1"},
+		{"[1] x", "[1] 11"},
+		{"[1] [2", "[1] 16"},
+		{"", "1"},
+	};
+
+	size_t i;
+
+	for (i = 0; i < sizeof(CASES) / sizeof(CASES[0]); i++) {
+		const char* json = CASES[i][0];
+		int reset;
+
+		for (reset = 0; reset < 2; reset++) {
+			source_t source = {json, strlen(json), 0, 2};
+			zetes_t ctx;
+
+			zetes_init(&ctx, 8, g_arena, sizeof(g_arena));
+			zetes_begin_documents_buffer(&ctx, json, strlen(json));
+			CHECK(strcmp(documents_string(&ctx, reset), CASES[i][1]) == 0);
+
+			zetes_init(&ctx, 8, g_arena, sizeof(g_arena));
+			zetes_set_read_buffer(&ctx, NULL, 8);
+			zetes_begin_documents(&ctx, read_source, &source);
+			CHECK(strcmp(documents_string(&ctx, reset), CASES[i][1]) == 0);
+		}
+	}
+}
+
+
+static void test_split_documents(void) {
+	// of newline delimited documents, every chunk but the first starts just past a newline, and reading
+	// the chunks one by one gives the documents reading the whole buffer does
+	static const char json[] = "[1]\n{\"a\":\"b\\n\"}\n[2, 3]\n4\n\n\"x\"";
+	static char expected[1024];
+	char documents[1024];
+	size_t offsets[8];
+	size_t count;
+	zetes_t ctx;
+
+	zetes_init(&ctx, 8, g_arena, sizeof(g_arena));
+	zetes_begin_documents_buffer(&ctx, json, sizeof(json) - 1);
+	strcpy(expected, documents_string(&ctx, false));
+
+	for (count = 1; count <= 8; count++) {
+		size_t chunks = zetes_split_documents(json, sizeof(json) - 1, offsets, count);
+		size_t length = 0;
+		size_t i;
+
+		CHECK(chunks >= 1 && chunks <= count && offsets[0] == 0);
+
+		for (i = 0; i < chunks; i++) {
+			size_t end = i + 1 < chunks ? offsets[i + 1] : sizeof(json) - 1;
+			const char* rest;
+
+			CHECK(i == 0 || (offsets[i] > offsets[i - 1] && json[offsets[i] - 1] == '\n'));
+
+			zetes_init(&ctx, 8, g_arena, sizeof(g_arena));
+			zetes_begin_documents_buffer(&ctx, json + offsets[i], end - offsets[i]);
+			rest = documents_string(&ctx, false);
+
+			// all but the result of reading each chunk
+			length += (size_t) snprintf(documents + length, sizeof(documents) - length, "%.*s",
+				(int) (strrchr(rest, ' ') + 1 - rest), rest);
+		}
+
+		snprintf(documents + length, sizeof(documents) - length, "%d", (int) ZETES_RESULT_OK);
+		CHECK(strcmp(documents, expected) == 0);
+	}
+
+	CHECK(zetes_split_documents("[1]", 3, offsets, 4) == 1);
+	CHECK(zetes_split_documents("", 0, offsets, 4) == 0);
+}
+
+
+static void test_raw_utf8(void) {
+	// astral characters are written as a surrogate pair, or raw, and read back the same; a lone
+	// surrogate, which the reader keeps as its three byte encoding, is escaped either way
+	static const char* const CASES[][3] = {
+		{"[\"\xf0\x9f\x98\x80\"]", "[\"\\uD83D\\uDE00\"]", "[\"\xf0\x9f\x98\x80\"]"},
+		{"[\"\\ud83d\\ude00\"]", "[\"\\uD83D\\uDE00\"]", "[\"\xf0\x9f\x98\x80\"]"},
+		{"[\"\\uDBFF\\uDFFF\"]", "[\"\\uDBFF\\uDFFF\"]", "[\"\xf4\x8f\xbf\xbf\"]"},
+		{"[\"\xc3\xa9\\u00e9\"]", "[\"\\u00E9\\u00E9\"]", "[\"\xc3\xa9\xc3\xa9\"]"},
+		{"[\"\\ud800\"]", "[\"\\uD800\"]", "[\"\\uD800\"]"},
+		{"[\"\\udc00x\"]", "[\"\\uDC00x\"]", "[\"\\uDC00x\"]"},
+		{"[\"\\ud800\\ud800\"]", "[\"\\uD800\\uD800\"]", "[\"\\uD800\\uD800\"]"},
+		{"[\"\xed\xa0\x80\"]", "[\"\\uD800\"]", "[\"\\uD800\"]"},
+	};
+
+	// taken as they are when read, but not well formed UTF-8 so never written
+	static const char* const REJECTED[] = {
+		"[\"\xff\"]", "[\"\xc0\xaf\"]", "[\"\xe2\x82\"]", "[\"\xf4\x90\x80\x80\"]", "[\"a\x80\"]"
+	};
+
+	static char written[256];
+	size_t i;
+
+	for (i = 0; i < sizeof(CASES) / sizeof(CASES[0]); i++) {
+		int raw;
+
+		for (raw = 0; raw < 2; raw++) {
+			zetes_t ctx;
+
+			zetes_init(&ctx, 8, g_arena, sizeof(g_arena));
+			zetes_set_raw_utf8(&ctx, raw);
+			CHECK(zetes_read_buffer(&ctx, CASES[i][0], strlen(CASES[i][0])) == ZETES_RESULT_OK);
+			strcpy(written, write_string(&ctx));
+			CHECK(strcmp(written, CASES[i][1 + raw]) == 0);
+
+			zetes_init(&ctx, 8, g_arena, sizeof(g_arena));
+			zetes_set_raw_utf8(&ctx, raw);
+			CHECK(zetes_read_buffer(&ctx, written, strlen(written)) == ZETES_RESULT_OK);
+			CHECK(strcmp(write_string(&ctx), written) == 0);
+		}
+	}
+
+	for (i = 0; i < sizeof(REJECTED) / sizeof(REJECTED[0]); i++) {
+		int raw;
+
+		for (raw = 0; raw < 2; raw++) {
+			zetes_t ctx;
+
+			zetes_init(&ctx, 8, g_arena, sizeof(g_arena));
+			zetes_set_raw_utf8(&ctx, raw);
+			CHECK(zetes_read_buffer(&ctx, REJECTED[i], strlen(REJECTED[i])) == ZETES_RESULT_OK);
+			CHECK(zetes_write_buffer(&ctx, written, sizeof(written)) == ZETES_RESULT_INVALID_STRING);
+		}
+	}
+}
+
+
+typedef struct {
+	char* data;
+	size_t length;
+	size_t size;
+} sink_t;
+
+
+static int write_sink(const void* buffer, int length, void* user_data) {
+	// appends what fits, failing once it is full
+	sink_t* sink = (sink_t*) user_data;
+
+	if ( (size_t) length > sink->size - sink->length ) {
+		return -1;
+	}
+
+	memcpy(sink->data + sink->length, buffer, (size_t) length);
+	sink->length += (size_t) length;
+
+	return length;
+}
+
+
+static void write_document(zetes_t* ctx) {
+	zetes_writer_begin_object(ctx);
+	zetes_writer_key(ctx, "a");
+	zetes_writer_begin_array(ctx);
+	zetes_writer_int(ctx, -12);
+	zetes_writer_number(ctx, 2.5);
+	zetes_writer_string(ctx, "x\"y");
+	zetes_writer_null(ctx);
+	zetes_writer_bool(ctx, true);
+	zetes_writer_end_array(ctx);
+	zetes_writer_key_n(ctx, "bc", 1);
+	zetes_writer_begin_object(ctx);
+	zetes_writer_end_object(ctx);
+	zetes_writer_key(ctx, "c");
+	zetes_writer_value(ctx);
+	zetes_writer_end_object(ctx);
+}
+
+
+static void test_writer(void) {
+	// the same output into a buffer or, staged through the temporary buffer, to a callback; a value
+	// where a key goes, a second root value or a container left open fails with SYNTAX_ERROR
+	static const char expected[] = "{\"a\":[-12,2.5,\"x\\\"y\",null,true],\"b\":{},\"c\":[1,{\"d\":[]}]}";
+	static char buffer[256];
+	zetes_t ctx;
+	sink_t sink;
+	size_t length = 0;
+
+	zetes_init(&ctx, 8, g_arena, sizeof(g_arena));
+	zetes_read_buffer(&ctx, "[1,{\"d\":[]}]", 12);
+	zetes_writer_begin_buffer(&ctx, buffer, sizeof(buffer));
+	write_document(&ctx);
+	CHECK(zetes_writer_finish(&ctx, &length) == ZETES_RESULT_OK);
+	CHECK(length == sizeof(expected) - 1 && memcmp(buffer, expected, length) == 0);
+
+	sink.data = buffer;
+	sink.length = 0;
+	sink.size = sizeof(buffer);
+	length = 0;
+	zetes_writer_begin(&ctx, write_sink, &sink);
+	write_document(&ctx);
+	CHECK(zetes_writer_finish(&ctx, &length) == ZETES_RESULT_OK);
+	CHECK(length == sizeof(expected) - 1 && sink.length == length && memcmp(buffer, expected, length) == 0);
+
+	// too small a buffer
+	zetes_writer_begin_buffer(&ctx, buffer, 8);
+	write_document(&ctx);
+	CHECK(zetes_writer_finish(&ctx, &length) == ZETES_RESULT_WRITE_ERROR);
+
+	zetes_init(&ctx, 8, g_arena, sizeof(g_arena));
+	zetes_writer_begin_buffer(&ctx, buffer, sizeof(buffer));
+	zetes_writer_begin_object(&ctx);
+	zetes_writer_int(&ctx, 1);
+	CHECK(ctx.result == ZETES_RESULT_SYNTAX_ERROR);
+	CHECK(zetes_writer_finish(&ctx, &length) == ZETES_RESULT_SYNTAX_ERROR);
+
+	zetes_init(&ctx, 8, g_arena, sizeof(g_arena));
+	zetes_writer_begin_buffer(&ctx, buffer, sizeof(buffer));
+	zetes_writer_int(&ctx, 1);
+	zetes_writer_int(&ctx, 2);
+	CHECK(ctx.result == ZETES_RESULT_SYNTAX_ERROR);
+	CHECK(zetes_writer_finish(&ctx, &length) == ZETES_RESULT_SYNTAX_ERROR);
+
+	zetes_init(&ctx, 8, g_arena, sizeof(g_arena));
+	zetes_writer_begin_buffer(&ctx, buffer, sizeof(buffer));
+	zetes_writer_begin_array(&ctx);
+	zetes_writer_begin_object(&ctx);
+	zetes_writer_end_object(&ctx);
+	CHECK(ctx.result == ZETES_RESULT_OK);
+	CHECK(zetes_writer_finish(&ctx, &length) == ZETES_RESULT_SYNTAX_ERROR);
+
+	zetes_init(&ctx, 8, g_arena, sizeof(g_arena));
+	zetes_writer_begin_buffer(&ctx, buffer, sizeof(buffer));
+	zetes_writer_begin_object(&ctx);
+	zetes_writer_key(&ctx, "a");
+	zetes_writer_end_object(&ctx);
+	CHECK(ctx.result == ZETES_RESULT_SYNTAX_ERROR);
+}
+
+
+static int writev_sink(const zetes_segment_t* segments, int count, void* user_data) {
+	int i;
+
+	for (i = 0; i < count; i++) {
+		if ( write_sink(segments[i].buffer, (int) segments[i].length, user_data) < 0 ) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+
+static void test_writev(void) {
+	// the segments put together are what zetes_write() writes, for strings passed by reference or
+	// staged, deferred text, and more segments than are sent at once
+	static const char LETTERS[] = "abcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyz";
+	static char json[4096];
+	static char staging[32];
+	static char written[4096];
+	static char gathered[4096];
+	size_t length;
+	int i;
+	int lazy;
+
+	length = (size_t) snprintf(json, sizeof(json), "{\"short\":\"%.*s\",\"below\":\"%.*s\",\"at\":\"%.*s\",\"escaped\":\"%.*s\\n%.*s\",\"list\":[",
+		10, LETTERS, ZETES_WRITEV_MIN_LENGTH - 1, LETTERS, ZETES_WRITEV_MIN_LENGTH, LETTERS, 70, LETTERS, 70, LETTERS);
+
+	for (i = 0; i < 2 * ZETES_WRITEV_SEGMENTS; i++) {
+		length += (size_t) snprintf(json + length, sizeof(json) - length, "%s\"%.*s\",%d", i ? "," : "", 80, LETTERS, i);
+	}
+
+	length += (size_t) snprintf(json + length, sizeof(json) - length, "],\"n\":[2.5,true,null,\"\\u00e9\"]}");
+	CHECK(length < sizeof(json) - 1);
+
+	for (lazy = 0; lazy < 2; lazy++) {
+		int staged;
+
+		for (staged = 0; staged < 2; staged++) {
+			zetes_t ctx;
+			sink_t a = {written, 0, sizeof(written)};
+			sink_t b = {gathered, 0, sizeof(gathered)};
+
+			zetes_init(&ctx, 8, g_arena, sizeof(g_arena));
+
+			if ( staged ) {
+				zetes_set_write_buffer(&ctx, staging, sizeof(staging));
+			}
+
+			if ( lazy ) {
+				CHECK(zetes_read_lazy(&ctx, json, length) == ZETES_RESULT_OK);
+			} else {
+				CHECK(zetes_read_buffer(&ctx, json, length) == ZETES_RESULT_OK);
+			}
+
+			CHECK(zetes_write(&ctx, write_sink, &a) == ZETES_RESULT_OK);
+			CHECK(zetes_writev(&ctx, writev_sink, &b) == ZETES_RESULT_OK);
+			CHECK(a.length > 0 && a.length == b.length && memcmp(written, gathered, a.length) == 0);
+		}
+	}
+}
+
+
+static zetes_result_t read_cbor(zetes_t* ctx, const char* cbor, size_t length) {
+	zetes_init(ctx, 16, g_arena, sizeof(g_arena));
+
+	return zetes_read_cbor_buffer(ctx, cbor, length);
+}
+
+
+static void test_cbor_round_trip(void) {
+	// JSON read, written as CBOR and read back writes the same JSON
+	static const char* const documents[] = {
+		"null", "[]", "{}", "[true,false,null]", "{\"a\":[1,-2,{\"b\":\"c\"}],\"d\":{}}",
+		"[0,23,24,255,256,65535,65536,4294967295,4294967296,-1,-24,-25,-4294967297]",
+		"[1.5,-0.25,1e300,5e-324,123456.789]", "\"\xc3\xa9\\u0000\"", "[[[[[[[[1]]]]]]]]",
+	};
+	static char cbor[1024];
+	static char expected[1024];
+	size_t i;
+
+	for (i = 0; i < sizeof(documents) / sizeof(documents[0]); i++) {
+		const char* json = documents[i];
+		size_t length = 0;
+		zetes_t ctx;
+
+		zetes_init(&ctx, 16, g_arena, sizeof(g_arena));
+		CHECK(zetes_read_buffer(&ctx, json, strlen(json)) == ZETES_RESULT_OK);
+		strcpy(expected, write_string(&ctx));
+		CHECK(zetes_write_cbor_buffer(&ctx, cbor, sizeof(cbor), &length) == ZETES_RESULT_OK);
+
+		CHECK(read_cbor(&ctx, cbor, length) == ZETES_RESULT_OK);
+		CHECK(strcmp(write_string(&ctx), expected) == 0);
+	}
+}
+
+
+static void test_cbor_encoding(void) {
+	// the shortest head for each count and integer, numbers always as doubles
+	static const char json[] = "{\"a\":[1,-2,true,24,1.5]}";
+	static const char expected[] = "\xa1\x61\x61\x85\x01\x21\xf5\x18\x18\xfb\x3f\xf8\0\0\0\0\0\0";
+	static char cbor[64];
+	size_t length = 0;
+	zetes_t ctx;
+
+	zetes_init(&ctx, 16, g_arena, sizeof(g_arena));
+	zetes_read_buffer(&ctx, json, sizeof(json) - 1);
+	CHECK(zetes_write_cbor_buffer(&ctx, cbor, sizeof(cbor), &length) == ZETES_RESULT_OK);
+	CHECK(length == sizeof(expected) - 1 && memcmp(cbor, expected, length) == 0);
+}
+
+
+static void test_cbor_read(void) {
+	static const struct {
+		const char* cbor;
+		size_t length;
+		const char* json;
+	} items[] = {
+		// indefinite lengths, alone and nested
+		{"\x9f\x01\x02\xff", 4, "[1,2]"},
+		{"\xbf\x61\x61\x01\x61\x62\x9f\xff\xff", 9, "{\"a\":1,\"b\":[]}"},
+		{"\x9f\xbf\xff\x82\x9f\xff\xa0\xff", 8, "[{},[[],{}]]"},
+		// tags are read through
+		{"\xc1\x1a\x00\x01\x00\x00", 6, "65536"},
+		{"\x82\xd8\x20\x61\x78\xc0\xc1\xf6", 8, "[\"x\",null]"},
+		// undefined has no JSON counterpart but null
+		{"\xf7", 1, "null"},
+	};
+	size_t i;
+
+	for (i = 0; i < sizeof(items) / sizeof(items[0]); i++) {
+		zetes_t ctx;
+
+		CHECK(read_cbor(&ctx, items[i].cbor, items[i].length) == ZETES_RESULT_OK);
+		CHECK(strcmp(write_string(&ctx), items[i].json) == 0);
+	}
+}
+
+
+static void test_cbor_floats(void) {
+	// every width widens to the same double
+	static const struct {
+		const char* cbor;
+		size_t length;
+		double number;
+	} items[] = {
+		{"\xf9\x3e\x00", 3, 1.5},
+		{"\xf9\xc4\x00", 3, -4.0},
+		{"\xf9\x7b\xff", 3, 65504.0},
+		{"\xf9\x00\x01", 3, 5.9604644775390625e-8},
+		{"\xf9\x80\x00", 3, -0.0},
+		{"\xfa\x3f\xc0\x00\x00", 5, 1.5},
+		{"\xfa\x47\xc3\x50\x00", 5, 100000.0},
+		{"\xfb\x3f\xf8\x00\x00\x00\x00\x00\x00", 9, 1.5},
+		{"\xfb\x7e\x37\xe4\x3c\x88\x00\x75\x9c", 9, 1e300},
+	};
+	size_t i;
+
+	for (i = 0; i < sizeof(items) / sizeof(items[0]); i++) {
+		zetes_t ctx;
+
+		CHECK(read_cbor(&ctx, items[i].cbor, items[i].length) == ZETES_RESULT_OK);
+		CHECK(zetes_type(&ctx) == ZETES_TYPE_NUMBER);
+		CHECK(zetes_pop_number(&ctx) == items[i].number);
+	}
+}
+
+
+static void test_cbor_rejected(void) {
+	static const struct {
+		const char* cbor;
+		size_t length;
+		zetes_result_t result;
+	} items[] = {
+		// byte strings, alone and in a container
+		{"\x41\x00", 2, ZETES_RESULT_SYNTAX_ERROR},
+		{"\x81\x5f\xff", 3, ZETES_RESULT_SYNTAX_ERROR},
+		// a break between a key and its value, or outside an indefinite container
+		{"\xbf\x61\x61\xff", 4, ZETES_RESULT_SYNTAX_ERROR},
+		{"\x82\x01\xff", 3, ZETES_RESULT_SYNTAX_ERROR},
+		{"\xff", 1, ZETES_RESULT_SYNTAX_ERROR},
+		// keys must be text
+		{"\xa1\x01\x02", 3, ZETES_RESULT_SYNTAX_ERROR},
+		{"\xa1\x80\x02", 3, ZETES_RESULT_SYNTAX_ERROR},
+		// indefinite text, reserved additional information and trailing items
+		{"\x7f\x61\x61\xff", 4, ZETES_RESULT_SYNTAX_ERROR},
+		{"\x1c", 1, ZETES_RESULT_SYNTAX_ERROR},
+		{"\x01\x02", 2, ZETES_RESULT_SYNTAX_ERROR},
+		// truncated heads, strings and containers
+		{"", 0, ZETES_RESULT_UNEXPECTED_END_OF_INPUT},
+		{"\x19\x01", 2, ZETES_RESULT_UNEXPECTED_END_OF_INPUT},
+		{"\x63\x61\x62", 3, ZETES_RESULT_UNEXPECTED_END_OF_INPUT},
+		{"\x82\x01", 2, ZETES_RESULT_UNEXPECTED_END_OF_INPUT},
+		{"\x9f\x01", 2, ZETES_RESULT_UNEXPECTED_END_OF_INPUT},
+		{"\xa1\x61\x61", 3, ZETES_RESULT_UNEXPECTED_END_OF_INPUT},
+		{"\xfb\x3f\xf8", 3, ZETES_RESULT_UNEXPECTED_END_OF_INPUT},
+		{"\xc1", 1, ZETES_RESULT_UNEXPECTED_END_OF_INPUT},
+	};
+	size_t i;
+
+	for (i = 0; i < sizeof(items) / sizeof(items[0]); i++) {
+		zetes_t ctx;
+
+		CHECK(read_cbor(&ctx, items[i].cbor, items[i].length) == items[i].result);
+	}
+}
+
+
+static void test_load_snapshot(void) {
+	// every pointer is checked on loading, even with the snapshot where it was made
+	static const char json[] = "{\"key\":[1,\"two\",{\"three\":null}],\"four\":4.5}";
+	static union { char bytes[4096]; double align; } image;
+	static char deep[2 * 40 + 1];
+	size_t depth = 40;
+	size_t length = 0;
+	zetes_t ctx;
+
+	zetes_init(&ctx, 16, g_arena, sizeof(g_arena));
+	zetes_read_buffer(&ctx, json, sizeof(json) - 1);
+	CHECK(zetes_snapshot(&ctx, image.bytes, sizeof(image.bytes), &length) == ZETES_RESULT_OK);
+
+	zetes_init(&ctx, 16, g_arena, sizeof(g_arena));
+	CHECK(zetes_load_snapshot(&ctx, image.bytes, length) == ZETES_RESULT_OK);
+	CHECK(strcmp(write_string(&ctx), json) == 0);
+
+	zetes_init(&ctx, 16, g_arena, sizeof(g_arena));
+	CHECK(zetes_load_snapshot(&ctx, image.bytes, length) == ZETES_RESULT_OK);
+	CHECK(strcmp(write_string(&ctx), json) == 0);
+
+	// the tree is used in place, so point its first key outside the snapshot
+	ctx.stack_ptr->variant._object->members[0].key = json;
+	zetes_init(&ctx, 16, g_arena, sizeof(g_arena));
+	CHECK(zetes_load_snapshot(&ctx, image.bytes, length) == ZETES_RESULT_INVALID_SNAPSHOT);
+
+	// nesting deeper than the value stack has free slots for, loaded into an arena with little room
+	memset(deep, '[', depth);
+	deep[depth] = '0';
+	memset(deep + depth + 1, ']', depth);
+	zetes_init(&ctx, depth + 1, g_arena, sizeof(g_arena));
+	zetes_read_buffer(&ctx, deep, sizeof(deep));
+	CHECK(zetes_snapshot(&ctx, image.bytes, sizeof(image.bytes), &length) == ZETES_RESULT_OK);
+
+	zetes_init(&ctx, 4, g_arena, 2048);
+	CHECK(zetes_load_snapshot(&ctx, image.bytes, length) == ZETES_RESULT_OK);
+	CHECK(zetes_measure(&ctx) == sizeof(deep));
+}
+
+
 int main(int argc, char* argv[]) {
-	// TODO: Write tests
+	(void) argc;
+	(void) argv;
+
+	test_numbers();
+	test_object_set();
+	test_key_prefix();
+	test_events();
+	test_event_depth_limit();
+	test_event_skip();
+	test_feed_matches_read();
+	test_read_lazy();
+	test_validate();
+	test_read_next();
+	test_split_documents();
+	test_raw_utf8();
+	test_writer();
+	test_writev();
+	test_write_full_arena();
+	test_rollback_writer();
+	test_extract_bad_path();
+	test_write_no_alloc();
+	test_cbor_round_trip();
+	test_cbor_encoding();
+	test_cbor_read();
+	test_cbor_floats();
+	test_cbor_rejected();
+	test_load_snapshot();
+
+	if ( g_failures ) {
+		fprintf(stderr, "%d check(s) failed\n", g_failures);
+		return 1;
+	}
+
 	return 0;
 }
@@ -0,0 +1,182 @@
+#include <cstdio>
+#include <cstring>
+
+#include "zetes.hpp"
+
+
+#define CHECK(expr)				check((expr), #expr, __FILE__, __LINE__)
+
+
+struct point {
+	int x;
+	double y;
+};
+
+
+struct shape {
+	std::string name;
+	std::string_view tag;
+	std::vector<point> points;
+	std::optional<int> sides;
+	std::optional<std::string> note;
+	bool closed;
+	uint8_t small;
+	uint64_t count;
+	point origin;
+};
+
+
+template<> struct zetes::binding<point> {
+	static constexpr auto fields = std::make_tuple(zetes::field("x", &point::x), zetes::field("y", &point::y));
+};
+
+
+template<> struct zetes::binding<shape> {
+	static constexpr auto fields = std::make_tuple(zetes::field("name", &shape::name), zetes::field("tag", &shape::tag),
+			zetes::field("points", &shape::points), zetes::field("sides", &shape::sides), zetes::field("note", &shape::note),
+			zetes::field("closed", &shape::closed), zetes::field("small", &shape::small), zetes::field("count", &shape::count),
+			zetes::field("origin", &shape::origin));
+};
+
+
+static_assert(zetes::hash_key("") == 2166136261UL);
+
+
+static int g_failures;
+
+
+static void check(bool passed, const char* expr, const char* file, int line) {
+	if ( !passed ) {
+		fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expr);
+		g_failures++;
+	}
+}
+
+
+static const char SHAPE[] = "{\"unknown\":[1,{}],\"name\":\"box\\n\",\"tag\":\"t\",\"points\":[{\"x\":1,\"y\":2.5},{\"y\":3,\"x\":-4}],"
+	"\"sides\":4,\"note\":null,\"closed\":true,\"small\":200,\"count\":9007199254740993,\"origin\":{\"x\":9}}";
+
+
+static bool is_shape(const shape& s) {
+	return s.name == "box\n" && s.tag == "t" && s.points.size() == 2 && s.points[0].x == 1 && s.points[0].y == 2.5 &&
+		s.points[1].x == -4 && s.points[1].y == 3 && s.sides && *s.sides == 4 && !s.note && s.closed && s.small == 200 &&
+		s.count == 9007199254740993ULL && s.origin.x == 9;
+}
+
+
+static void test_bind(void) {
+	// unknown keys are skipped and fields without a member keep their value, read or read lazily
+	for (int lazy = 0; lazy < 2; lazy++) {
+		zetes::static_context<16384> ctx;
+		shape s {};
+
+		s.origin.y = 0.5;
+		CHECK((lazy ? ctx.read_lazy(SHAPE) : ctx.read(SHAPE)) == ZETES_RESULT_OK);
+		CHECK(ctx.bind(s) == ZETES_RESULT_OK);
+		CHECK(is_shape(s));
+		CHECK(s.origin.y == 0.5);
+	}
+}
+
+
+static void test_bind_built(void) {
+	// members set since reading are in the object's element list, and bind as those read do
+	zetes::static_context<16384> ctx;
+	point p {};
+
+	ctx.read("{\"x\":1}");
+	ctx.push_number(2.5);
+	ctx.set("y");
+	ctx.push_int(7);
+	ctx.set("x");
+	CHECK(ctx.bind(p) == ZETES_RESULT_OK);
+	CHECK(p.x == 7 && p.y == 2.5);
+
+	ctx.reset();
+	ctx.push_new_object();
+
+	for (int i = 0; i < 100; i++) {
+		char key[8];
+
+		snprintf(key, sizeof(key), "k%d", i);
+		ctx.push_int(i);
+		ctx.set(key);
+	}
+
+	ctx.push_int(42);
+	ctx.set("x");
+	CHECK(ctx.bind(p) == ZETES_RESULT_OK);
+	CHECK(p.x == 42);
+}
+
+
+static void test_bind_mismatch(void) {
+	zetes::static_context<4096> small_ctx;
+	zetes::static_context<4096> type_ctx;
+	shape s {};
+
+	CHECK(small_ctx.read("{\"small\":300}", s) == ZETES_RESULT_TYPE_MISMATCH);
+	CHECK(type_ctx.read("{\"name\":5}", s) == ZETES_RESULT_TYPE_MISMATCH);
+}
+
+
+static void test_write(void) {
+	// written straight from the struct, an empty optional is left out
+	zetes::static_context<16384> ctx;
+	zetes::static_context<16384> out;
+	zetes::static_context<16384> back;
+	std::string json;
+	shape s {};
+	shape t {};
+
+	ctx.read(SHAPE, s);
+	CHECK(out.write(s, json) == ZETES_RESULT_OK);
+	CHECK(json.find("\"note\"") == std::string::npos);
+	CHECK(back.read(json, t) == ZETES_RESULT_OK);
+	CHECK(is_shape(t));
+}
+
+
+static void test_write_out_of_range(void) {
+	// an unsigned value beyond zetes_int_t is refused rather than wrapped, as it is when read
+	zetes::static_context<16384> ctx;
+	std::string json;
+	shape s {};
+
+	s.count = (uint64_t) std::numeric_limits<zetes_int_t>::max();
+	CHECK(ctx.write(s, json) == ZETES_RESULT_OK);
+
+	ctx.reset();
+	json.clear();
+	s.count++;
+	CHECK(ctx.write(s, json) == ZETES_RESULT_TYPE_MISMATCH);
+}
+
+
+static void test_get_path(void) {
+	zetes::static_context<4096> ctx;
+
+	ctx.read("{\"a\":{\"b\":\"xy\"}}");
+	ctx.get_path("/a/b");
+	CHECK(ctx.pop_string() == "xy");
+}
+
+
+int main(int argc, char* argv[]) {
+	(void) argc;
+	(void) argv;
+
+	test_bind();
+	test_bind_built();
+	test_bind_mismatch();
+	test_write();
+	test_write_out_of_range();
+	test_get_path();
+
+	if ( g_failures ) {
+		fprintf(stderr, "%d check(s) failed\n", g_failures);
+		return 1;
+	}
+
+	return 0;
+}
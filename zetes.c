@@ -27,11 +27,28 @@
  * For more information, please refer to <http://unlicense.org/>
  */
 
+#include <limits.h>
 #include <stdint.h>
 #include <string.h>
 
 #include "zetes.h"
 
+#if ZETES_SIMD && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define ZETES_SIMD_SSE2
+#include <emmintrin.h>
+#elif ZETES_SIMD && defined(__ARM_NEON) && defined(__aarch64__)
+#define ZETES_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(__GNUC__)
+#define ZETES_NOINLINE		__attribute__((noinline))
+#elif defined(_MSC_VER)
+#define ZETES_NOINLINE		__declspec(noinline)
+#else
+#define ZETES_NOINLINE
+#endif
+
 extern void debug(char c);
 
 typedef enum {
@@ -47,10 +64,37 @@ typedef enum {
 } token_type_t;
 
 
+typedef struct {
+	const void* cursor;
+	size_t index;
+} wframe_t;
+
+
+typedef struct {
+	zetes_t* ctx;
+	wframe_t* stack_b;
+	size_t stack_count;
+	wframe_t* spill_b;
+	wframe_t* spill_e;
+	wframe_t fixed[8];
+} frames_t;
+
+
 typedef struct {
 	zetes_t* ctx;
 	zetes_write_func_t write_func;
 	void* user_data;
+	char* buffer_b;
+	char* buffer_i;
+	char* buffer_e;
+	size_t emitted;
+	zetes_writev_func_t writev_func;
+	zetes_segment_t* segment_b;
+	zetes_segment_t* segment_i;
+	zetes_segment_t* segment_e;
+	char* buffer_m;
+	wframe_t* frame_b;
+	wframe_t* frame_e;
 } wstate_t;
 
 
@@ -59,7 +103,12 @@ typedef struct {
 	zetes_read_func_t read_func;
 	char* buffer_i;
 	char* buffer_e;
-	char prev_char;
+	bool insitu;
+	bool partial;
+	bool starved;
+	bool multiple;
+	char* next_i;
+	char* next_e;
 	void* user_data;
 	token_type_t token_type;
 	zetes_value_t token_value;
@@ -67,9 +116,20 @@ typedef struct {
 
 
 typedef struct {
-	char* i;
-	char *e;
-} write_buffer_state_t;
+	zetes_read_func_t read_func;
+	void* user_data;
+	char* buffer;
+	size_t buffer_size;
+	const char* window;
+	const char* i;
+	const char* e;
+	size_t consumed;
+	zetes_result_t result;
+	size_t error_offset;
+	size_t token_offset;
+	bool is_string;
+	bool check_utf8;
+} vstate_t;
 
 
 typedef struct {
@@ -78,6 +138,81 @@ typedef struct {
 } read_buffer_state_t;
 
 
+typedef struct {
+	wframe_t source;
+	size_t slot;
+	size_t index;
+	uint32_t index_mask;
+} sframe_t;
+
+
+typedef struct {
+	zetes_t* ctx;
+	char* image;
+	size_t capacity;
+	size_t length;
+	size_t depth;
+} sstate_t;
+
+
+typedef struct {
+	uint32_t magic;
+	uint32_t layout;
+	uint64_t size;
+	uint64_t depth;
+	void* base;
+	zetes_value_t root;
+} snapshot_t;
+
+
+typedef struct {
+	uintptr_t begin;
+	uintptr_t end;
+	uintptr_t delta;
+	uintptr_t high;
+} lstate_t;
+
+
+typedef struct {
+	const char* key;
+	size_t key_length;
+	uint32_t hash;
+	size_t index;
+} ptoken_t;
+
+
+typedef struct {
+	const char* path;
+	size_t path_length;
+	ptoken_t* tokens;
+	size_t count;
+	size_t matched;
+} xpath_t;
+
+
+typedef enum {
+	EVENT_STATE_IDLE,
+	EVENT_STATE_VALUE,
+	EVENT_STATE_FIRST_VALUE,
+	EVENT_STATE_KEY,
+	EVENT_STATE_FIRST_KEY,
+	EVENT_STATE_COLON,
+	EVENT_STATE_NEXT,
+	EVENT_STATE_END,
+	EVENT_STATE_DONE
+} event_state_t;
+
+
+typedef enum {
+	WRITER_STATE_IDLE,
+	WRITER_STATE_VALUE,
+	WRITER_STATE_FIRST_VALUE,
+	WRITER_STATE_KEY,
+	WRITER_STATE_FIRST_KEY,
+	WRITER_STATE_DONE
+} writer_state_t;
+
+
 static const char SYMBOL_KEY_VAL_SEPARATOR[1] = 	{':'};
 static const char SYMBOL_COMMA[1] = 				{','};
 static const char SYMBOL_OBJECT_OPEN[1] = 			{'{'};
@@ -90,9 +225,11 @@ static const char SYMBOL_FALSE[5] =					{'f', 'a', 'l', 's', 'e'};
 static const char SYMBOL_TRUE[4] =					{'t', 'r', 'u', 'e'};
 
 
-static bool write_value(wstate_t* state, const zetes_value_t* value);
+static bool write_lazy(wstate_t* state, const char* i, const char* e);
+
+static void parse_document(rstate_t* state);
 
-static void parse_value(rstate_t* state);
+static bool resolve(zetes_t* ctx, const zetes_value_t* value);
 
 
 static void set_error(zetes_t* ctx, zetes_result_t result) {
@@ -107,37 +244,219 @@ static void* align_ptr(void* ptr) {
 }
 
 
-static void* alloc(zetes_t* ctx, size_t size) {
-	size_t space;
-	void* ptr;
+static void* align_down(void* ptr) {
+	return (void*) ((((uintptr_t) ptr) / (ZETES_ALIGN)) * ZETES_ALIGN);
+}
+
+
+static size_t scratch_depth(const zetes_t* ctx) {
+	// scratch areas are addressed by their depth below the top of the current block, which stays the
+	// same when they move to a new one
+	return (size_t) ((char*) ctx->buffer_top - (char*) ctx->buffer_end);
+}
+
+
+static void* scratch_at(const zetes_t* ctx, size_t depth) {
+	return (char*) ctx->buffer_top - depth;
+}
+
+
+static char* block_top(const zetes_t* ctx, const zetes_block_t* block) {
+	return block ? (char*) block + block->size : (char*) align_down((char*) ctx->buffer_begin + ctx->buffer_size);
+}
+
+
+#if ZETES_STATS
+static void count_arena(zetes_t* ctx, size_t size) {
+	// what is in use from both ends of the arena, plus size bytes about to be, counting the
+	// unused tails of chained blocks as in use since they can't be allocated from again
+	size_t used = ctx->buffer_size + ctx->stats.block_bytes - (size_t) ((char*) ctx->buffer_end - (char*) ctx->buffer_ptr) + size;
+
+	if ( used > ctx->stats.arena_peak ) {
+		ctx->stats.arena_peak = used;
+	}
+}
+#endif
+
+
+static bool grow_arena(zetes_t* ctx, size_t size) {
+	// Chains a new block with room for size bytes, if an allocator was given. Each block is twice the
+	// size of the one before, up to 256 times ZETES_BLOCK_SIZE, or bigger still if the request needs
+	// it. Open scratch areas move to the top of the new block, keeping their alignment.
+	size_t scratch = scratch_depth(ctx);
+	size_t block_size = (size_t) ZETES_BLOCK_SIZE << (ctx->block_count < 8 ? ctx->block_count : 8);
+	size_t need = sizeof(zetes_block_t) + scratch + 2 * ZETES_ALIGN;
+	zetes_block_t* block;
+	char* end;
+
+	if ( !ctx->alloc_func || size > SIZE_MAX / 4 - need ) {
+		return false;
+	}
+
+	need += size;
+
+	while ( block_size < need ) {
+		block_size *= 2;
+	}
 
-	ctx->buffer_ptr = align_ptr(ctx->buffer_ptr);
-	space = ctx->buffer_end - ctx->buffer_ptr;
+	block = (zetes_block_t*) ctx->alloc_func(block_size, ctx->alloc_user_data);
 
-	if ( space < size ) {
+	if ( !block ) {
+		return false;
+	}
+
+	block->prev = ctx->block;
+	block->size = block_size;
+
+	end = (char*) block + block_size - scratch;
+	end -= ((uintptr_t) end - (uintptr_t) ctx->buffer_end) & (ZETES_ALIGN - 1);
+	memcpy(end, ctx->buffer_end, scratch);
+
+	ctx->block = block;
+	ctx->block_count++;
+	ctx->buffer_ptr = block + 1;
+	ctx->buffer_end = end;
+	ctx->buffer_top = end + scratch;
+
+#if ZETES_STATS
+	ctx->stats.block_bytes += block_size;
+#endif
+
+	return true;
+}
+
+
+static void release_blocks(zetes_t* ctx, zetes_block_t* keep) {
+	// frees the blocks chained after keep, which becomes the current block again
+	if ( ctx->block == keep ) {
+		return;
+	}
+
+	while ( ctx->block != keep ) {
+		zetes_block_t* block = ctx->block;
+
+		ctx->block = block->prev;
+		ctx->block_count--;
+
+#if ZETES_STATS
+		ctx->stats.block_bytes -= block->size;
+#endif
+
+		if ( ctx->free_func ) {
+			ctx->free_func(block, block->size, ctx->alloc_user_data);
+		}
+	}
+
+	ctx->buffer_top = block_top(ctx, keep);
+	ctx->buffer_end = ctx->buffer_top;
+}
+
+
+static bool reserve(zetes_t* ctx, size_t size) {
+	// makes sure there are at least size bytes of free space, chaining a block if need be
+	char* ptr = (char*) ctx->buffer_ptr;
+	char* end = (char*) ctx->buffer_end;
+
+	return (ptr <= end && (size_t) (end - ptr) >= size) || grow_arena(ctx, size);
+}
+
+
+static void keep_allocations(zetes_t* ctx) {
+	// what has been allocated so far survives zetes_reset()
+	ctx->buffer_base = ctx->buffer_ptr;
+	ctx->base_block = ctx->block;
+}
+
+
+static void* try_alloc(zetes_t* ctx, size_t size) {
+	char* start = (char*) ctx->buffer_ptr;
+	char* ptr = (char*) align_ptr(start);
+	char* end = (char*) ctx->buffer_end;
+
+	if ( ptr > end || (size_t) (end - ptr) < size ) {
+		if ( !ctx->alloc_func || !grow_arena(ctx, size) ) {
+			return NULL;
+		}
+
+		start = (char*) ctx->buffer_ptr;
+		ptr = (char*) align_ptr(start);
+	}
+
+	ctx->buffer_ptr = align_ptr(ptr + size);
+
+#if ZETES_STATS
+	ctx->stats.node_bytes += size;
+	ctx->stats.padding_bytes += (size_t) ((char*) ctx->buffer_ptr - start) - size;
+	count_arena(ctx, 0);
+#endif
+
+	return ptr;
+}
+
+
+static void* alloc(zetes_t* ctx, size_t size) {
+	void* ptr = try_alloc(ctx, size);
+
+	if ( !ptr ) {
 		set_error(ctx, ZETES_RESULT_OUT_OF_MEMORY);
-		ptr = NULL;
-	} else {
-		ptr = ctx->buffer_ptr;
-		ctx->buffer_ptr = align_ptr(ctx->buffer_ptr + size);
 	}
 
 	return ptr;
 }
 
 
+static char* alloc_string(zetes_t* ctx, size_t size) {
+	// as alloc(), but counted as string bytes
+	char* str = (char*) alloc(ctx, size);
+
+#if ZETES_STATS
+	if ( str ) {
+		ctx->stats.node_bytes -= size;
+		ctx->stats.string_bytes += size;
+	}
+#endif
+
+	return str;
+}
+
+
 zetes_result_t zetes_init(zetes_t* ctx, size_t stack_depth, void* buffer, size_t buffer_size) {
 	ZETES_ASSERT(ctx);
-	ZETES_ASSERT(mem_funcs);
 	ZETES_ASSERT(stack_depth >= 2);
 
 	ctx->result = ZETES_RESULT_OK;
 	ctx->buffer_begin = buffer;
-	ctx->buffer_end = buffer + buffer_size;
+	ctx->buffer_size = buffer_size;
+	// an aligned end keeps the aligned allocation pointer from ever passing it
+	ctx->buffer_end = align_down((char*) buffer + buffer_size);
+	ctx->buffer_top = ctx->buffer_end;
 	ctx->buffer_ptr = align_ptr(buffer);
+	ctx->block = NULL;
+	ctx->block_count = 0;
+	ctx->alloc_func = NULL;
+	ctx->free_func = NULL;
+	ctx->alloc_user_data = NULL;
+
+#if ZETES_STATS
+	memset(&ctx->stats, 0, sizeof(ctx->stats));
+#endif
+
 	ctx->stack_begin = (zetes_value_t*) alloc(ctx, stack_depth * sizeof(zetes_value_t));
 	ctx->stack_end = ctx->stack_begin + stack_depth;
 	ctx->stack_ptr = ctx->stack_end;
+	keep_allocations(ctx);
+	ctx->read_buffer = ctx->temp;
+	ctx->read_buffer_size = ZETES_TEMP_BUFFER_SIZE;
+	ctx->write_buffer = NULL;
+	ctx->write_buffer_size = 0;
+	ctx->raw_utf8 = false;
+	ctx->intern_table = NULL;
+	ctx->intern_mask = 0;
+	ctx->intern_count = 0;
+	ctx->reader.state = EVENT_STATE_IDLE;
+	ctx->reader.nesting_ext = NULL;
+	ctx->reader.max_depth = ZETES_MAX_DEPTH;
+	ctx->writer.state = WRITER_STATE_IDLE;
 
 	return ctx->result;
 }
@@ -147,10 +466,14 @@ void zetes_cleanup(zetes_t* ctx) {
 	ZETES_ASSERT(ctx);
 	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
 
+	release_blocks(ctx, NULL);
+
 	ctx->result = ZETES_RESULT_UNINITIALIZED;
 	ctx->buffer_begin = NULL;
+	ctx->buffer_base = NULL;
 	ctx->buffer_end = NULL;
 	ctx->buffer_ptr = NULL;
+	ctx->buffer_top = NULL;
 	ctx->stack_begin = NULL;
 	ctx->stack_end = NULL;
 	ctx->stack_ptr = NULL;
@@ -161,9 +484,40 @@ void zetes_reset(zetes_t* ctx) {
 	ZETES_ASSERT(ctx);
 	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
 
+	release_blocks(ctx, ctx->base_block);
+
 	ctx->result = ZETES_RESULT_OK;
-	ctx->buffer_ptr = ctx->buffer_begin;
+	ctx->buffer_ptr = ctx->buffer_base;
 	ctx->stack_ptr = ctx->stack_end;
+
+	// a document abandoned part way through zetes_feed() may still hold array scratch areas
+	if ( ctx->reader.state != EVENT_STATE_IDLE ) {
+		ctx->buffer_end = scratch_at(ctx, ctx->reader.saved_depth);
+		ctx->reader.state = EVENT_STATE_IDLE;
+	}
+
+	ctx->writer.state = WRITER_STATE_IDLE;
+
+	// the interned strings themselves were in the part of the arena just released
+	if ( ctx->intern_table ) {
+		memset(ctx->intern_table, 0, ((size_t) ctx->intern_mask + 1) * sizeof(zetes_intern_t));
+		ctx->intern_count = 0;
+	}
+}
+
+
+void zetes_set_allocator(zetes_t* ctx, zetes_alloc_func_t alloc_func, zetes_free_func_t free_func, void* user_data) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+	ZETES_ASSERT(alloc_func || !free_func);
+	ZETES_ASSERT(ctx->buffer_ptr == ctx->buffer_base);
+
+	// Once the buffer given to zetes_init() runs out, blocks from alloc_func are chained on. They are
+	// all handed back to free_func by zetes_reset() and zetes_cleanup(), so free_func may be NULL if
+	// the memory is reclaimed some other way.
+	ctx->alloc_func = alloc_func;
+	ctx->free_func = free_func;
+	ctx->alloc_user_data = user_data;
 }
 
 
@@ -180,6 +534,41 @@ bool zetes_ok(const zetes_t* zetes) {
 }
 
 
+void zetes_set_error(zetes_t* ctx, zetes_result_t result) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+	ZETES_ASSERT(result != ZETES_RESULT_OK);
+
+	// for errors found by code built on top, kept only if there hasn't been one already
+	set_error(ctx, result);
+}
+
+
+#if ZETES_STATS
+const zetes_stats_t* zetes_stats(const zetes_t* ctx) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+
+	return &ctx->stats;
+}
+
+
+void zetes_reset_stats(zetes_t* ctx) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+
+	// the byte counts are totals since the last reset, while the peaks start again from what is in
+	// use now; blocks stay counted for as long as they are chained
+	size_t block_bytes = ctx->stats.block_bytes;
+
+	memset(&ctx->stats, 0, sizeof(ctx->stats));
+	ctx->stats.block_bytes = block_bytes;
+	ctx->stats.stack_peak = (size_t) (ctx->stack_end - ctx->stack_ptr);
+	count_arena(ctx, 0);
+}
+#endif
+
+
 static bool ok(const zetes_t* ctx) {
 	return ctx->result == ZETES_RESULT_OK;
 }
@@ -194,6 +583,12 @@ static zetes_value_t* stack_emplace(zetes_t* ctx) {
 	if ( ok(ctx) ) {
 		if (ctx->stack_ptr > ctx->stack_begin) {
 			slot = --(ctx->stack_ptr);
+
+#if ZETES_STATS
+			if ( (size_t) (ctx->stack_end - ctx->stack_ptr) > ctx->stats.stack_peak ) {
+				ctx->stats.stack_peak = (size_t) (ctx->stack_end - ctx->stack_ptr);
+			}
+#endif
 		} else {
 			set_error(ctx, ZETES_RESULT_STACK_FULL);
 		}
@@ -266,26 +661,102 @@ void zetes_push_number(zetes_t* ctx, zetes_number_t value) {
 }
 
 
-void zetes_push_string(zetes_t* ctx, const char* value) {
+void zetes_push_int(zetes_t* ctx, zetes_int_t value) {
 	ZETES_ASSERT(ctx);
 	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+
+	zetes_value_t* slot = stack_emplace(ctx);
+
+	if ( slot ) {
+		slot->type = ZETES_TYPE_INTEGER;
+		slot->variant._int = value;
+	}
+}
+
+
+static char* copy_string(zetes_t* ctx, const char* value, size_t length) {
+	char* str = NULL;
+
+	if ( length > UINT32_MAX ) {
+		set_error(ctx, ZETES_RESULT_OUT_OF_MEMORY);
+	} else {
+		str = alloc_string(ctx, length + 1);
+
+		if ( str ) {
+			memcpy(str, value, length);
+			str[length] = '\0';
+		}
+	}
+
+	return str;
+}
+
+
+void zetes_push_string(zetes_t* ctx, const char* value) {
 	ZETES_ASSERT(value);
 
+	zetes_push_string_n(ctx, value, strlen(value));
+}
+
+
+void zetes_push_string_n(zetes_t* ctx, const char* value, size_t length) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+	ZETES_ASSERT(value || !length);
+
 	zetes_value_t* slot = stack_emplace(ctx);
 
 	if ( slot ) {
-		size_t len = strlen(value) + 1;
-		char* str = (char*) alloc(ctx, len);
+		char* str = copy_string(ctx, value, length);
 
 		if ( str ) {
-			memcpy(str, value, len);
 			slot->type = ZETES_TYPE_STRING;
+			slot->length = (uint32_t) length;
 			slot->variant._string = str;
+		} else {
+			// don't leave a half-initialised value behind
+			ctx->stack_ptr++;
 		}
 	}
 }
 
 
+static zetes_array_t* new_array(zetes_t* ctx) {
+	zetes_array_t* array = (zetes_array_t*) alloc(ctx, sizeof(zetes_array_t));
+
+	if ( array ) {
+		array->values = NULL;
+		array->count = 0;
+		array->size = 0;
+		array->first = NULL;
+		array->last = NULL;
+		array->lazy = NULL;
+		array->lazy_end = NULL;
+	}
+
+	return array;
+}
+
+
+static zetes_object_t* new_object(zetes_t* ctx) {
+	zetes_object_t* object = (zetes_object_t*) alloc(ctx, sizeof(zetes_object_t));
+
+	if ( object ) {
+		object->members = NULL;
+		object->count = 0;
+		object->size = 0;
+		object->first = NULL;
+		object->last = NULL;
+		object->index = NULL;
+		object->index_mask = 0;
+		object->lazy = NULL;
+		object->lazy_end = NULL;
+	}
+
+	return object;
+}
+
+
 void zetes_push_new_array(zetes_t* ctx) {
 	ZETES_ASSERT(ctx);
 	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
@@ -294,11 +765,9 @@ void zetes_push_new_array(zetes_t* ctx) {
 	zetes_value_t* slot = stack_emplace(ctx);
 
 	if ( slot ) {
-		zetes_array_t* array = (zetes_array_t*) alloc(ctx, sizeof(zetes_array_t));
+		zetes_array_t* array = new_array(ctx);
 
 		if ( array ) {
-			array->first = NULL;
-			array->last = NULL;
 			slot->type = ZETES_TYPE_ARRAY;
 			slot->variant._array = array;
 		}
@@ -314,11 +783,9 @@ void zetes_push_new_object(zetes_t* ctx) {
 	zetes_value_t* slot = stack_emplace(ctx);
 
 	if ( slot ) {
-		zetes_object_t* object = (zetes_object_t*) alloc(ctx, sizeof(zetes_object_t));
+		zetes_object_t* object = new_object(ctx);
 
 		if ( object ) {
-			object->first = NULL;
-			object->last = NULL;
 			slot->type = ZETES_TYPE_OBJECT;
 			slot->variant._object = object;
 		}
@@ -381,9 +848,42 @@ zetes_number_t zetes_pop_number(zetes_t* ctx) {
 
 	zetes_number_t value = 0;
 
-	if ( stack_validate(ctx, 1) && type_validate(ctx, ZETES_TYPE_NUMBER, ctx->stack_ptr->type) ) {
-		value = ctx->stack_ptr->variant._number;
-		ctx->stack_ptr++;
+	if ( stack_validate(ctx, 1) ) {
+		if ( ctx->stack_ptr->type == ZETES_TYPE_INTEGER ) {
+			value = (zetes_number_t) ctx->stack_ptr->variant._int;
+			ctx->stack_ptr++;
+		} else if ( type_validate(ctx, ZETES_TYPE_NUMBER, ctx->stack_ptr->type) ) {
+			value = ctx->stack_ptr->variant._number;
+			ctx->stack_ptr++;
+		}
+	}
+
+	return value;
+}
+
+
+zetes_int_t zetes_pop_int(zetes_t* ctx) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+
+	zetes_int_t value = 0;
+
+	if ( stack_validate(ctx, 1) ) {
+		if ( ctx->stack_ptr->type == ZETES_TYPE_NUMBER ) {
+			// accepted as long as no information is lost
+			double number = (double) ctx->stack_ptr->variant._number;
+
+			if ( number >= -9223372036854775808.0 && number < 9223372036854775808.0 &&
+					(double) (zetes_int_t) (int64_t) number == number ) {
+				value = (zetes_int_t) (int64_t) number;
+				ctx->stack_ptr++;
+			} else {
+				set_error(ctx, ZETES_RESULT_TYPE_MISMATCH);
+			}
+		} else if ( type_validate(ctx, ZETES_TYPE_INTEGER, ctx->stack_ptr->type) ) {
+			value = ctx->stack_ptr->variant._int;
+			ctx->stack_ptr++;
+		}
 	}
 
 	return value;
@@ -391,6 +891,11 @@ zetes_number_t zetes_pop_number(zetes_t* ctx) {
 
 
 const char* zetes_pop_string(zetes_t* ctx) {
+	return zetes_pop_string_n(ctx, NULL);
+}
+
+
+const char* zetes_pop_string_n(zetes_t* ctx, size_t* length) {
 	ZETES_ASSERT(ctx);
 	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
 
@@ -398,6 +903,11 @@ const char* zetes_pop_string(zetes_t* ctx) {
 
 	if ( stack_validate(ctx, 1) && type_validate(ctx, ZETES_TYPE_STRING, ctx->stack_ptr->type) ) {
 		value = ctx->stack_ptr->variant._string;
+
+		if ( length ) {
+			*length = ctx->stack_ptr->length;
+		}
+
 		ctx->stack_ptr++;
 	}
 
@@ -411,17 +921,31 @@ size_t zetes_array_size(zetes_t* ctx) {
 
 	size_t size = 0;
 
-	if ( stack_validate(ctx, 1) && type_validate(ctx, ZETES_TYPE_ARRAY, ctx->stack_ptr->type) ) {
-		zetes_array_t* array = ctx->stack_ptr->variant._array;
-		zetes_array_element_t* element = array->first;
+	if ( stack_validate(ctx, 1) && type_validate(ctx, ZETES_TYPE_ARRAY, ctx->stack_ptr->type) && resolve(ctx, ctx->stack_ptr) ) {
+		size = ctx->stack_ptr->variant._array->size;
+	}
+
+	return size;
+}
+
+
+static const zetes_value_t* array_at(const zetes_array_t* array, size_t index) {
+	const zetes_value_t* value = NULL;
+
+	if ( index < array->count ) {
+		value = &array->values[index];
+	} else if ( index < array->size ) {
+		// appended since the array was last frozen
+		const zetes_array_element_t* element = array->first;
 
-		while (element) {
+		for (index -= array->count; index > 0; index--) {
 			element = element->next;
-			size++;
 		}
+
+		value = &element->value;
 	}
 
-	return size;
+	return value;
 }
 
 
@@ -429,19 +953,14 @@ void zetes_array_index(zetes_t* ctx, size_t index) {
 	ZETES_ASSERT(ctx);
 	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
 
-	if ( stack_validate(ctx, 1) && type_validate(ctx, ZETES_TYPE_ARRAY, ctx->stack_ptr->type) ) {
-		zetes_array_t* array = ctx->stack_ptr->variant._array;
-		zetes_array_element_t* element = array->first;
-
-		while (element && index) {
-			index--;
-		}
+	if ( stack_validate(ctx, 1) && type_validate(ctx, ZETES_TYPE_ARRAY, ctx->stack_ptr->type) && resolve(ctx, ctx->stack_ptr) ) {
+		const zetes_value_t* value = array_at(ctx->stack_ptr->variant._array, index);
 
-		if ( element ) {
+		if ( value ) {
 			zetes_value_t* slot = stack_emplace(ctx);
 
 			if ( slot ) {
-				*slot = element->value;
+				*slot = *value;
 			}
 		} else {
 			set_error(ctx, ZETES_RESULT_INDEX_OUT_OF_BOUNDS);
@@ -456,7 +975,7 @@ void zetes_array_append(zetes_t* ctx) {
 
 	zetes_value_t* array_value = ctx->stack_ptr + 1;
 
-	if (stack_validate(ctx, 2) && type_validate(ctx, ZETES_TYPE_ARRAY, array_value->type)) {
+	if (stack_validate(ctx, 2) && type_validate(ctx, ZETES_TYPE_ARRAY, array_value->type) && resolve(ctx, array_value)) {
 		zetes_array_t* array = array_value->variant._array;
 		zetes_array_element_t* element = (zetes_array_element_t*) alloc(ctx, sizeof(zetes_array_element_t));
 
@@ -471,26 +990,52 @@ void zetes_array_append(zetes_t* ctx) {
 			}
 
 			array->last = element;
+			array->size++;
 		}
 	}
 }
 
 
-size_t zetes_object_size(zetes_t* ctx) {
+void zetes_array_freeze(zetes_t* ctx) {
 	ZETES_ASSERT(ctx);
 	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
 
-	size_t size = 0;
+	if ( stack_validate(ctx, 1) && type_validate(ctx, ZETES_TYPE_ARRAY, ctx->stack_ptr->type) && resolve(ctx, ctx->stack_ptr) ) {
+		zetes_array_t* array = ctx->stack_ptr->variant._array;
 
-	if ( stack_validate(ctx, 1) && type_validate(ctx, ZETES_TYPE_ARRAY, ctx->stack_ptr->type) ) {
-		zetes_object_t* object = ctx->stack_ptr->variant._object;
-		zetes_object_member_t* member = object->first;
+		if ( array->first ) {
+			zetes_value_t* values = (zetes_value_t*) alloc(ctx, array->size * sizeof(zetes_value_t));
+
+			if ( values ) {
+				zetes_array_element_t* element = array->first;
+				size_t i = array->count;
 
-		while (member) {
-			member = member->next;
-			size++;
+				memcpy(values, array->values, array->count * sizeof(zetes_value_t));
+
+				while (element) {
+					values[i++] = element->value;
+					element = element->next;
+				}
+
+				array->values = values;
+				array->count = array->size;
+				array->first = NULL;
+				array->last = NULL;
+			}
 		}
 	}
+}
+
+
+size_t zetes_object_size(zetes_t* ctx) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+
+	size_t size = 0;
+
+	if ( stack_validate(ctx, 1) && type_validate(ctx, ZETES_TYPE_OBJECT, ctx->stack_ptr->type) && resolve(ctx, ctx->stack_ptr) ) {
+		size = ctx->stack_ptr->variant._object->size;
+	}
 
 	return size;
 }
@@ -500,13 +1045,21 @@ void zetes_object_index(zetes_t* ctx, size_t index) {
 	ZETES_ASSERT(ctx);
 	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
 
-	if ( stack_validate(ctx, 1) && type_validate(ctx, ZETES_TYPE_ARRAY, ctx->stack_ptr->type) ) {
+	if ( stack_validate(ctx, 1) && type_validate(ctx, ZETES_TYPE_OBJECT, ctx->stack_ptr->type) && resolve(ctx, ctx->stack_ptr) ) {
 		zetes_object_t* object = ctx->stack_ptr->variant._object;
-		zetes_object_member_t* member = object->first;
+		const zetes_object_member_t* member = NULL;
+
+		if ( index < object->count ) {
+			member = &object->members[index];
+		} else if ( index < object->size ) {
+			// set since the object was read
+			const zetes_object_element_t* element = object->first;
+
+			for (index -= object->count; index > 0; index--) {
+				element = element->next;
+			}
 
-		while (member && index) {
-			member = member->next;
-			index--;
+			member = &element->member;
 		}
 
 		if ( member ) {
@@ -520,6 +1073,7 @@ void zetes_object_index(zetes_t* ctx, size_t index) {
 
 			if ( slot ) {
 				slot->type = ZETES_TYPE_STRING;
+				slot->length = member->key_length;
 				slot->variant._string = member->key;
 			}
 		} else {
@@ -529,1132 +1083,7635 @@ void zetes_object_index(zetes_t* ctx, size_t index) {
 }
 
 
-bool zetes_object_has(zetes_t* ctx, const char* key) {
+void zetes_push_member_value(zetes_t* ctx, const zetes_object_member_t* member) {
 	ZETES_ASSERT(ctx);
 	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
-	ZETES_ASSERT(key);
-
-	bool result = false;
+	ZETES_ASSERT(member);
 
-	if ( stack_validate(ctx, 1) && type_validate(ctx, ZETES_TYPE_OBJECT, ctx->stack_ptr->type) ) {
-		zetes_object_t* object = ctx->stack_ptr->variant._object;
-		zetes_object_member_t* member = object->first;
+	// for a member already found by walking the object, which zetes_object_index() would walk to again
+	zetes_value_t* slot = stack_emplace(ctx);
 
-		while (member) {
-			if ( strcmp(member->key, key) == 0 ) {
-				result = true;
-				break;
-			}
+	if ( slot ) {
+		*slot = member->value;
+	}
+}
 
-			member = member->next;
-		}
+
+static uint32_t hash_key(const char* key, size_t key_length) {
+	// FNV-1a, zetes.hpp computes the same hash at compile time
+	const uint8_t* key_i = (const uint8_t*) key;
+	const uint8_t* key_e = key_i + key_length;
+	uint32_t hash = 2166136261UL;
+
+	while (key_i < key_e) {
+		hash = (hash ^ *key_i++) * 16777619UL;
 	}
 
-	return result;
+	return hash;
 }
 
 
+static const char* intern_key(zetes_t* ctx, const char* key, size_t key_length, uint32_t hash, bool copy) {
+	// Returns the interned copy of key, adding it to the table if it isn't there yet. When copy is
+	// set the key is duplicated into the arena first, otherwise key itself is assumed to live as long
+	// as the arena does. Without a table, or once it is three quarters full, keys are only copied.
+	zetes_intern_t* entry = NULL;
+	const char* interned;
 
-void zetes_object_get(zetes_t* ctx, const char* key) {
-	ZETES_ASSERT(ctx);
-	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
-	ZETES_ASSERT(key);
+	if ( ctx->intern_table ) {
+		uint32_t i = hash & ctx->intern_mask;
 
-	if ( stack_validate(ctx, 1) && type_validate(ctx, ZETES_TYPE_OBJECT, ctx->stack_ptr->type) ) {
-		zetes_object_t* object = ctx->stack_ptr->variant._object;
-		zetes_object_member_t* member = object->first;
+		while ( ctx->intern_table[i].key ) {
+			entry = &ctx->intern_table[i];
 
-		while (member) {
-			if ( strcmp(member->key, key) == 0 ) {
-				break;
+			if ( entry->key_hash == hash && entry->key_length == key_length && memcmp(entry->key, key, key_length) == 0 ) {
+				return entry->key;
 			}
 
-			member = member->next;
+			i = (i + 1) & ctx->intern_mask;
 		}
 
-		if ( member ) {
-			zetes_value_t* slot = stack_emplace(ctx);
+		entry = (ctx->intern_count * 4 < ((size_t) ctx->intern_mask + 1) * 3) ? &ctx->intern_table[i] : NULL;
+	}
 
-			if ( slot ) {
-				*slot = member->value;
-			}
-		} else {
-			set_error(ctx, ZETES_RESULT_KEY_NOT_FOUND);
-		}
+	interned = copy ? copy_string(ctx, key, key_length) : key;
+
+	if ( interned && entry ) {
+		entry->key = interned;
+		entry->key_length = (uint32_t) key_length;
+		entry->key_hash = hash;
+		ctx->intern_count++;
 	}
+
+	return interned;
 }
 
 
-void zetes_object_set(zetes_t* ctx, const char* key) {
+void zetes_enable_interning(zetes_t* ctx, size_t capacity) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+	ZETES_ASSERT(capacity > 0);
+	ZETES_ASSERT(ctx->buffer_ptr == ctx->buffer_base);
+
+	size_t size = 1;
+	zetes_intern_t* table;
+
+	while ( size < capacity && size <= UINT32_MAX / 2 ) {
+		size *= 2;
+	}
+
+	table = (zetes_intern_t*) alloc(ctx, size * sizeof(zetes_intern_t));
+
+	if ( table ) {
+		memset(table, 0, size * sizeof(zetes_intern_t));
+		keep_allocations(ctx);
+		ctx->intern_table = table;
+		ctx->intern_mask = (uint32_t) (size - 1);
+		ctx->intern_count = 0;
+	}
+}
+
+
+const char* zetes_intern(zetes_t* ctx, const char* key) {
 	ZETES_ASSERT(ctx);
 	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
 	ZETES_ASSERT(key);
 
-	zetes_value_t* object_value = ctx->stack_ptr + 1;
+	const char* interned = NULL;
 
-	if ( stack_validate(ctx, 2) && type_validate(ctx, ZETES_TYPE_OBJECT, object_value->type) ) {
-		zetes_object_t* object = object_value->variant._object;
-		zetes_object_member_t* member = object->first;
+	if ( ok(ctx) ) {
+		size_t key_length = strlen(key);
 
-		while (member) {
-			if ( strcmp(member->key, key) == 0 ) {
-				break;
-			}
+		interned = intern_key(ctx, key, key_length, hash_key(key, key_length), true);
+	}
 
-			member = member->next;
-		}
+	return interned;
+}
 
-		if ( member ) {
-			member->value = *(ctx->stack_ptr++);
-		} else {
-			size_t key_len = strlen(key) + 1;
-			char* new_key = (char*)alloc(ctx, key_len);
 
-			if (new_key) {
-				memcpy(new_key, key, key_len);
+static void prune_interned(zetes_t* ctx, const char* begin, const char* end) {
+	// Drops the entries whose keys lie in [begin, end), then re-seats every remaining entry so no
+	// probe sequence runs through a slot that has just been emptied. Re-seating starts just past an
+	// empty slot so that clusters wrapping around the end of the table are handled in order.
+	zetes_intern_t* table = ctx->intern_table;
+	size_t capacity = (size_t) ctx->intern_mask + 1;
+	size_t start = capacity;
+	size_t i;
+
+	for (i = 0; i < capacity; i++) {
+		if ( table[i].key && table[i].key >= begin && table[i].key < end ) {
+			table[i].key = NULL;
+			ctx->intern_count--;
+			start = i;
+		}
+	}
+
+	if ( start == capacity ) {
+		return;
+	}
 
-				member = (zetes_object_member_t*)alloc(ctx, sizeof(zetes_object_member_t));
+	for (i = 1; i < capacity; i++) {
+		zetes_intern_t* entry = &table[(start + i) & ctx->intern_mask];
 
-				if (member) {
-					member->next = NULL;
-					member->key = new_key;
-					member->value = *(ctx->stack_ptr++);
+		if ( entry->key ) {
+			zetes_intern_t moved = *entry;
+			uint32_t j = moved.key_hash & ctx->intern_mask;
 
-					if (object->last) {
-						object->last->next = member;
-					} else {
-						object->first = member;
-					}
+			entry->key = NULL;
 
-					object->last = member;
-				}
+			while ( table[j].key ) {
+				j = (j + 1) & ctx->intern_mask;
 			}
+
+			table[j] = moved;
 		}
 	}
 }
 
 
-static void object_set_with_interned_key(zetes_t* ctx, const char* key) {
+zetes_mark_t zetes_mark(const zetes_t* ctx) {
 	ZETES_ASSERT(ctx);
 	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
-	ZETES_ASSERT(key);
-
-	zetes_value_t* object_value = ctx->stack_ptr + 1;
 
-	if ( stack_validate(ctx, 2) && type_validate(ctx, ZETES_TYPE_OBJECT, object_value->type) ) {
-		zetes_object_t* object = object_value->variant._object;
-		zetes_object_member_t* member = object->first;
+	zetes_mark_t mark;
 
-		while (member) {
-			if ( strcmp(member->key, key) == 0 ) {
-				break;
-			}
+	mark.buffer_ptr = ctx->buffer_ptr;
+	mark.stack_ptr = ctx->stack_ptr;
+	mark.block = ctx->block;
 
-			member = member->next;
-		}
+	return mark;
+}
 
-		if ( member ) {
-			member->value = *(ctx->stack_ptr++);
-		} else {
-			member = (zetes_object_member_t*)alloc(ctx, sizeof(zetes_object_member_t));
 
-			if (member) {
-				member->next = NULL;
-				member->key = key;
-				member->value = *(ctx->stack_ptr++);
+void zetes_rollback(zetes_t* ctx, zetes_mark_t mark) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+	ZETES_ASSERT(mark.block != ctx->block || (char*) mark.buffer_ptr <= (char*) ctx->buffer_ptr);
+	ZETES_ASSERT((zetes_value_t*) mark.stack_ptr >= ctx->stack_ptr && (zetes_value_t*) mark.stack_ptr <= ctx->stack_end);
 
-				if (object->last) {
-					object->last->next = member;
-				} else {
-					object->first = member;
-				}
+	// Like zetes_reset(), but only releases what was allocated since the mark, along with any blocks
+	// chained on since. Containers that already existed at the mark must not have been added to (or
+	// resolved) since, as they would be left pointing into the released memory.
+	if ( ctx->intern_table ) {
+		zetes_block_t* block;
 
-				object->last = member;
-			}
+		for (block = ctx->block; block != mark.block; block = block->prev) {
+			prune_interned(ctx, (const char*) (block + 1), block_top(ctx, block));
 		}
-	}
-}
 
+		prune_interned(ctx, (const char*) mark.buffer_ptr,
+				(mark.block == ctx->block) ? (const char*) ctx->buffer_ptr : block_top(ctx, mark.block));
+	}
 
-static bool write_all(wstate_t* state, const char* buffer, size_t length) {
-	const char* buffer_i = buffer;
-	const char* buffer_e = buffer + length;
+	release_blocks(ctx, (zetes_block_t*) mark.block);
 
-	while(buffer_i < buffer_e) {
-		int result = state->write_func(buffer_i, buffer_e - buffer_i, state->user_data);
+	ctx->result = ZETES_RESULT_OK;
+	ctx->buffer_ptr = mark.buffer_ptr;
+	ctx->stack_ptr = (zetes_value_t*) mark.stack_ptr;
 
-		if ( result < 0 ) {
-			set_error(state->ctx, ZETES_RESULT_WRITE_ERROR);
-			return false;
-		} else {
-			buffer_i += result;
-		}
+	if ( ctx->reader.state != EVENT_STATE_IDLE ) {
+		ctx->buffer_end = scratch_at(ctx, ctx->reader.saved_depth);
+		ctx->reader.state = EVENT_STATE_IDLE;
 	}
 
-	return true;
+	// a streaming write may be staging in the memory just released
+	ctx->writer.state = WRITER_STATE_IDLE;
 }
 
 
-static bool write_bool(wstate_t* state, bool value) {
-	if ( value ) {
-		return write_all(state, SYMBOL_TRUE, sizeof(SYMBOL_TRUE));
-	} else {
-		return write_all(state, SYMBOL_FALSE, sizeof(SYMBOL_FALSE));
-	}
+static bool same_key(const zetes_object_member_t* member, const char* key, size_t key_length, uint32_t hash) {
+	return (member->key == key && member->key_length == key_length) || (member->key_hash == hash && member->key_length == key_length && memcmp(member->key, key, key_length) == 0);
 }
 
 
-static char* int_to_str(char* buffer_end, int value) {
-	bool neg;
+static zetes_object_member_t* find_member(const zetes_object_t* object, const char* key, size_t key_length, uint32_t hash) {
+	zetes_object_member_t* member = NULL;
 
-	if ( value < 0 ) {
-		neg = true;
-		value = -value;
+	if ( object->index ) {
+		uint32_t i = hash & object->index_mask;
+
+		while ( (member = object->index[i]) ) {
+			if ( same_key(member, key, key_length, hash) ) {
+				break;
+			}
+
+			i = (i + 1) & object->index_mask;
+		}
 	} else {
-		neg = false;
+		zetes_object_element_t* element;
+		size_t i;
+
+		for (i = 0; i < object->count; i++) {
+			if ( same_key(&object->members[i], key, key_length, hash) ) {
+				return &object->members[i];
+			}
+		}
+
+		for (element = object->first; element; element = element->next) {
+			if ( same_key(&element->member, key, key_length, hash) ) {
+				return &element->member;
+			}
+		}
 	}
 
-	do {
-		*(--buffer_end) = (char)(value % 10) + '0';
-		value /= 10;
-	} while (value > 0);
+	return member;
+}
 
-	if ( neg ) {
-		*(--buffer_end) = '-';
+
+static void index_member(zetes_object_t* object, zetes_object_member_t* member) {
+	uint32_t i = member->key_hash & object->index_mask;
+
+	while ( object->index[i] ) {
+		i = (i + 1) & object->index_mask;
 	}
 
-	return buffer_end;
+	object->index[i] = member;
 }
 
 
-static bool write_number(wstate_t* state, zetes_number_t value) {
-	char buffer[20];
-	char* buffer_i;
-	char* buffer_e = buffer + 20;
-	int int_part = (int) value;
-	int frac_part = (int) (value * 1000000);
-	int divider = 100000;
+static bool build_index(zetes_t* ctx, zetes_object_t* object, size_t size) {
+	// (Re)builds the index for at least size members at twice the load, indexing the members there
+	// are so far. Losing the race for memory just means the object stays on (or falls back to) the
+	// linear path, it isn't an error.
+	size_t capacity = object->index ? ((size_t) object->index_mask + 1) * 2 : 2 * ZETES_OBJECT_INDEX_THRESHOLD;
+	zetes_object_member_t** index;
+	zetes_object_element_t* element;
+	size_t i;
+
+	while ( capacity < size * 2 ) {
+		capacity *= 2;
+	}
 
-	buffer_i = int_to_str(buffer_e, (int) value);
+	index = (capacity <= UINT32_MAX) ? (zetes_object_member_t**) try_alloc(ctx, capacity * sizeof(zetes_object_member_t*)) : NULL;
+	object->index = index;
 
-	if ( !write_all(state, buffer_i, buffer_e - buffer_i) ) {
+	if ( !index ) {
 		return false;
 	}
 
-	buffer_i = &buffer[1];
-	buffer_e = buffer_i;
+	memset(index, 0, capacity * sizeof(zetes_object_member_t*));
+	object->index_mask = (uint32_t) (capacity - 1);
 
-	while (divider > 0) {
-		*buffer_e++ = (char)(((frac_part) / divider) % 10) + '0';
-		divider /= 10;
+	for (i = 0; i < object->count; i++) {
+		index_member(object, &object->members[i]);
 	}
 
-	while (buffer_e > buffer_i) {
-		char* c = buffer_e - 1;
-		if ( *c != '0' ) break;
-		buffer_e = c;
+	for (element = object->first; element; element = element->next) {
+		index_member(object, &element->member);
 	}
 
-	if ( buffer_e > buffer_i ) {
-		*(--buffer_i) = '.';
+	return true;
+}
+
+
+static void insert_element(zetes_t* ctx, zetes_object_t* object, zetes_object_element_t* element) {
+	element->next = NULL;
+
+	if (object->last) {
+		object->last->next = element;
+	} else {
+		object->first = element;
 	}
 
-	return write_all(state, buffer_i, buffer_e - buffer_i);
-}
+	object->last = element;
+	object->size++;
 
+	if ( object->size < ZETES_OBJECT_INDEX_THRESHOLD ) {
+		return;
+	}
 
-static bool write_escape_code(wstate_t* state, uint16_t code) {
-	static const char HEX_LUT[] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9','A', 'B', 'C', 'D', 'E', 'F'};
+	if ( object->index && object->size * 2 <= (size_t) object->index_mask + 1 ) {
+		index_member(object, &element->member);
+	} else {
+		build_index(ctx, object, object->size);
+	}
+}
 
-	char* temp = state->ctx->temp;
 
-	temp[0] = '\\';
-	temp[1] = 'u';
-	temp[2] = HEX_LUT[(code >> 12U) & 0xF];
-	temp[3] = HEX_LUT[(code >> 8U) & 0xF];
-	temp[4] = HEX_LUT[(code >> 4U) & 0xF];
-	temp[5] = HEX_LUT[(code >> 0U) & 0xF];
+bool zetes_object_has(zetes_t* ctx, const char* key) {
+	ZETES_ASSERT(key);
 
-	return write_all(state, temp, 6);
+	return zetes_object_has_n(ctx, key, strlen(key));
 }
 
 
-static bool escaped(uint8_t c) {
-	return (c < ' ') || (c > '~') || (c == '/') || (c == '"') || (c == '\\') || (c == '\'');
+bool zetes_object_has_n(zetes_t* ctx, const char* key, size_t key_length) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+	ZETES_ASSERT(key);
+
+	bool result = false;
+
+	if ( stack_validate(ctx, 1) && type_validate(ctx, ZETES_TYPE_OBJECT, ctx->stack_ptr->type) && resolve(ctx, ctx->stack_ptr) ) {
+		result = find_member(ctx->stack_ptr->variant._object, key, key_length, hash_key(key, key_length)) != NULL;
+	}
+
+	return result;
 }
 
 
-static int decode_utf8(const char* input_i, const char* input_e, uint16_t* code) {
-	// based on code placed in the public domain by Jeff Bezanson, 2005.
+void zetes_object_get(zetes_t* ctx, const char* key) {
+	ZETES_ASSERT(key);
 
-	static const uint32_t OFFSETS[6] = {
-		0x00000000UL, 0x00003080UL, 0x000E2080UL,
-		0x03C82080UL, 0xFA082080UL, 0x82082080UL
-	};
+	zetes_object_get_n(ctx, key, strlen(key));
+}
 
-	static const int8_t TRAILING[256] = {
-		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-		1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
-		2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2, 3,3,3,3,3,3,3,3,4,4,4,4,5,5,5,5
-	};
 
-	int8_t trailing = -1;
+void zetes_object_get_n(zetes_t* ctx, const char* key, size_t key_length) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+	ZETES_ASSERT(key);
 
-	if ( input_i < input_e ) {
-		uint16_t cp = 0;
+	if ( stack_validate(ctx, 1) && type_validate(ctx, ZETES_TYPE_OBJECT, ctx->stack_ptr->type) && resolve(ctx, ctx->stack_ptr) ) {
+		zetes_object_member_t* member = find_member(ctx->stack_ptr->variant._object, key, key_length, hash_key(key, key_length));
 
-		trailing = TRAILING[(uint8_t) (*input_i)];
+		if ( member ) {
+			zetes_value_t* slot = stack_emplace(ctx);
 
-		if ( input_i + trailing >= input_e ) {
-			return -1;
+			if ( slot ) {
+				*slot = member->value;
+			}
+		} else {
+			set_error(ctx, ZETES_RESULT_KEY_NOT_FOUND);
 		}
+	}
+}
 
-		switch(trailing) {
-		case 3:		cp += (uint8_t) (*input_i++); cp <<= 6U;		// fall through
-		case 2:		cp += (uint8_t) (*input_i++); cp <<= 6U;		// fall through
-		case 1:		cp += (uint8_t) (*input_i++); cp <<= 6U;		// fall through
-		case 0:		cp += (uint8_t) (*input_i++);
-		default:	break;
-		}
 
-		cp -= OFFSETS[trailing];
+static void object_insert(zetes_t* ctx, zetes_object_t* object, const char* key, size_t key_length, uint32_t hash) {
+	// adds a member for a key the object is known not to have, taking the value from the stack top
+	zetes_object_element_t* element = (zetes_object_element_t*) alloc(ctx, sizeof(zetes_object_element_t));
 
-		*code = cp;
+	if ( element ) {
+		element->member.key = key;
+		element->member.key_length = (uint32_t) key_length;
+		element->member.key_hash = hash;
+		element->member.value = *(ctx->stack_ptr++);
+
+		insert_element(ctx, object, element);
 	}
+}
 
-	return trailing + 1;
+
+void zetes_object_set(zetes_t* ctx, const char* key) {
+	ZETES_ASSERT(key);
+
+	zetes_object_set_n(ctx, key, strlen(key));
 }
 
 
-static bool write_string(wstate_t* state, const char* value) {
-	const char* str_i = value;
-	const char* str_e = str_i + strlen(value);
-	const char* str_n = str_i;
-	uint16_t code;
+void zetes_object_set_n(zetes_t* ctx, const char* key, size_t key_length) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+	ZETES_ASSERT(key);
 
-	if ( !write_all(state, SYMBOL_STRING_DELIM, sizeof(SYMBOL_STRING_DELIM)) ) {
-		return false;
-	}
+	zetes_value_t* object_value = ctx->stack_ptr + 1;
 
-	while (str_i < str_e) {
-		do {
-			if ( !escaped(*str_n) ) {
-				str_n++;
-			} else {
-				break;
-			}
-		} while (str_n < str_e);
+	if ( stack_validate(ctx, 2) && type_validate(ctx, ZETES_TYPE_OBJECT, object_value->type) && resolve(ctx, object_value) ) {
+		uint32_t hash = hash_key(key, key_length);
+		zetes_object_member_t* member = find_member(object_value->variant._object, key, key_length, hash);
 
-		if (str_i < str_n) {
-			if (!write_all(state, str_i, str_n - str_i)) {
-				return false;
+		if ( member ) {
+			member->value = *(ctx->stack_ptr++);
+		} else {
+			const char* new_key = intern_key(ctx, key, key_length, hash, true);
+
+			if ( new_key ) {
+				object_insert(ctx, object_value->variant._object, new_key, key_length, hash);
 			}
 		}
+	}
+}
 
-		str_i = str_n;
-
-		if (str_i < str_e) {
-			bool result;
-			int len = 1;
-
-			code = *str_i;
 
-			switch(code) {
-			case '"':	result = write_all(state, "\\\"", 2);		break;
-			case '\\':	result = write_all(state, "\\\\", 2);		break;
-			case '/':	result = write_all(state, "\\/", 2);		break;
-			case '\b':	result = write_all(state, "\\b", 2);		break;
-			case '\f':	result = write_all(state, "\\f", 2);		break;
-			case '\n':	result = write_all(state, "\\n", 2);		break;
-			case '\r':	result = write_all(state, "\\r", 2);		break;
-			case '\t':	result = write_all(state, "\\t", 2);		break;
+static bool emit(wstate_t* state, const char* buffer, size_t length) {
+	const char* buffer_i = buffer;
+	const char* buffer_e = buffer + length;
 
-			default:
-				len = decode_utf8(str_i, str_e, &code);
-				result = (len >= 0) && write_escape_code(state, code);
-			}
+	while(buffer_i < buffer_e) {
+		size_t remaining = buffer_e - buffer_i;
+		int result = state->write_func(buffer_i, remaining > INT_MAX ? INT_MAX : (int) remaining, state->user_data);
 
-			if ( !result ) return false;
+#if ZETES_STATS
+		state->ctx->stats.write_calls++;
+		state->ctx->stats.write_bytes += result > 0 ? (size_t) result : 0;
+#endif
 
-			str_i += len;
+		if ( result < 0 ) {
+			set_error(state->ctx, ZETES_RESULT_WRITE_ERROR);
+			return false;
+		} else {
+			buffer_i += result;
+			state->emitted += result;
 		}
-
-		str_n = str_i;
 	}
 
-	return write_all(state, SYMBOL_STRING_DELIM, sizeof(SYMBOL_STRING_DELIM));
+	return true;
 }
 
 
-static bool write_array(wstate_t* state, const zetes_array_t* array) {
-	const zetes_array_element_t* element = array->first;
+static bool send_segments(wstate_t* state) {
+	// hands over the segments so far, the last being whatever has been staged since the one before
+	int count;
 
-	if ( !write_all(state, SYMBOL_ARRAY_OPEN, sizeof(SYMBOL_ARRAY_OPEN)) ) {
-		return false;
+	if ( state->buffer_i > state->buffer_m ) {
+		state->segment_i->buffer = state->buffer_m;
+		state->segment_i->length = state->buffer_i - state->buffer_m;
+		state->segment_i++;
 	}
 
-	if (element) {
-		if ( !write_value(state, &(element->value)) ) {
-			return false;
-		}
+	count = (int) (state->segment_i - state->segment_b);
+	state->segment_i = state->segment_b;
+	state->buffer_i = state->buffer_b;
+	state->buffer_m = state->buffer_b;
 
-		element = element->next;
+	if ( count == 0 ) {
+		return true;
 	}
 
-	while (element) {
-		if ( !write_all(state, SYMBOL_COMMA, sizeof(SYMBOL_COMMA)) ) {
-			return false;
-		}
+#if ZETES_STATS
+	state->ctx->stats.write_calls++;
 
-		if ( !write_value(state, &(element->value)) ) {
-			return false;
-		}
+	for (int i = 0; i < count; i++) {
+		state->ctx->stats.write_bytes += state->segment_b[i].length;
+	}
+#endif
 
-		element = element->next;
+	if ( state->writev_func(state->segment_b, count, state->user_data) < 0 ) {
+		set_error(state->ctx, ZETES_RESULT_WRITE_ERROR);
+		return false;
 	}
 
-	return write_all(state, SYMBOL_ARRAY_CLOSE, sizeof(SYMBOL_ARRAY_CLOSE));
+	return true;
 }
 
 
-static bool write_member(wstate_t* state, const zetes_object_member_t* member) {
-	if ( !write_string(state, member->key) ) {
+static bool write_segment(wstate_t* state, const char* buffer, size_t length) {
+	// passes buffer by reference, so it must stay put until the segments are sent. Room is needed for
+	// the staged bytes before it, buffer itself, and those staged after it when they are sent.
+	if ( state->segment_e - state->segment_i < 3 && !send_segments(state) ) {
 		return false;
 	}
 
-	if ( !write_all(state, SYMBOL_KEY_VAL_SEPARATOR, sizeof(SYMBOL_KEY_VAL_SEPARATOR)) ) {
-		return false;
+	if ( state->buffer_i > state->buffer_m ) {
+		state->segment_i->buffer = state->buffer_m;
+		state->segment_i->length = state->buffer_i - state->buffer_m;
+		state->segment_i++;
+		state->buffer_m = state->buffer_i;
 	}
 
-	return write_value(state, &member->value);
+	state->segment_i->buffer = buffer;
+	state->segment_i->length = length;
+	state->segment_i++;
+
+	return true;
 }
 
 
-static bool write_object(wstate_t* state, const zetes_object_t* object) {
-	const zetes_object_member_t* member = object->first;
+static bool flush(wstate_t* state) {
+	bool result = true;
 
-	if ( !write_all(state, SYMBOL_OBJECT_OPEN, sizeof(SYMBOL_OBJECT_OPEN)) ) {
-		return false;
+	if ( state->segment_b ) {
+		result = send_segments(state);
+	} else if ( state->write_func && state->buffer_i > state->buffer_b ) {
+		result = emit(state, state->buffer_b, state->buffer_i - state->buffer_b);
+		state->buffer_i = state->buffer_b;
 	}
 
-	if (member) {
-		if ( !write_member(state, member) ) {
-			return false;
-		}
+	return result;
+}
 
-		member = member->next;
+
+static bool write_overflow(wstate_t* state, const char* buffer, size_t length) {
+	if ( !state->write_func && !state->segment_b ) {
+		// writing straight into the destination buffer, which is full
+		set_error(state->ctx, ZETES_RESULT_WRITE_ERROR);
+		return false;
 	}
 
-	while (member) {
-		if ( !write_all(state, SYMBOL_COMMA, sizeof(SYMBOL_COMMA)) ) {
-			return false;
-		}
+	if ( !flush(state) ) {
+		return false;
+	}
 
-		if ( !write_member(state, member) ) {
-			return false;
+	if ( length >= (size_t) (state->buffer_e - state->buffer_b) ) {
+		if ( state->segment_b ) {
+			// buffer may not last, so it goes straight out on its own
+			return write_segment(state, buffer, length) && send_segments(state);
 		}
 
-		member = member->next;
+		return emit(state, buffer, length);
 	}
 
-	return write_all(state, SYMBOL_OBJECT_CLOSE, sizeof(SYMBOL_OBJECT_CLOSE));
+	memcpy(state->buffer_i, buffer, length);
+	state->buffer_i += length;
+
+	return true;
 }
 
 
-static bool write_value(wstate_t* state, const zetes_value_t* value) {
-	switch(value->type) {
-	case ZETES_TYPE_NULL:
-		return write_all(state, SYMBOL_NULL, sizeof(SYMBOL_NULL));
+static inline bool write_all(wstate_t* state, const char* buffer, size_t length) {
+	if ( length > (size_t) (state->buffer_e - state->buffer_i) ) {
+		return write_overflow(state, buffer, length);
+	}
 
-	case ZETES_TYPE_BOOL:
-		return write_bool(state, value->variant._bool);
+	memcpy(state->buffer_i, buffer, length);
+	state->buffer_i += length;
 
-	case ZETES_TYPE_NUMBER:
-		return write_number(state, value->variant._number);
+	return true;
+}
 
-	case ZETES_TYPE_STRING:
-		return write_string(state, value->variant._string);
 
-	case ZETES_TYPE_ARRAY:
-		return write_array(state, value->variant._array);
+static bool write_run(wstate_t* state, const char* buffer, size_t length) {
+	// bytes of the value being written, which outlive the write and so can be passed by reference
+	if ( state->segment_b && length >= ZETES_WRITEV_MIN_LENGTH ) {
+		return write_segment(state, buffer, length);
+	}
 
-	case ZETES_TYPE_OBJECT:
-		return write_object(state, value->variant._object);
+	return write_all(state, buffer, length);
+}
 
-	default:
-		set_error(state->ctx, ZETES_RESULT_INVALID_STACK);
-		return false;
+
+static bool write_bool(wstate_t* state, bool value) {
+	if ( value ) {
+		return write_all(state, SYMBOL_TRUE, sizeof(SYMBOL_TRUE));
+	} else {
+		return write_all(state, SYMBOL_FALSE, sizeof(SYMBOL_FALSE));
 	}
 }
 
 
-zetes_result_t zetes_write(zetes_t* ctx, zetes_write_func_t write_func, void* user_data) {
-	ZETES_ASSERT(ctx);
-	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
-	ZETES_ASSERT(write_func);
+static const char DIGIT_PAIRS[200] = {
+	'0','0','0','1','0','2','0','3','0','4','0','5','0','6','0','7','0','8','0','9',
+	'1','0','1','1','1','2','1','3','1','4','1','5','1','6','1','7','1','8','1','9',
+	'2','0','2','1','2','2','2','3','2','4','2','5','2','6','2','7','2','8','2','9',
+	'3','0','3','1','3','2','3','3','3','4','3','5','3','6','3','7','3','8','3','9',
+	'4','0','4','1','4','2','4','3','4','4','4','5','4','6','4','7','4','8','4','9',
+	'5','0','5','1','5','2','5','3','5','4','5','5','5','6','5','7','5','8','5','9',
+	'6','0','6','1','6','2','6','3','6','4','6','5','6','6','6','7','6','8','6','9',
+	'7','0','7','1','7','2','7','3','7','4','7','5','7','6','7','7','7','8','7','9',
+	'8','0','8','1','8','2','8','3','8','4','8','5','8','6','8','7','8','8','8','9',
+	'9','0','9','1','9','2','9','3','9','4','9','5','9','6','9','7','9','8','9','9'
+};
 
-	if ( ok(ctx) && stack_validate(ctx, 1) ) {
-		wstate_t state;
 
-		state.ctx = ctx;
-		state.write_func = write_func;
-		state.user_data = user_data;
+static char* uint_to_str(char* buffer_end, uint64_t value) {
+	while ( value >= 100 ) {
+		const char* pair = &DIGIT_PAIRS[(value % 100) * 2];
 
-		write_value(&state, ctx->stack_ptr);
+		value /= 100;
+		*(--buffer_end) = pair[1];
+		*(--buffer_end) = pair[0];
 	}
 
-	return ctx->result;
-}
-
+	if ( value >= 10 ) {
+		const char* pair = &DIGIT_PAIRS[value * 2];
 
-static int write_buffer_func(const void* buffer, int length, void* user_data) {
-	write_buffer_state_t* state = (write_buffer_state_t*) user_data;
-	size_t remaining = state->e - state->i;
-
-	if ( length > remaining ) {
-		return -1;
+		*(--buffer_end) = pair[1];
+		*(--buffer_end) = pair[0];
+	} else {
+		*(--buffer_end) = (char) value + '0';
 	}
 
-	memcpy(state->i, buffer, length);
-	state->i += length;
-
-	return length;
+	return buffer_end;
 }
 
 
-zetes_result_t zetes_write_buffer(zetes_t* ctx, char* buffer, size_t buffer_size) {
-	write_buffer_state_t state;
-
-	state.i = buffer;
-	state.e = buffer + buffer_size;
+static char* int_to_str(char* buffer_end, int64_t value) {
+	if ( value < 0 ) {
+		buffer_end = uint_to_str(buffer_end, 0 - (uint64_t) value);
+		*(--buffer_end) = '-';
+	} else {
+		buffer_end = uint_to_str(buffer_end, (uint64_t) value);
+	}
 
-	return zetes_write(ctx, write_buffer_func, &state);
+	return buffer_end;
 }
 
 
-static int is_end_of_input(char c)
-{
-	return ( c == '\0' );
-}
+// Shortest round-trip formatting of floating point numbers, based on the Grisu2 algorithm
+// by Florian Loitsch ("Printing Floating-Point Numbers Quickly and Accurately with Integers",
+// PLDI 2010) as adapted by Niels Lohmann. Output always reads back to the same value and is
+// the shortest possible representation for roughly 99.9% of inputs, one digit longer otherwise.
 
+typedef struct {
+	uint64_t f;
+	int e;
+} diyfp_t;
 
-static int is_whitespace(char c)
-{
-	return (c == 0x20ul) || (c == 0x0Aul) || (c == 0x0Dul) || (c == 0x09ul);
+
+typedef struct {
+	uint64_t f;
+	int16_t e;
+	int16_t k;
+} cached_power_t;
+
+
+static const cached_power_t CACHED_POWERS[79] = {
+	{ 0xAB70FE17C79AC6CAULL, -1060, -300 }, { 0xFF77B1FCBEBCDC4FULL, -1034, -292 },
+	{ 0xBE5691EF416BD60CULL, -1007, -284 }, { 0x8DD01FAD907FFC3CULL,  -980, -276 },
+	{ 0xD3515C2831559A83ULL,  -954, -268 }, { 0x9D71AC8FADA6C9B5ULL,  -927, -260 },
+	{ 0xEA9C227723EE8BCBULL,  -901, -252 }, { 0xAECC49914078536DULL,  -874, -244 },
+	{ 0x823C12795DB6CE57ULL,  -847, -236 }, { 0xC21094364DFB5637ULL,  -821, -228 },
+	{ 0x9096EA6F3848984FULL,  -794, -220 }, { 0xD77485CB25823AC7ULL,  -768, -212 },
+	{ 0xA086CFCD97BF97F4ULL,  -741, -204 }, { 0xEF340A98172AACE5ULL,  -715, -196 },
+	{ 0xB23867FB2A35B28EULL,  -688, -188 }, { 0x84C8D4DFD2C63F3BULL,  -661, -180 },
+	{ 0xC5DD44271AD3CDBAULL,  -635, -172 }, { 0x936B9FCEBB25C996ULL,  -608, -164 },
+	{ 0xDBAC6C247D62A584ULL,  -582, -156 }, { 0xA3AB66580D5FDAF6ULL,  -555, -148 },
+	{ 0xF3E2F893DEC3F126ULL,  -529, -140 }, { 0xB5B5ADA8AAFF80B8ULL,  -502, -132 },
+	{ 0x87625F056C7C4A8BULL,  -475, -124 }, { 0xC9BCFF6034C13053ULL,  -449, -116 },
+	{ 0x964E858C91BA2655ULL,  -422, -108 }, { 0xDFF9772470297EBDULL,  -396, -100 },
+	{ 0xA6DFBD9FB8E5B88FULL,  -369,  -92 }, { 0xF8A95FCF88747D94ULL,  -343,  -84 },
+	{ 0xB94470938FA89BCFULL,  -316,  -76 }, { 0x8A08F0F8BF0F156BULL,  -289,  -68 },
+	{ 0xCDB02555653131B6ULL,  -263,  -60 }, { 0x993FE2C6D07B7FACULL,  -236,  -52 },
+	{ 0xE45C10C42A2B3B06ULL,  -210,  -44 }, { 0xAA242499697392D3ULL,  -183,  -36 },
+	{ 0xFD87B5F28300CA0EULL,  -157,  -28 }, { 0xBCE5086492111AEBULL,  -130,  -20 },
+	{ 0x8CBCCC096F5088CCULL,  -103,  -12 }, { 0xD1B71758E219652CULL,   -77,   -4 },
+	{ 0x9C40000000000000ULL,   -50,    4 }, { 0xE8D4A51000000000ULL,   -24,   12 },
+	{ 0xAD78EBC5AC620000ULL,     3,   20 }, { 0x813F3978F8940984ULL,    30,   28 },
+	{ 0xC097CE7BC90715B3ULL,    56,   36 }, { 0x8F7E32CE7BEA5C70ULL,    83,   44 },
+	{ 0xD5D238A4ABE98068ULL,   109,   52 }, { 0x9F4F2726179A2245ULL,   136,   60 },
+	{ 0xED63A231D4C4FB27ULL,   162,   68 }, { 0xB0DE65388CC8ADA8ULL,   189,   76 },
+	{ 0x83C7088E1AAB65DBULL,   216,   84 }, { 0xC45D1DF942711D9AULL,   242,   92 },
+	{ 0x924D692CA61BE758ULL,   269,  100 }, { 0xDA01EE641A708DEAULL,   295,  108 },
+	{ 0xA26DA3999AEF774AULL,   322,  116 }, { 0xF209787BB47D6B85ULL,   348,  124 },
+	{ 0xB454E4A179DD1877ULL,   375,  132 }, { 0x865B86925B9BC5C2ULL,   402,  140 },
+	{ 0xC83553C5C8965D3DULL,   428,  148 }, { 0x952AB45CFA97A0B3ULL,   455,  156 },
+	{ 0xDE469FBD99A05FE3ULL,   481,  164 }, { 0xA59BC234DB398C25ULL,   508,  172 },
+	{ 0xF6C69A72A3989F5CULL,   534,  180 }, { 0xB7DCBF5354E9BECEULL,   561,  188 },
+	{ 0x88FCF317F22241E2ULL,   588,  196 }, { 0xCC20CE9BD35C78A5ULL,   614,  204 },
+	{ 0x98165AF37B2153DFULL,   641,  212 }, { 0xE2A0B5DC971F303AULL,   667,  220 },
+	{ 0xA8D9D1535CE3B396ULL,   694,  228 }, { 0xFB9B7CD9A4A7443CULL,   720,  236 },
+	{ 0xBB764C4CA7A44410ULL,   747,  244 }, { 0x8BAB8EEFB6409C1AULL,   774,  252 },
+	{ 0xD01FEF10A657842CULL,   800,  260 }, { 0x9B10A4E5E9913129ULL,   827,  268 },
+	{ 0xE7109BFBA19C0C9DULL,   853,  276 }, { 0xAC2820D9623BF429ULL,   880,  284 },
+	{ 0x80444B5E7AA7CF85ULL,   907,  292 }, { 0xBF21E44003ACDD2DULL,   933,  300 },
+	{ 0x8E679C2F5E44FF8FULL,   960,  308 }, { 0xD433179D9C8CB841ULL,   986,  316 },
+	{ 0x9E19DB92B4E31BA9ULL,  1013,  324 },
+};
+
+
+static diyfp_t diyfp_make(uint64_t f, int e) {
+	diyfp_t x;
+
+	x.f = f;
+	x.e = e;
+
+	return x;
 }
 
 
-static int is_control(char c)
-{
-	return ( c >= 0 && c < ' ' );
-}
+static diyfp_t diyfp_mul(diyfp_t x, diyfp_t y) {
+	const uint64_t u_lo = x.f & 0xFFFFFFFFU;
+	const uint64_t u_hi = x.f >> 32U;
+	const uint64_t v_lo = y.f & 0xFFFFFFFFU;
+	const uint64_t v_hi = y.f >> 32U;
 
+	const uint64_t p0 = u_lo * v_lo;
+	const uint64_t p1 = u_lo * v_hi;
+	const uint64_t p2 = u_hi * v_lo;
+	const uint64_t p3 = u_hi * v_hi;
 
-static int is_key_val_separator(char c)
-{
-	return ( c == ':' );
-}
+	uint64_t q = (p0 >> 32U) + (p1 & 0xFFFFFFFFU) + (p2 & 0xFFFFFFFFU);
 
+	q += (uint64_t) 1 << 31U;	// round, ties up
 
-static int is_comma(char c)
-{
-	return ( c == ',' );
+	return diyfp_make(p3 + (p2 >> 32U) + (p1 >> 32U) + (q >> 32U), x.e + y.e + 64);
 }
 
 
-static int is_object_open(char c)
-{
-	return ( c == '{' );
+static diyfp_t diyfp_normalize(diyfp_t x) {
+	while ( (x.f >> 63U) == 0 ) {
+		x.f <<= 1U;
+		x.e--;
+	}
+
+	return x;
 }
 
 
-static int is_object_close(char c)
-{
-	return ( c == '}' );
-}
+static int find_largest_pow10(uint32_t n, uint32_t* pow10) {
+	static const uint32_t POWERS[10] = {
+		1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+	};
 
+	int digits = 10;
 
-static int is_array_open(char c)
-{
-	return ( c == '[' );
-}
+	while ( digits > 1 && n < POWERS[digits - 1] ) {
+		digits--;
+	}
 
+	*pow10 = POWERS[digits - 1];
 
-static int is_array_close(char c)
-{
-	return ( c == ']' );
+	return digits;
 }
 
 
-static int is_quote(char c)
-{
-	return ( c == '"' );
+static void grisu2_round(char* buffer, int length, uint64_t dist, uint64_t delta, uint64_t rest, uint64_t ten_k) {
+	while ( rest < dist && delta - rest >= ten_k &&
+			(rest + ten_k < dist || dist - rest > rest + ten_k - dist) ) {
+		buffer[length - 1]--;
+		rest += ten_k;
+	}
 }
 
 
-static int is_escape(char c)
-{
-	return ( c == '\\' );
-}
+static int grisu2(char* buffer, int* decimal_exponent, diyfp_t m_minus, diyfp_t v, diyfp_t m_plus) {
+	// keep the scaled exponent within [ALPHA, GAMMA] so the integral part fits in 32 bits
+	static const int ALPHA = -60;
 
+	const int f = ALPHA - m_plus.e - 1;
+	const int k = (f * 78913) / (1 << 18) + (f > 0);
+	const cached_power_t* cached = &CACHED_POWERS[(300 + k + 7) / 8];
+	const diyfp_t c_minus_k = diyfp_make(cached->f, cached->e);
 
-static int is_digit(char c)
-{
-	return ( c >= '0' && c <= '9' );
-}
+	const diyfp_t w = diyfp_mul(v, c_minus_k);
+	const diyfp_t w_minus = diyfp_mul(m_minus, c_minus_k);
+	const diyfp_t w_plus = diyfp_mul(m_plus, c_minus_k);
 
+	// shrink the interval by one ulp on each side to stay clear of the imprecise boundaries
+	const diyfp_t lo = diyfp_make(w_minus.f + 1, w_minus.e);
+	const diyfp_t hi = diyfp_make(w_plus.f - 1, w_plus.e);
 
-static int is_zero(char c)
-{
-	return (c == '0' );
-}
+	uint64_t delta = hi.f - lo.f;
+	uint64_t dist = hi.f - w.f;
 
+	const int one_e = -hi.e;
+	const uint64_t one_f = (uint64_t) 1 << one_e;
 
-static int is_digit_1_to_9(char c)
-{
-	return ( c >= '1' && c <= '9' );
-}
+	uint32_t p1 = (uint32_t) (hi.f >> one_e);
+	uint64_t p2 = hi.f & (one_f - 1);
+	uint32_t pow10;
+	int n = find_largest_pow10(p1, &pow10);
+	int length = 0;
+	int m = 0;
 
+	*decimal_exponent = -cached->k;
 
-static int is_lower_hex(char c)
-{
-	return ( c >= 'a' && c <= 'f' );
-}
+	while ( n > 0 ) {
+		const uint32_t d = p1 / pow10;
+		uint64_t rest;
 
+		p1 %= pow10;
+		buffer[length++] = (char) ('0' + d);
+		n--;
 
-static int is_upper_hex(char c)
-{
-	return ( c >= 'A' && c <= 'F' );
-}
+		rest = ((uint64_t) p1 << one_e) + p2;
 
+		if ( rest <= delta ) {
+			*decimal_exponent += n;
+			grisu2_round(buffer, length, dist, delta, rest, (uint64_t) pow10 << one_e);
+			return length;
+		}
 
-static int is_minus(char c)
-{
-	return ( c == '-' );
-}
+		pow10 /= 10;
+	}
 
+	for (;;) {
+		p2 *= 10;
+		buffer[length++] = (char) ('0' + (p2 >> one_e));
+		p2 &= one_f - 1;
+		m++;
 
-static int is_plus(char c)
-{
-	return ( c == '+' );
-}
+		delta *= 10;
+		dist *= 10;
 
+		if ( p2 <= delta ) {
+			break;
+		}
+	}
 
-static int is_exponent_delimiter(char c)
-{
-	return ( c == 'e' ) || ( c == 'E' );
+	*decimal_exponent -= m;
+	grisu2_round(buffer, length, dist, delta, p2, one_f);
+
+	return length;
 }
 
 
-static int is_decimal_point(char c)
-{
-	return ( c == '.' );
-}
+static int shortest_digits(char* buffer, int* decimal_exponent, uint64_t fraction, int exponent, int precision, int bias) {
+	const uint64_t hidden_bit = (uint64_t) 1 << (precision - 1);
+	const int min_exponent = 1 - bias;
 
+	diyfp_t v;
+	diyfp_t m_minus;
+	diyfp_t m_plus;
 
-static char next_char(rstate_t* state) {
-	char c;
+	if ( exponent == 0 ) {
+		v = diyfp_make(fraction, min_exponent);
+	} else {
+		v = diyfp_make(fraction + hidden_bit, exponent - bias);
+	}
 
-	if ( state->prev_char ) {
-		c = state->prev_char;
-		state->prev_char = 0;
+	// the lower boundary is closer when the significand is a power of two (and not the smallest normal)
+	if ( fraction == 0 && exponent > 1 ) {
+		m_minus = diyfp_make(4 * v.f - 1, v.e - 2);
 	} else {
-		if (state->buffer_i >= state->buffer_e) {
-			int n_read;
+		m_minus = diyfp_make(2 * v.f - 1, v.e - 1);
+	}
 
-			n_read = state->read_func(state->ctx->temp, ZETES_TEMP_BUFFER_SIZE, state->user_data);
+	m_plus = diyfp_normalize(diyfp_make(2 * v.f + 1, v.e - 1));
+	m_minus = diyfp_make(m_minus.f << (m_minus.e - m_plus.e), m_plus.e);
 
-			if (n_read < 0) {
-				set_error(state->ctx, ZETES_RESULT_READ_ERROR);
-				return 0;
-			}
+	return grisu2(buffer, decimal_exponent, m_minus, diyfp_normalize(v), m_plus);
+}
 
-			state->buffer_i = state->ctx->temp;
-			state->buffer_e = state->buffer_i + n_read;
 
-			if (n_read == 0) {
-				return 0;
-			}
-		}
+static char* format_digits(char* out, const char* digits, int length, int decimal_exponent, int max_exponent) {
+	// n is the position of the decimal point relative to the start of the digits
+	const int n = length + decimal_exponent;
 
-		c = *(state->buffer_i++);
+	if ( length <= n && n <= max_exponent ) {
+		// digits followed by zeros, e.g. 1234500
+		memcpy(out, digits, length);
+		memset(out + length, '0', n - length);
+		return out + n;
 	}
 
-	return c;
-}
+	if ( 0 < n && n <= max_exponent ) {
+		// decimal point within the digits, e.g. 1234.5
+		memcpy(out, digits, n);
+		out[n] = '.';
+		memcpy(out + n + 1, digits + n, length - n);
+		return out + length + 1;
+	}
 
+	if ( -4 < n && n <= 0 ) {
+		// leading zeros after the decimal point, e.g. 0.0012345
+		out[0] = '0';
+		out[1] = '.';
+		memset(out + 2, '0', -n);
+		memcpy(out + 2 - n, digits, length);
+		return out + 2 - n + length;
+	}
 
-static void putback_char(rstate_t* state, char c) {
-	state->prev_char = c;
-}
+	// exponent notation, e.g. 1.2345e+21
+	*out++ = digits[0];
 
+	if ( length > 1 ) {
+		*out++ = '.';
+		memcpy(out, digits + 1, length - 1);
+		out += length - 1;
+	}
 
-static void append_string(rstate_t* state, char c) {
-	zetes_t* ctx = state->ctx;
-	char* buffer_i = (char*) (ctx->buffer_ptr);
-	char* buffer_e = (char*) (ctx->buffer_end);
+	*out++ = 'e';
 
-	if ( buffer_i >= buffer_e ) {
-		set_error(state->ctx, ZETES_RESULT_OUT_OF_MEMORY);
+	if ( n - 1 < 0 ) {
+		*out++ = '-';
 	} else {
-		*buffer_i++ = c;
-		ctx->buffer_ptr = buffer_i;
+		*out++ = '+';
 	}
-}
 
+	{
+		char exponent[8];
+		char* exponent_e = exponent + sizeof(exponent);
+		char* exponent_i = uint_to_str(exponent_e, (uint64_t) (n - 1 < 0 ? 1 - n : n - 1));
 
-static void lex_string(rstate_t* state) {
-	zetes_t* ctx = state->ctx;
-	char* str = (char*) (ctx->buffer_ptr);
-	char c;
-	int n;
-	uint16_t code_point;
-	uint8_t bits;
+		memcpy(out, exponent_i, exponent_e - exponent_i);
+		out += exponent_e - exponent_i;
+	}
 
-	for (;;) {
-		c = next_char(state);
+	return out;
+}
 
-		if ( is_end_of_input(c) ) {
-			set_error(ctx, ZETES_RESULT_UNEXPECTED_END_OF_INPUT);
-			return;
-		} else if ( is_control(c) ) {
-			set_error(ctx, ZETES_RESULT_INVALID_CHARACTER);
-			return;
-		} else if ( is_quote(c) ) {
-			append_string(state, '\0');
 
-			state->token_type = TOKEN_TYPE_LITERAL;
-			state->token_value.type = ZETES_TYPE_STRING;
-			state->token_value.variant._string = str;
+static bool write_int(wstate_t* state, zetes_int_t value) {
+	char buffer[24];
+	char* buffer_e = buffer + sizeof(buffer);
+	char* buffer_i = int_to_str(buffer_e, (int64_t) value);
 
-			break;
-		} else if ( is_escape(c) ) {
-			char* buffer_i = (char*) (ctx->buffer_ptr);
-			char* buffer_e = (char*) (ctx->buffer_end);
+	return write_all(state, buffer_i, buffer_e - buffer_i);
+}
 
-			c = next_char(state);
 
-			switch(c) {
-			case '"':	append_string(state, '"');		break;
-			case '\\':	append_string(state, '\\');		break;
-			case '/': 	append_string(state, '/');		break;
-			case 'b': 	append_string(state, '\b');		break;
-			case 'f': 	append_string(state, '\f');		break;
-			case 'n': 	append_string(state, '\n');		break;
-			case 'r': 	append_string(state, '\r');		break;
-			case 't': 	append_string(state, '\t');		break;
+static bool write_number(wstate_t* state, zetes_number_t value) {
+	char buffer[32];
+	char* buffer_i;
+	char* buffer_e = buffer + sizeof(buffer);
+	char digits[20];
+	int length;
+	int decimal_exponent;
+	double d;
+
+	if ( (zetes_number_t) 0.5 == 0 ) {
+		// ZETES_NUMBER_TYPE is an integer type
+		buffer_i = int_to_str(buffer_e, (int64_t) value);
+		return write_all(state, buffer_i, buffer_e - buffer_i);
+	}
 
-			case 'u':
-				code_point = 0;
+	d = (double) value;
 
-				for (n = 0; n < 4; n++) {
-					c = next_char(state);
+	if ( d != d || d - d != 0 ) {
+		// JSON has no representation for NaN or infinity
+		return write_all(state, SYMBOL_NULL, sizeof(SYMBOL_NULL));
+	}
 
-					if ( is_digit(c) ) {
-						code_point = (code_point << 4U) | (c - '0');
-					} else if ( is_lower_hex(c) ) {
-						code_point = (code_point << 4U) | (c - 'a' + 10);
-					} else if ( is_upper_hex(c) ) {
-						code_point = (code_point << 4U) | (c - 'A' + 10);
-					} else {
-						state->ctx->result = ZETES_RESULT_INVALID_STRING;
-						return;
-					}
-				}
+	if ( d > -9007199254740992.0 && d < 9007199254740992.0 && d == (double) (int64_t) d ) {
+		// exact integers below 2^53 are printed directly
+		buffer_i = int_to_str(buffer_e, (int64_t) d);
 
-				if ( code_point < 0x80UL ) {
-					bits = 0x00;
-					n = 1;
-				} else if ( code_point < 0x800UL ) {
-					bits = 0xC0;
-					n = 2;
-				} else if ( code_point < 0x10000UL ) {
-					bits = 0xE0;
-					n = 3;
-				} else if ( code_point < 0x200000UL ) {
-					bits = 0xF0;
-					n = 4;
-				} else if ( code_point < 0x4000000UL ) {
-					bits = 0xF8;
-					n = 5;
-				} else {
-					bits = 0xFC;
-					n = 6;
-				}
+		if ( d == 0 ) {
+			uint64_t bits;
 
-				if ( buffer_i + n >= buffer_e ) {
-					set_error(ctx, ZETES_RESULT_OUT_OF_MEMORY);
-					return;
-				}
+			memcpy(&bits, &d, sizeof(bits));
 
-				for (int len = n - 1; len > 0; --len) {
-					buffer_i[len] = (char) ((code_point & 0x3FUL) | 0x80UL);
-					code_point >>= 6U;
-				}
+			if ( bits >> 63U ) {
+				*(--buffer_i) = '-';
+			}
+		}
 
-				buffer_i[0] = (char) (code_point | bits);
-				state->ctx->buffer_ptr += n;
-				break;
+		return write_all(state, buffer_i, buffer_e - buffer_i);
+	}
 
-			default:
-				set_error(ctx, ZETES_RESULT_INVALID_STRING);
-				return;
-			}
+	buffer_i = buffer;
 
-		} else {
-			append_string(state, c);
+	if ( d < 0 ) {
+		*buffer_i++ = '-';
+	}
+
+	if ( sizeof(zetes_number_t) == sizeof(float) ) {
+		float f = (float) value;
+		uint32_t bits;
+
+		memcpy(&bits, &f, sizeof(bits));
+		length = shortest_digits(digits, &decimal_exponent, bits & 0x7FFFFFU, (bits >> 23U) & 0xFFU, 24, 150);
+		buffer_e = format_digits(buffer_i, digits, length, decimal_exponent, 6);
+	} else {
+		uint64_t bits;
+
+		memcpy(&bits, &d, sizeof(bits));
+		length = shortest_digits(digits, &decimal_exponent, bits & 0xFFFFFFFFFFFFFULL, (int) ((bits >> 52U) & 0x7FFU), 53, 1075);
+		buffer_e = format_digits(buffer_i, digits, length, decimal_exponent, 15);
+	}
+
+	return write_all(state, buffer, buffer_e - buffer);
+}
+
+
+static bool write_escape_code(wstate_t* state, uint16_t code) {
+	static const char HEX_LUT[] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9','A', 'B', 'C', 'D', 'E', 'F'};
+
+	char temp[6];
+
+	temp[0] = '\\';
+	temp[1] = 'u';
+	temp[2] = HEX_LUT[(code >> 12U) & 0xF];
+	temp[3] = HEX_LUT[(code >> 8U) & 0xF];
+	temp[4] = HEX_LUT[(code >> 4U) & 0xF];
+	temp[5] = HEX_LUT[(code >> 0U) & 0xF];
+
+	return write_all(state, temp, 6);
+}
+
+
+#if ZETES_SIMD
+// Block scanners used to find the end of a run of string bytes that can be copied verbatim. They
+// only guarantee that every block they step over is clean; the byte-wise loops that follow them
+// locate the exact position.
+
+#define SWAR_ONES		0x0101010101010101ULL
+#define SWAR_HIGHS		0x8080808080808080ULL
+
+
+static uint64_t swar_load(const char* p) {
+	uint64_t v;
+
+	memcpy(&v, p, sizeof(v));
+
+	return v;
+}
+
+
+static uint64_t swar_has_byte(uint64_t v, uint8_t c) {
+	uint64_t x = v ^ (SWAR_ONES * c);
+
+	return (x - SWAR_ONES) & ~x & SWAR_HIGHS;
+}
+
+
+static uint64_t swar_has_less(uint64_t v, uint8_t c) {
+	return (v - (SWAR_ONES * c)) & ~v & SWAR_HIGHS;
+}
+
+
+static const char* scan_plain(const char* i, const char* e) {
+	// skips blocks containing no quote, backslash or control character
+#if defined(ZETES_SIMD_SSE2)
+	const __m128i quote = _mm_set1_epi8('"');
+	const __m128i escape = _mm_set1_epi8('\\');
+	const __m128i control = _mm_set1_epi8(0x1F);
+
+	while ( e - i >= 16 ) {
+		__m128i v = _mm_loadu_si128((const __m128i*) i);
+		__m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, escape)),
+			_mm_cmpeq_epi8(_mm_max_epu8(v, control), control));
+
+		if ( _mm_movemask_epi8(m) ) {
+			break;
+		}
+
+		i += 16;
+	}
+#elif defined(ZETES_SIMD_NEON)
+	const uint8x16_t quote = vdupq_n_u8('"');
+	const uint8x16_t escape = vdupq_n_u8('\\');
+	const uint8x16_t control = vdupq_n_u8(0x20);
+
+	while ( e - i >= 16 ) {
+		uint8x16_t v = vld1q_u8((const uint8_t*) i);
+		uint8x16_t m = vorrq_u8(vorrq_u8(vceqq_u8(v, quote), vceqq_u8(v, escape)), vcltq_u8(v, control));
+
+		if ( vmaxvq_u8(m) ) {
+			break;
+		}
+
+		i += 16;
+	}
+#endif
+
+	while ( e - i >= 8 ) {
+		uint64_t v = swar_load(i);
+
+		if ( swar_has_byte(v, '"') | swar_has_byte(v, '\\') | swar_has_less(v, 0x20) ) {
+			break;
 		}
+
+		i += 8;
 	}
+
+	return i;
 }
 
 
-static void lex_number(rstate_t* state) {
-	zetes_t* ctx = state->ctx;
-	char c;
-	int is_negative = 0;
-	zetes_number_t value = 0;
-	long exp = 0;
-	zetes_number_t power;
+static const char* scan_unescaped(const char* i, const char* e) {
+	// skips blocks of printable ASCII containing nothing that escaped() would reject
+#if defined(ZETES_SIMD_SSE2)
+	const __m128i lo = _mm_set1_epi8(0x20);
+	const __m128i hi = _mm_set1_epi8(0x7E);
 
-	c = next_char(state);
+	while ( e - i >= 16 ) {
+		__m128i v = _mm_loadu_si128((const __m128i*) i);
+		__m128i ok = _mm_and_si128(_mm_cmpeq_epi8(_mm_max_epu8(v, lo), v), _mm_cmpeq_epi8(_mm_min_epu8(v, hi), v));
+		__m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))),
+			_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('/')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\''))));
 
-	if ( is_minus(c) )
-	{
-		is_negative = 1;
-		c = next_char(state);
+		if ( _mm_movemask_epi8(_mm_andnot_si128(m, ok)) != 0xFFFF ) {
+			break;
+		}
+
+		i += 16;
 	}
+#elif defined(ZETES_SIMD_NEON)
+	while ( e - i >= 16 ) {
+		uint8x16_t v = vld1q_u8((const uint8_t*) i);
+		uint8x16_t m = vorrq_u8(vcltq_u8(v, vdupq_n_u8(0x20)), vcgtq_u8(v, vdupq_n_u8(0x7E)));
 
-	if ( is_digit_1_to_9(c) )
-	{
-		do
-		{
-			value = (value * (zetes_number_t) 10.0) + (zetes_number_t) c - (zetes_number_t) '0';
-			c = next_char(state);
+		m = vorrq_u8(m, vorrq_u8(vceqq_u8(v, vdupq_n_u8('"')), vceqq_u8(v, vdupq_n_u8('\\'))));
+		m = vorrq_u8(m, vorrq_u8(vceqq_u8(v, vdupq_n_u8('/')), vceqq_u8(v, vdupq_n_u8('\''))));
 
-		} while ( is_digit(c) );
+		if ( vmaxvq_u8(m) ) {
+			break;
+		}
+
+		i += 16;
 	}
-	else if ( !is_zero(c) )
-	{
-		set_error(ctx, ZETES_RESULT_INVALID_NUMBER);
-		return;
+#endif
+
+	while ( e - i >= 8 ) {
+		uint64_t v = swar_load(i);
+
+		// bytes of 0x7F and above either carry into the high bit or already have it set
+		if ( swar_has_less(v, 0x20) | (((v + SWAR_ONES) | v) & SWAR_HIGHS) ) {
+			break;
+		}
+
+		if ( swar_has_byte(v, '"') | swar_has_byte(v, '\\') | swar_has_byte(v, '/') | swar_has_byte(v, '\'') ) {
+			break;
+		}
+
+		i += 8;
 	}
-	else
-	{
-		c = next_char(state);
+
+	return i;
+}
+#endif
+
+
+static bool escaped(uint8_t c) {
+	return (c < ' ') || (c > '~') || (c == '/') || (c == '"') || (c == '\\') || (c == '\'');
+}
+
+
+static int decode_utf8(const char* input_i, const char* input_e, uint32_t* code) {
+	// based on code placed in the public domain by Jeff Bezanson, 2005.
+
+	static const uint32_t OFFSETS[6] = {
+		0x00000000UL, 0x00003080UL, 0x000E2080UL,
+		0x03C82080UL, 0xFA082080UL, 0x82082080UL
+	};
+
+	static const int8_t TRAILING[256] = {
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+		2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2, 3,3,3,3,3,3,3,3,4,4,4,4,5,5,5,5
+	};
+
+	int8_t trailing = -1;
+
+	if ( input_i < input_e ) {
+		uint32_t cp = 0;
+
+		trailing = TRAILING[(uint8_t) (*input_i)];
+
+		if ( input_i + trailing >= input_e ) {
+			return -1;
+		}
+
+		switch(trailing) {
+		case 3:		cp += (uint8_t) (*input_i++); cp <<= 6U;		// fall through
+		case 2:		cp += (uint8_t) (*input_i++); cp <<= 6U;		// fall through
+		case 1:		cp += (uint8_t) (*input_i++); cp <<= 6U;		// fall through
+		case 0:		cp += (uint8_t) (*input_i++);
+		default:	break;
+		}
+
+		cp -= OFFSETS[trailing];
+
+		*code = cp;
 	}
 
-	if ( is_decimal_point(c) )
-	{
-		c = next_char(state);
+	return trailing + 1;
+}
 
-		if ( !is_digit(c) )
-		{
-			set_error(ctx, ZETES_RESULT_INVALID_NUMBER);
-			return;
+
+static int utf8_length(const char* i, const char* e) {
+	// length of the well formed (RFC 3629) UTF-8 sequence starting at i, or 0 if it isn't one
+	uint8_t c = (uint8_t) i[0];
+	uint8_t lo = 0x80;
+	uint8_t hi = 0xBF;
+	int n;
+
+	if ( c < 0x80 ) {
+		return 1;
+	} else if ( c < 0xC2 ) {
+		return 0;
+	} else if ( c < 0xE0 ) {
+		n = 2;
+	} else if ( c < 0xF0 ) {
+		n = 3;
+		lo = (c == 0xE0) ? 0xA0 : lo;
+		hi = (c == 0xED) ? 0x9F : hi;
+	} else if ( c < 0xF5 ) {
+		n = 4;
+		lo = (c == 0xF0) ? 0x90 : lo;
+		hi = (c == 0xF4) ? 0x8F : hi;
+	} else {
+		return 0;
+	}
+
+	if ( e - i < n || (uint8_t) i[1] < lo || (uint8_t) i[1] > hi ) {
+		return 0;
+	}
+
+	for (int k = 2; k < n; k++) {
+		if ( ((uint8_t) i[k] & 0xC0) != 0x80 ) {
+			return 0;
 		}
+	}
 
-		do
-		{
-			value = (value * (zetes_number_t) 10.0) + (zetes_number_t) c - (zetes_number_t) '0';
-			exp--;
+	return n;
+}
 
-			c = next_char(state);
 
-		} while ( is_digit(c) );
+static bool encoded_surrogate(const char* i, const char* e) {
+	// a lone surrogate as the reader stores one, which can be escaped losslessly but isn't UTF-8
+	return e - i >= 3 && (uint8_t) i[0] == 0xED && ((uint8_t) i[1] & 0xE0) == 0xA0 &&
+		((uint8_t) i[2] & 0xC0) == 0x80;
+}
+
+
+static const char* scan_raw(const char* i, const char* e) {
+	// skips bytes that can be written verbatim when UTF-8 is passed through
+	while ( i < e ) {
+		uint8_t c = (uint8_t) *i;
+
+		if ( c >= 0x80 ) {
+			int n = utf8_length(i, e);
+
+			if ( n == 0 ) {
+				break;
+			}
+
+			i += n;
+		} else if ( c < ' ' || c == '"' || c == '\\' ) {
+			break;
+		} else {
+			i++;
+		}
 	}
 
-	if ( is_exponent_delimiter(c) )
-	{
-		long exp_part = 0;
-		int exp_negative = 0;
+	return i;
+}
 
-		c = next_char(state);
 
-		if ( is_plus(c) )
-		{
-			c = next_char(state);
+static bool write_string_text(wstate_t* state, const char* value, size_t length) {
+	// the string less its quotes, escaped as needed
+	const char* str_i = value;
+	const char* str_e = str_i + length;
+	const char* str_n = str_i;
+	bool raw = state->ctx->raw_utf8;
+	uint32_t code;
+
+	while (str_i < str_e) {
+#if ZETES_SIMD
+		str_n = scan_unescaped(str_n, str_e);
+#endif
+
+		if ( raw ) {
+			str_n = scan_raw(str_n, str_e);
+		} else {
+			while ( str_n < str_e && !escaped(*str_n) ) {
+				str_n++;
+			}
 		}
-		else if ( is_minus(c) )
-		{
-			exp_negative = 1;
-			c = next_char(state);
+
+		if (str_i < str_n) {
+			if (!write_run(state, str_i, str_n - str_i)) {
+				return false;
+			}
 		}
 
-		if ( !is_digit(c) )
-		{
-			set_error(ctx, ZETES_RESULT_INVALID_NUMBER);
-			return;
+		str_i = str_n;
+
+		if (str_i < str_e) {
+			bool result;
+			int len = 1;
+
+			code = *str_i;
+
+			switch(code) {
+			case '"':	result = write_all(state, "\\\"", 2);		break;
+			case '\\':	result = write_all(state, "\\\\", 2);		break;
+			case '/':	result = write_all(state, "\\/", 2);		break;
+			case '\b':	result = write_all(state, "\\b", 2);		break;
+			case '\f':	result = write_all(state, "\\f", 2);		break;
+			case '\n':	result = write_all(state, "\\n", 2);		break;
+			case '\r':	result = write_all(state, "\\r", 2);		break;
+			case '\t':	result = write_all(state, "\\t", 2);		break;
+
+			default:
+				len = decode_utf8(str_i, str_e, &code);
+
+				// escaped or not, only well formed UTF-8 and the reader's lone surrogates are written
+				if ( len < 0 || code > 0x10FFFFUL ||
+						((uint8_t) *str_i >= 0x80 && !utf8_length(str_i, str_e) && !encoded_surrogate(str_i, str_e)) ) {
+					set_error(state->ctx, ZETES_RESULT_INVALID_STRING);
+					result = false;
+				} else if ( code >= 0x10000UL ) {
+					// outside the basic multilingual plane, so written as a surrogate pair
+					code -= 0x10000UL;
+					result = write_escape_code(state, (uint16_t) (0xD800UL | (code >> 10U))) &&
+						write_escape_code(state, (uint16_t) (0xDC00UL | (code & 0x3FFUL)));
+				} else {
+					result = write_escape_code(state, (uint16_t) code);
+				}
+			}
+
+			if ( !result ) return false;
+
+			str_i += len;
 		}
 
-		do
-		{
-			exp_part = (exp_part * 10) + (long) c - (long) '0';
-			c = next_char(state);
-		} while ( is_digit(c) );
+		str_n = str_i;
+	}
+
+	return true;
+}
+
+
+static bool write_string(wstate_t* state, const char* value, size_t length) {
+	return write_all(state, SYMBOL_STRING_DELIM, sizeof(SYMBOL_STRING_DELIM)) &&
+		write_string_text(state, value, length) &&
+		write_all(state, SYMBOL_STRING_DELIM, sizeof(SYMBOL_STRING_DELIM));
+}
+
+
+// A frame's index is its position within the contiguous values or members of its container (cursor
+// being the container), or WFRAME_ELEMENTS once it has moved on to the element list (cursor being the
+// current element). The top bit, which no position can reach, marks an object's frame, so that a
+// frame fits in a value stack slot.
+#define WFRAME_OBJECT		(~(SIZE_MAX >> 1))
+#define WFRAME_ELEMENTS		(SIZE_MAX >> 1)
+
+// frames kept on the C stack before any others are needed
+#define WFRAME_FIXED		(sizeof(((frames_t*) 0)->fixed) / sizeof(wframe_t))
+
+
+static bool write_scalar(wstate_t* state, const zetes_value_t* value) {
+	switch(value->type) {
+	case ZETES_TYPE_NULL:
+		return write_all(state, SYMBOL_NULL, sizeof(SYMBOL_NULL));
+
+	case ZETES_TYPE_BOOL:
+		return write_bool(state, value->variant._bool);
+
+	case ZETES_TYPE_NUMBER:
+		return write_number(state, value->variant._number);
+
+	case ZETES_TYPE_INTEGER:
+		return write_int(state, value->variant._int);
+
+	case ZETES_TYPE_STRING:
+		return write_string(state, value->variant._string, value->length);
+
+	default:
+		set_error(state->ctx, ZETES_RESULT_INVALID_STACK);
+		return false;
+	}
+}
+
+
+static bool write_member(wstate_t* state, const zetes_object_member_t* member) {
+	if ( !write_string(state, member->key, member->key_length) ) {
+		return false;
+	}
+
+	return write_all(state, SYMBOL_KEY_VAL_SEPARATOR, sizeof(SYMBOL_KEY_VAL_SEPARATOR));
+}
+
+
+static bool frame_is_object(const wframe_t* frame) {
+	return (frame->index & WFRAME_OBJECT) != 0;
+}
+
+
+static size_t frame_position(const wframe_t* frame) {
+	return frame->index & WFRAME_ELEMENTS;
+}
+
+
+static void frame_begin(wframe_t* frame, const void* container, const void* first, bool is_object) {
+	// starts on the contiguous values or members if there are any, otherwise on the element list
+	frame->cursor = container ? container : first;
+	frame->index = (container ? 0 : WFRAME_ELEMENTS) | (is_object ? WFRAME_OBJECT : 0);
+}
+
+
+static const zetes_object_member_t* next_frame_member(wframe_t* frame) {
+	if ( frame_position(frame) == WFRAME_ELEMENTS ) {
+		const zetes_object_element_t* element = ((const zetes_object_element_t*) frame->cursor)->next;
+
+		frame->cursor = element;
+		return element ? &element->member : NULL;
+	} else {
+		const zetes_object_t* object = (const zetes_object_t*) frame->cursor;
+
+		if ( frame_position(frame) + 1 < object->count ) {
+			frame->index++;
+			return &object->members[frame_position(frame)];
+		} else if ( object->first ) {
+			frame->cursor = object->first;
+			frame->index |= WFRAME_ELEMENTS;
+			return &object->first->member;
+		} else {
+			return NULL;
+		}
+	}
+}
+
+
+static const zetes_value_t* next_frame_value(wframe_t* frame) {
+	if ( frame_position(frame) == WFRAME_ELEMENTS ) {
+		const zetes_array_element_t* element = ((const zetes_array_element_t*) frame->cursor)->next;
+
+		frame->cursor = element;
+		return element ? &element->value : NULL;
+	} else {
+		const zetes_array_t* array = (const zetes_array_t*) frame->cursor;
+
+		if ( frame_position(frame) + 1 < array->count ) {
+			frame->index++;
+			return &array->values[frame_position(frame)];
+		} else if ( array->first ) {
+			frame->cursor = array->first;
+			frame->index |= WFRAME_ELEMENTS;
+			return &array->first->value;
+		} else {
+			return NULL;
+		}
+	}
+}
+
+
+static wframe_t* frames_end(wframe_t* frame_b, void* end) {
+	// the end of as many frames as fit from frame_b up to end
+	if ( (char*) frame_b < (char*) end ) {
+		return frame_b + ((size_t) ((char*) end - (char*) frame_b) / sizeof(wframe_t));
+	}
+
+	return frame_b;
+}
+
+
+static void init_frames(frames_t* frames, zetes_t* ctx, wframe_t* spill_b, wframe_t* spill_e) {
+	// past the fixed frames come the value stack's free slots, then the spill area, which without one
+	// given is free arena space found when first needed
+	frames->ctx = ctx;
+	frames->stack_b = (wframe_t*) ctx->stack_begin;
+	frames->stack_count = (size_t) ((char*) ctx->stack_ptr - (char*) ctx->stack_begin) / sizeof(wframe_t);
+	frames->spill_b = spill_b;
+	frames->spill_e = spill_e;
+}
+
+
+static wframe_t* frame_at(frames_t* frames, size_t depth) {
+	if ( depth < WFRAME_FIXED ) {
+		return &frames->fixed[depth];
+	}
+
+	depth -= WFRAME_FIXED;
+
+	if ( depth < frames->stack_count ) {
+		return frames->stack_b + depth;
+	}
+
+	depth -= frames->stack_count;
+
+	if ( !frames->spill_b ) {
+		zetes_t* ctx = frames->ctx;
+
+		reserve(ctx, ZETES_BLOCK_SIZE);
+		frames->spill_b = (wframe_t*) align_ptr(ctx->buffer_ptr);
+		frames->spill_e = frames_end(frames->spill_b, ctx->buffer_end);
+	}
+
+	if ( (size_t) (frames->spill_e - frames->spill_b) <= depth ) {
+		set_error(frames->ctx, ZETES_RESULT_OUT_OF_MEMORY);
+		return NULL;
+	}
+
+	return frames->spill_b + depth;
+}
+
+
+static bool write_value(wstate_t* state, const zetes_value_t* value) {
+	// Writes without recursion. Each open container has a frame tracking the position within it. The
+	// first WFRAME_FIXED are on the C stack and the next go in the value stack's free slots, of which
+	// reading any tree leaves enough, so only a tree built deeper than it could be read spills frames
+	// into free arena space.
+	frames_t frames;
+	size_t depth = 0;
+
+	init_frames(&frames, state->ctx, state->frame_b, state->frame_e);
+
+	for (;;) {
+		const zetes_array_t* array;
+		const zetes_object_t* object;
+		wframe_t* frame;
+
+		// write the value, or open a container and descend into its first value
+		switch(value->type) {
+		case ZETES_TYPE_ARRAY:
+			array = value->variant._array;
+
+			if ( array->lazy ) {
+				if ( !write_lazy(state, array->lazy, array->lazy_end) ) {
+					return false;
+				}
+
+				break;
+			}
+
+			if ( !write_all(state, SYMBOL_ARRAY_OPEN, sizeof(SYMBOL_ARRAY_OPEN)) ) {
+				return false;
+			}
+
+			if ( array->count > 0 || array->first ) {
+				if ( !(frame = frame_at(&frames, depth)) ) {
+					return false;
+				}
+
+				frame_begin(frame, array->count > 0 ? array : NULL, array->first, false);
+				value = array->count > 0 ? &array->values[0] : &array->first->value;
+				depth++;
+				continue;
+			}
+
+			if ( !write_all(state, SYMBOL_ARRAY_CLOSE, sizeof(SYMBOL_ARRAY_CLOSE)) ) {
+				return false;
+			}
+
+			break;
+
+		case ZETES_TYPE_OBJECT:
+			object = value->variant._object;
+
+			if ( object->lazy ) {
+				if ( !write_lazy(state, object->lazy, object->lazy_end) ) {
+					return false;
+				}
+
+				break;
+			}
+
+			if ( !write_all(state, SYMBOL_OBJECT_OPEN, sizeof(SYMBOL_OBJECT_OPEN)) ) {
+				return false;
+			}
+
+			if ( object->count > 0 || object->first ) {
+				const zetes_object_member_t* member;
+
+				if ( !(frame = frame_at(&frames, depth)) ) {
+					return false;
+				}
+
+				frame_begin(frame, object->count > 0 ? object : NULL, object->first, true);
+				member = object->count > 0 ? &object->members[0] : &object->first->member;
+
+				if ( !write_member(state, member) ) {
+					return false;
+				}
+
+				value = &member->value;
+				depth++;
+				continue;
+			}
+
+			if ( !write_all(state, SYMBOL_OBJECT_CLOSE, sizeof(SYMBOL_OBJECT_CLOSE)) ) {
+				return false;
+			}
+
+			break;
+
+		default:
+			if ( !write_scalar(state, value) ) {
+				return false;
+			}
+
+			break;
+		}
+
+		// the value is complete: move on to the next one, closing any containers that end with it
+		for (;;) {
+			wframe_t* top;
+
+			if ( depth == 0 ) {
+				return true;
+			}
+
+			top = frame_at(&frames, depth - 1);
+
+			if ( frame_is_object(top) ) {
+				const zetes_object_member_t* member = next_frame_member(top);
+
+				if ( member ) {
+					if ( !write_all(state, SYMBOL_COMMA, sizeof(SYMBOL_COMMA)) || !write_member(state, member) ) {
+						return false;
+					}
+
+					value = &member->value;
+					break;
+				}
+
+				if ( !write_all(state, SYMBOL_OBJECT_CLOSE, sizeof(SYMBOL_OBJECT_CLOSE)) ) {
+					return false;
+				}
+			} else {
+				value = next_frame_value(top);
+
+				if ( value ) {
+					if ( !write_all(state, SYMBOL_COMMA, sizeof(SYMBOL_COMMA)) ) {
+						return false;
+					}
+
+					break;
+				}
+
+				if ( !write_all(state, SYMBOL_ARRAY_CLOSE, sizeof(SYMBOL_ARRAY_CLOSE)) ) {
+					return false;
+				}
+			}
+
+			depth--;
+		}
+	}
+}
+
+
+void zetes_set_write_buffer(zetes_t* ctx, void* buffer, size_t buffer_size) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+	ZETES_ASSERT(buffer_size > 0);
+	ZETES_ASSERT(ctx->buffer_ptr == ctx->buffer_base);
+
+	if ( !buffer ) {
+		buffer = alloc(ctx, buffer_size);
+
+		if ( !buffer ) {
+			return;
+		}
+
+		keep_allocations(ctx);
+	}
+
+	ctx->write_buffer = (char*) buffer;
+	ctx->write_buffer_size = buffer_size;
+}
+
+
+void zetes_set_raw_utf8(zetes_t* ctx, bool enable) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+
+	// strings are then written as UTF-8 rather than ASCII, with only quotes, backslashes and control
+	// characters escaped; anything that isn't well formed UTF-8 fails with ZETES_RESULT_INVALID_STRING
+	ctx->raw_utf8 = enable;
+}
+
+
+static void init_wstate(wstate_t* state, zetes_t* ctx, zetes_write_func_t write_func, void* user_data) {
+	state->ctx = ctx;
+	state->write_func = write_func;
+	state->user_data = user_data;
+	state->emitted = 0;
+	state->writev_func = NULL;
+	state->segment_b = NULL;
+	state->segment_i = NULL;
+	state->segment_e = NULL;
+	state->buffer_m = NULL;
+	state->frame_b = NULL;
+	state->frame_e = NULL;
+}
+
+
+static void init_staging(wstate_t* state, zetes_t* ctx) {
+	size_t free_size = (char*) ctx->buffer_end - (char*) ctx->buffer_ptr;
+
+	if ( ctx->write_buffer ) {
+		state->buffer_b = ctx->write_buffer;
+		state->buffer_e = state->buffer_b + ctx->write_buffer_size;
+	} else if ( free_size > ZETES_TEMP_BUFFER_SIZE ) {
+		// nothing is allocated while writing, so the free end of the arena can be used for staging,
+		// less the top quarter which holds any frames that spill
+		state->buffer_b = (char*) ctx->buffer_ptr;
+		state->buffer_e = (char*) ctx->buffer_end - free_size / 4;
+		state->frame_b = (wframe_t*) align_ptr(state->buffer_e);
+		state->frame_e = frames_end(state->frame_b, ctx->buffer_end);
+	} else {
+		state->buffer_b = ctx->temp;
+		state->buffer_e = state->buffer_b + ZETES_TEMP_BUFFER_SIZE;
+	}
+
+	state->buffer_i = state->buffer_b;
+	state->buffer_m = state->buffer_b;
+}
+
+
+static int count_func(const void* buffer, int length, void* user_data) {
+	(void) buffer;
+	(void) user_data;
+
+	return length;
+}
+
+
+zetes_result_t zetes_write(zetes_t* ctx, zetes_write_func_t write_func, void* user_data) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+	ZETES_ASSERT(write_func);
+
+	if ( ok(ctx) && stack_validate(ctx, 1) ) {
+		wstate_t state;
+
+		init_wstate(&state, ctx, write_func, user_data);
+		init_staging(&state, ctx);
+
+		if ( write_value(&state, ctx->stack_ptr) ) {
+			flush(&state);
+		}
+	}
+
+	return ctx->result;
+}
+
+
+zetes_result_t zetes_writev(zetes_t* ctx, zetes_writev_func_t writev_func, void* user_data) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+	ZETES_ASSERT(writev_func);
+
+	if ( ok(ctx) && stack_validate(ctx, 1) ) {
+		zetes_segment_t segments[ZETES_WRITEV_SEGMENTS];
+		wstate_t state;
+
+		init_wstate(&state, ctx, NULL, user_data);
+		state.writev_func = writev_func;
+		state.segment_b = segments;
+		state.segment_i = segments;
+		state.segment_e = segments + ZETES_WRITEV_SEGMENTS;
+		init_staging(&state, ctx);
+
+		if ( write_value(&state, ctx->stack_ptr) ) {
+			flush(&state);
+		}
+	}
+
+	return ctx->result;
+}
+
+
+size_t zetes_measure(zetes_t* ctx) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+
+	if ( ok(ctx) && stack_validate(ctx, 1) ) {
+		wstate_t state;
+
+		// with nowhere to stage, every write goes straight to a sink that only counts it
+		init_wstate(&state, ctx, count_func, NULL);
+		state.buffer_b = ctx->temp;
+		state.buffer_i = ctx->temp;
+		state.buffer_e = ctx->temp;
+
+		if ( write_value(&state, ctx->stack_ptr) ) {
+			return state.emitted;
+		}
+	}
+
+	return 0;
+}
+
+
+zetes_result_t zetes_write_buffer(zetes_t* ctx, char* buffer, size_t buffer_size) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+	ZETES_ASSERT(buffer);
+
+	if ( ok(ctx) && stack_validate(ctx, 1) ) {
+		wstate_t state;
+
+		init_wstate(&state, ctx, NULL, NULL);
+		state.buffer_b = buffer;
+		state.buffer_i = buffer;
+		state.buffer_e = buffer + buffer_size;
+
+		write_value(&state, ctx->stack_ptr);
+	}
+
+	return ctx->result;
+}
+
+
+static void begin_writer(zetes_t* ctx, zetes_write_func_t write_func, void* user_data, char* buffer_b, char* buffer_e) {
+	zetes_writer_t* writer = &ctx->writer;
+
+	writer->write_func = write_func;
+	writer->user_data = user_data;
+	writer->buffer_b = buffer_b;
+	writer->buffer_i = buffer_b;
+	writer->buffer_e = buffer_e;
+	writer->emitted = 0;
+	writer->state = WRITER_STATE_FIRST_VALUE;
+	writer->depth = 0;
+}
+
+
+static void load_writer(zetes_t* ctx, wstate_t* state) {
+	const zetes_writer_t* writer = &ctx->writer;
+
+	init_wstate(state, ctx, writer->write_func, writer->user_data);
+	state->buffer_b = writer->buffer_b;
+	state->buffer_i = writer->buffer_i;
+	state->buffer_e = writer->buffer_e;
+	state->emitted = writer->emitted;
+}
+
+
+static void store_writer(zetes_t* ctx, const wstate_t* state) {
+	ctx->writer.buffer_i = state->buffer_i;
+	ctx->writer.emitted = state->emitted;
+}
+
+
+static bool writer_in_object(const zetes_writer_t* writer) {
+	size_t level = writer->depth - 1;
+
+	return writer->depth > 0 && (writer->nesting[level / 8] & (1U << (level % 8)));
+}
+
+
+static bool writer_prefix(zetes_t* ctx, wstate_t* state, bool is_key) {
+	// checks a key (or value) can go here and writes the comma before it if it needs one
+	switch(ctx->writer.state) {
+	case WRITER_STATE_VALUE:
+		if ( is_key ) break;
+		return write_all(state, SYMBOL_COMMA, sizeof(SYMBOL_COMMA));
+
+	case WRITER_STATE_FIRST_VALUE:
+		if ( is_key ) break;
+		return true;
+
+	case WRITER_STATE_KEY:
+		if ( !is_key ) break;
+		return write_all(state, SYMBOL_COMMA, sizeof(SYMBOL_COMMA));
+
+	case WRITER_STATE_FIRST_KEY:
+		if ( !is_key ) break;
+		return true;
+
+	default:
+		break;
+	}
+
+	set_error(ctx, ZETES_RESULT_SYNTAX_ERROR);
+	return false;
+}
+
+
+static void writer_next(zetes_t* ctx) {
+	// a value is complete, so what follows depends on what it was written into
+	zetes_writer_t* writer = &ctx->writer;
+
+	if ( writer->depth == 0 ) {
+		writer->state = WRITER_STATE_DONE;
+	} else if ( writer_in_object(writer) ) {
+		writer->state = WRITER_STATE_KEY;
+	} else {
+		writer->state = WRITER_STATE_VALUE;
+	}
+}
+
+
+static void writer_begin_container(zetes_t* ctx, bool is_object) {
+	zetes_writer_t* writer = &ctx->writer;
+	wstate_t state;
+
+	ZETES_ASSERT(writer->state != WRITER_STATE_IDLE);
+
+	if ( !ok(ctx) ) {
+		return;
+	}
+
+	if ( writer->depth >= ZETES_MAX_DEPTH ) {
+		set_error(ctx, ZETES_RESULT_NESTING_TOO_DEEP);
+		return;
+	}
+
+	load_writer(ctx, &state);
+
+	if ( writer_prefix(ctx, &state, false) ) {
+		if ( is_object ) {
+			write_all(&state, SYMBOL_OBJECT_OPEN, sizeof(SYMBOL_OBJECT_OPEN));
+			writer->nesting[writer->depth / 8] |= (uint8_t) (1U << (writer->depth % 8));
+		} else {
+			write_all(&state, SYMBOL_ARRAY_OPEN, sizeof(SYMBOL_ARRAY_OPEN));
+			writer->nesting[writer->depth / 8] &= (uint8_t) ~(1U << (writer->depth % 8));
+		}
+
+		writer->depth++;
+		writer->state = is_object ? WRITER_STATE_FIRST_KEY : WRITER_STATE_FIRST_VALUE;
+	}
+
+	store_writer(ctx, &state);
+}
+
+
+static void writer_end_container(zetes_t* ctx, bool is_object) {
+	zetes_writer_t* writer = &ctx->writer;
+	wstate_t state;
+
+	ZETES_ASSERT(writer->state != WRITER_STATE_IDLE);
+
+	if ( !ok(ctx) ) {
+		return;
+	}
+
+	// still waiting on a first key or element just means the container is empty
+	if ( writer->depth == 0 || writer_in_object(writer) != is_object ||
+			(is_object && writer->state != WRITER_STATE_KEY && writer->state != WRITER_STATE_FIRST_KEY) ||
+			(!is_object && writer->state != WRITER_STATE_VALUE && writer->state != WRITER_STATE_FIRST_VALUE) ) {
+		set_error(ctx, ZETES_RESULT_SYNTAX_ERROR);
+		return;
+	}
+
+	load_writer(ctx, &state);
+
+	if ( is_object ) {
+		write_all(&state, SYMBOL_OBJECT_CLOSE, sizeof(SYMBOL_OBJECT_CLOSE));
+	} else {
+		write_all(&state, SYMBOL_ARRAY_CLOSE, sizeof(SYMBOL_ARRAY_CLOSE));
+	}
+
+	store_writer(ctx, &state);
+	writer->depth--;
+	writer_next(ctx);
+}
+
+
+static void writer_scalar(zetes_t* ctx, const zetes_value_t* value) {
+	wstate_t state;
+
+	ZETES_ASSERT(ctx->writer.state != WRITER_STATE_IDLE);
+
+	if ( !ok(ctx) ) {
+		return;
+	}
+
+	load_writer(ctx, &state);
+
+	if ( writer_prefix(ctx, &state, false) && write_scalar(&state, value) ) {
+		writer_next(ctx);
+	}
+
+	store_writer(ctx, &state);
+}
+
+
+void zetes_writer_begin(zetes_t* ctx, zetes_write_func_t write_func, void* user_data) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+	ZETES_ASSERT(write_func);
+
+	// unlike zetes_write(), staging can't use the free end of the arena as the caller may allocate
+	// between calls
+	if ( ctx->write_buffer ) {
+		begin_writer(ctx, write_func, user_data, ctx->write_buffer, ctx->write_buffer + ctx->write_buffer_size);
+	} else {
+		begin_writer(ctx, write_func, user_data, ctx->temp, ctx->temp + ZETES_TEMP_BUFFER_SIZE);
+	}
+}
+
+
+void zetes_writer_begin_buffer(zetes_t* ctx, char* buffer, size_t buffer_size) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+	ZETES_ASSERT(buffer);
+
+	begin_writer(ctx, NULL, NULL, buffer, buffer + buffer_size);
+}
+
+
+void zetes_writer_begin_object(zetes_t* ctx) {
+	ZETES_ASSERT(ctx);
+
+	writer_begin_container(ctx, true);
+}
+
+
+void zetes_writer_end_object(zetes_t* ctx) {
+	ZETES_ASSERT(ctx);
+
+	writer_end_container(ctx, true);
+}
+
+
+void zetes_writer_begin_array(zetes_t* ctx) {
+	ZETES_ASSERT(ctx);
+
+	writer_begin_container(ctx, false);
+}
+
+
+void zetes_writer_end_array(zetes_t* ctx) {
+	ZETES_ASSERT(ctx);
+
+	writer_end_container(ctx, false);
+}
+
+
+void zetes_writer_key(zetes_t* ctx, const char* key) {
+	ZETES_ASSERT(key);
+
+	zetes_writer_key_n(ctx, key, strlen(key));
+}
+
+
+void zetes_writer_key_n(zetes_t* ctx, const char* key, size_t key_length) {
+	wstate_t state;
+
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->writer.state != WRITER_STATE_IDLE);
+	ZETES_ASSERT(key || key_length == 0);
+
+	if ( !ok(ctx) ) {
+		return;
+	}
+
+	load_writer(ctx, &state);
+
+	if ( writer_prefix(ctx, &state, true) && write_string(&state, key, key_length) &&
+			write_all(&state, SYMBOL_KEY_VAL_SEPARATOR, sizeof(SYMBOL_KEY_VAL_SEPARATOR)) ) {
+		ctx->writer.state = WRITER_STATE_FIRST_VALUE;
+	}
+
+	store_writer(ctx, &state);
+}
+
+
+void zetes_writer_null(zetes_t* ctx) {
+	zetes_value_t value;
+
+	ZETES_ASSERT(ctx);
+
+	value.type = ZETES_TYPE_NULL;
+	value.length = 0;
+	writer_scalar(ctx, &value);
+}
+
+
+void zetes_writer_bool(zetes_t* ctx, bool value) {
+	zetes_value_t scalar;
+
+	ZETES_ASSERT(ctx);
+
+	scalar.type = ZETES_TYPE_BOOL;
+	scalar.length = 0;
+	scalar.variant._bool = value;
+	writer_scalar(ctx, &scalar);
+}
+
+
+void zetes_writer_number(zetes_t* ctx, zetes_number_t value) {
+	zetes_value_t scalar;
+
+	ZETES_ASSERT(ctx);
+
+	scalar.type = ZETES_TYPE_NUMBER;
+	scalar.length = 0;
+	scalar.variant._number = value;
+	writer_scalar(ctx, &scalar);
+}
+
+
+void zetes_writer_int(zetes_t* ctx, zetes_int_t value) {
+	zetes_value_t scalar;
+
+	ZETES_ASSERT(ctx);
+
+	scalar.type = ZETES_TYPE_INTEGER;
+	scalar.length = 0;
+	scalar.variant._int = value;
+	writer_scalar(ctx, &scalar);
+}
+
+
+void zetes_writer_string(zetes_t* ctx, const char* value) {
+	ZETES_ASSERT(value);
+
+	zetes_writer_string_n(ctx, value, strlen(value));
+}
+
+
+void zetes_writer_string_n(zetes_t* ctx, const char* value, size_t length) {
+	wstate_t state;
+
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->writer.state != WRITER_STATE_IDLE);
+	ZETES_ASSERT(value || length == 0);
+
+	if ( !ok(ctx) ) {
+		return;
+	}
+
+	// written directly rather than through writer_scalar() as a value only holds a 32 bit length
+	load_writer(ctx, &state);
+
+	if ( writer_prefix(ctx, &state, false) && write_string(&state, value, length) ) {
+		writer_next(ctx);
+	}
+
+	store_writer(ctx, &state);
+}
+
+
+void zetes_writer_value(zetes_t* ctx) {
+	wstate_t state;
+
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->writer.state != WRITER_STATE_IDLE);
+
+	if ( !ok(ctx) || !stack_validate(ctx, 1) ) {
+		return;
+	}
+
+	load_writer(ctx, &state);
+
+	if ( writer_prefix(ctx, &state, false) && write_value(&state, ctx->stack_ptr) ) {
+		writer_next(ctx);
+	}
+
+	store_writer(ctx, &state);
+}
+
+
+zetes_result_t zetes_writer_finish(zetes_t* ctx, size_t* length) {
+	zetes_writer_t* writer;
+	wstate_t state;
+
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->writer.state != WRITER_STATE_IDLE);
+
+	writer = &ctx->writer;
+
+	if ( ok(ctx) && writer->state != WRITER_STATE_DONE ) {
+		// unclosed containers, a key without a value, or no value at all
+		set_error(ctx, ZETES_RESULT_SYNTAX_ERROR);
+	}
+
+	if ( ok(ctx) ) {
+		load_writer(ctx, &state);
+
+		if ( flush(&state) && length ) {
+			*length = state.emitted + (size_t) (state.buffer_i - state.buffer_b);
+		}
+	}
+
+	writer->state = WRITER_STATE_IDLE;
+
+	return ctx->result;
+}
+
+
+static int is_end_of_input(char c)
+{
+	return ( c == '\0' );
+}
+
+
+static int is_whitespace(char c)
+{
+	return (c == 0x20ul) || (c == 0x0Aul) || (c == 0x0Dul) || (c == 0x09ul);
+}
+
+
+static int is_control(char c)
+{
+	return ( c >= 0 && c < ' ' );
+}
+
+
+static int is_key_val_separator(char c)
+{
+	return ( c == ':' );
+}
+
+
+static int is_comma(char c)
+{
+	return ( c == ',' );
+}
+
+
+static int is_object_open(char c)
+{
+	return ( c == '{' );
+}
+
+
+static int is_object_close(char c)
+{
+	return ( c == '}' );
+}
+
+
+static int is_array_open(char c)
+{
+	return ( c == '[' );
+}
+
+
+static int is_array_close(char c)
+{
+	return ( c == ']' );
+}
+
+
+static int is_quote(char c)
+{
+	return ( c == '"' );
+}
+
+
+static int is_escape(char c)
+{
+	return ( c == '\\' );
+}
+
+
+static int is_digit(char c)
+{
+	return ( c >= '0' && c <= '9' );
+}
+
+
+static int is_zero(char c)
+{
+	return (c == '0' );
+}
+
+
+static int is_digit_1_to_9(char c)
+{
+	return ( c >= '1' && c <= '9' );
+}
+
+
+static int is_lower_hex(char c)
+{
+	return ( c >= 'a' && c <= 'f' );
+}
+
+
+static int is_upper_hex(char c)
+{
+	return ( c >= 'A' && c <= 'F' );
+}
+
+
+static int is_minus(char c)
+{
+	return ( c == '-' );
+}
+
+
+static int is_plus(char c)
+{
+	return ( c == '+' );
+}
+
+
+static int is_exponent_delimiter(char c)
+{
+	return ( c == 'e' ) || ( c == 'E' );
+}
+
+
+static int is_decimal_point(char c)
+{
+	return ( c == '.' );
+}
+
+
+static bool refill(rstate_t* state) {
+	zetes_t* ctx = state->ctx;
+	int n_read;
+
+	if ( !state->read_func ) {
+		// a fed chunk that follows on from the carry buffer
+		if ( state->next_i ) {
+			state->buffer_i = state->next_i;
+			state->buffer_e = state->next_e;
+			state->next_i = NULL;
+		}
+
+		if ( state->buffer_i < state->buffer_e ) {
+			return true;
+		}
+
+		// more input may yet be fed, so nothing concluded from this is final
+		state->starved = state->partial;
+		return false;
+	}
+
+	n_read = state->read_func(ctx->read_buffer, (int) ctx->read_buffer_size, state->user_data);
+
+#if ZETES_STATS
+	ctx->stats.read_calls++;
+	ctx->stats.read_bytes += n_read > 0 ? (size_t) n_read : 0;
+#endif
+
+	if (n_read < 0) {
+		set_error(ctx, ZETES_RESULT_READ_ERROR);
+		return false;
+	}
+
+	state->buffer_i = ctx->read_buffer;
+	state->buffer_e = state->buffer_i + n_read;
+
+	return n_read > 0;
+}
+
+
+static inline char next_char(rstate_t* state) {
+	if ( state->buffer_i >= state->buffer_e && !refill(state) ) {
+		return 0;
+	}
+
+	return *(state->buffer_i++);
+}
+
+
+static inline void putback_char(rstate_t* state, char c) {
+	// the last character returned by next_char() is always still in the current window
+	if ( c ) {
+		state->buffer_i--;
+	}
+}
+
+
+#if ZETES_DIRECT_READ
+static bool is_plain(char c) {
+	return !is_quote(c) && !is_escape(c) && !is_control(c);
+}
+#endif
+
+
+static bool grow_string(rstate_t* state, char** str, char** out_i, char** out_e, size_t size) {
+	// moves a string being lexed into the arena to a new block, with room for at least size more bytes
+	zetes_t* ctx = state->ctx;
+	size_t length = *out_i - *str;
+
+	if ( state->insitu || !grow_arena(ctx, 2 * length + size) ) {
+		set_error(ctx, ZETES_RESULT_OUT_OF_MEMORY);
+		return false;
+	}
+
+	memcpy(ctx->buffer_ptr, *str, length);
+	*str = (char*) ctx->buffer_ptr;
+	*out_i = *str + length;
+	*out_e = (char*) ctx->buffer_end;
+
+	return true;
+}
+
+
+static void lex_string(rstate_t* state) {
+	zetes_t* ctx = state->ctx;
+	char* out_i;
+	char* out_e;
+	char* str;
+	char c;
+	int n;
+	uint32_t code_point;
+	uint8_t bits;
+
+	if ( state->insitu ) {
+		out_i = state->buffer_i;
+		out_e = state->buffer_e;
+	} else {
+		out_i = (char*) (ctx->buffer_ptr);
+		out_e = (char*) (ctx->buffer_end);
+	}
+
+	str = out_i;
+
+	for (;;) {
+#if ZETES_DIRECT_READ
+		const char* run_i = state->buffer_i;
+		const char* run_e = state->buffer_e;
+
+#if ZETES_SIMD
+		run_i = scan_plain(run_i, run_e);
+#endif
+
+		while ( run_i < run_e && is_plain(*run_i) ) {
+			run_i++;
+		}
+
+		if ( run_i > state->buffer_i ) {
+			size_t run_len = run_i - state->buffer_i;
+
+			if ( run_len > (size_t) (out_e - out_i) && !grow_string(state, &str, &out_i, &out_e, run_len) ) {
+				return;
+			}
+
+			memmove(out_i, state->buffer_i, run_len);
+			out_i += run_len;
+			state->buffer_i += run_len;
+		}
+#endif
+
+		c = next_char(state);
+
+		if ( is_end_of_input(c) ) {
+			set_error(ctx, ZETES_RESULT_UNEXPECTED_END_OF_INPUT);
+			return;
+		} else if ( is_control(c) ) {
+			set_error(ctx, ZETES_RESULT_INVALID_CHARACTER);
+			return;
+		} else if ( out_i >= out_e && !grow_string(state, &str, &out_i, &out_e, 1) ) {
+			return;
+		} else if ( is_quote(c) ) {
+			if ( (size_t) (out_i - str) > UINT32_MAX ) {
+				set_error(ctx, ZETES_RESULT_OUT_OF_MEMORY);
+				return;
+			}
+
+			*out_i++ = '\0';
+
+			if ( !state->insitu ) {
+				ctx->buffer_ptr = out_i;
+
+#if ZETES_STATS
+				ctx->stats.string_bytes += (size_t) (out_i - str);
+#endif
+			}
+
+			state->token_type = TOKEN_TYPE_LITERAL;
+			state->token_value.type = ZETES_TYPE_STRING;
+			state->token_value.length = (uint32_t) (out_i - str - 1);
+			state->token_value.variant._string = str;
+
+			break;
+		} else if ( is_escape(c) ) {
+			c = next_char(state);
+
+			switch(c) {
+			case '"':	*out_i++ = '"';		break;
+			case '\\':	*out_i++ = '\\';		break;
+			case '/': 	*out_i++ = '/';		break;
+			case 'b': 	*out_i++ = '\b';		break;
+			case 'f': 	*out_i++ = '\f';		break;
+			case 'n': 	*out_i++ = '\n';		break;
+			case 'r': 	*out_i++ = '\r';		break;
+			case 't': 	*out_i++ = '\t';		break;
+
+			case 'u':
+				code_point = 0;
+
+				for (n = 0; n < 4; n++) {
+					c = next_char(state);
+
+					if ( is_digit(c) ) {
+						code_point = (code_point << 4U) | (c - '0');
+					} else if ( is_lower_hex(c) ) {
+						code_point = (code_point << 4U) | (c - 'a' + 10);
+					} else if ( is_upper_hex(c) ) {
+						code_point = (code_point << 4U) | (c - 'A' + 10);
+					} else {
+						set_error(ctx, ZETES_RESULT_INVALID_STRING);
+						return;
+					}
+				}
+
+				if ( code_point >= 0xDC00UL && code_point < 0xE000UL && out_i - str >= 3 &&
+						(uint8_t) out_i[-3] == 0xED && ((uint8_t) out_i[-2] & 0xF0) == 0xA0 ) {
+					// the second half of a surrogate pair: the first half was just written out on its
+					// own, so replace it with the four byte encoding of the pair
+					uint32_t high = 0xD000UL | (((uint32_t) out_i[-2] & 0x3FUL) << 6U) | ((uint32_t) out_i[-1] & 0x3FUL);
+
+					code_point = 0x10000UL + ((high - 0xD800UL) << 10U) + (code_point - 0xDC00UL);
+					out_i -= 3;
+				}
+
+				if ( code_point < 0x80UL ) {
+					bits = 0x00;
+					n = 1;
+				} else if ( code_point < 0x800UL ) {
+					bits = 0xC0;
+					n = 2;
+				} else if ( code_point < 0x10000UL ) {
+					bits = 0xE0;
+					n = 3;
+				} else {
+					bits = 0xF0;
+					n = 4;
+				}
+
+				if ( out_i + n >= out_e && !grow_string(state, &str, &out_i, &out_e, n + 1) ) {
+					return;
+				}
+
+				for (int len = n - 1; len > 0; --len) {
+					out_i[len] = (char) ((code_point & 0x3FUL) | 0x80UL);
+					code_point >>= 6U;
+				}
+
+				out_i[0] = (char) (code_point | bits);
+				out_i += n;
+				break;
+
+			default:
+				set_error(ctx, ZETES_RESULT_INVALID_STRING);
+				return;
+			}
+
+		} else {
+			*out_i++ = c;
+		}
+	}
+}
+
+
+#define DECIMAL_MAX_DIGITS		19
+#define DECIMAL_EXTRA_DIGITS	768
+
+
+// Decimal mantissa as accumulated by lex_digits(); at most 19 significant digits are kept,
+// which always fit in 64 bits. The digits after those are kept for the rare inputs the mantissa
+// alone can't round correctly, a byte each in free arena space growing down from extra_top until
+// the number is converted; enough of them to decide any such case exactly, beyond which, or
+// beyond the free space, it only matters whether any is non-zero.
+typedef struct {
+	uint64_t mantissa;
+	int digits;
+	int dropped;
+#if ZETES_EXACT_NUMBERS
+	int extra_count;
+	bool truncated;
+	const char* extra_top;
+#endif
+} decimal_t;
+
+
+#if ZETES_DIRECT_READ
+static uint64_t load_eight(const char* p) {
+	const uint8_t* b = (const uint8_t*) p;
+
+	return ((uint64_t) b[0]) | ((uint64_t) b[1] << 8U) | ((uint64_t) b[2] << 16U) | ((uint64_t) b[3] << 24U) |
+		((uint64_t) b[4] << 32U) | ((uint64_t) b[5] << 40U) | ((uint64_t) b[6] << 48U) | ((uint64_t) b[7] << 56U);
+}
+
+
+static bool is_eight_digits(uint64_t v) {
+	return (((v & 0xF0F0F0F0F0F0F0F0ULL) | (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4U)) ==
+		0x3333333333333333ULL);
+}
+
+
+static uint32_t parse_eight_digits(uint64_t v) {
+	const uint64_t mask = 0x000000FF000000FFULL;
+	const uint64_t mul1 = 0x000F424000000064ULL;	// 100 + (1000000ULL << 32)
+	const uint64_t mul2 = 0x0000271000000001ULL;	// 1 + (10000ULL << 32)
+
+	v -= 0x3030303030303030ULL;
+	v = (v * 10) + (v >> 8U);
+	v = (((v & mask) * mul1) + (((v >> 16U) & mask) * mul2)) >> 32U;
+
+	return (uint32_t) v;
+}
+#endif
+
+
+static char lex_digits(rstate_t* state, decimal_t* dec, char c, int* count) {
+	while ( is_digit(c) ) {
+		if ( dec->digits < DECIMAL_MAX_DIGITS ) {
+			dec->mantissa = (dec->mantissa * 10) + (uint64_t) (c - '0');
+
+			// leading zeros are not significant
+			if ( dec->mantissa ) {
+				dec->digits++;
+			}
+		} else {
+#if ZETES_EXACT_NUMBERS
+			zetes_t* ctx = state->ctx;
+
+			if ( dec->extra_count < DECIMAL_EXTRA_DIGITS && (char*) ctx->buffer_end > (char*) ctx->buffer_ptr ) {
+				ctx->buffer_end = (char*) ctx->buffer_end - 1;
+				*(char*) ctx->buffer_end = (char) (c - '0');
+				dec->extra_count++;
+			} else if ( c != '0' ) {
+				dec->truncated = true;
+			}
+#endif
+
+			dec->dropped++;
+		}
+
+		(*count)++;
+
+#if ZETES_DIRECT_READ
+		while ( dec->mantissa && dec->digits + 8 <= DECIMAL_MAX_DIGITS && state->buffer_e - state->buffer_i >= 8 ) {
+			uint64_t v = load_eight(state->buffer_i);
+
+			if ( !is_eight_digits(v) ) {
+				break;
+			}
+
+			dec->mantissa = (dec->mantissa * 100000000) + parse_eight_digits(v);
+			dec->digits += 8;
+			*count += 8;
+			state->buffer_i += 8;
+		}
+#endif
+
+		c = next_char(state);
+	}
+
+	return c;
+}
+
+
+static const double EXACT_POWERS_OF_TEN[23] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+
+#if ZETES_EXACT_NUMBERS
+
+// Eisel-Lemire conversion ("Number Parsing at a Gigabyte per Second", Daniel Lemire, 2021).
+// POWERS_OF_FIVE holds 5^q for q in [-342, 308], normalised to 128 bits.
+
+typedef struct {
+	uint64_t hi;
+	uint64_t lo;
+} u128_t;
+
+
+static const u128_t POWERS_OF_FIVE[651] = {
+	{ 0xEEF453D6923BD65AULL, 0x113FAA2906A13B3FULL },
+	{ 0x9558B4661B6565F8ULL, 0x4AC7CA59A424C507ULL },
+	{ 0xBAAEE17FA23EBF76ULL, 0x5D79BCF00D2DF649ULL },
+	{ 0xE95A99DF8ACE6F53ULL, 0xF4D82C2C107973DCULL },
+	{ 0x91D8A02BB6C10594ULL, 0x79071B9B8A4BE869ULL },
+	{ 0xB64EC836A47146F9ULL, 0x9748E2826CDEE284ULL },
+	{ 0xE3E27A444D8D98B7ULL, 0xFD1B1B2308169B25ULL },
+	{ 0x8E6D8C6AB0787F72ULL, 0xFE30F0F5E50E20F7ULL },
+	{ 0xB208EF855C969F4FULL, 0xBDBD2D335E51A935ULL },
+	{ 0xDE8B2B66B3BC4723ULL, 0xAD2C788035E61382ULL },
+	{ 0x8B16FB203055AC76ULL, 0x4C3BCB5021AFCC31ULL },
+	{ 0xADDCB9E83C6B1793ULL, 0xDF4ABE242A1BBF3DULL },
+	{ 0xD953E8624B85DD78ULL, 0xD71D6DAD34A2AF0DULL },
+	{ 0x87D4713D6F33AA6BULL, 0x8672648C40E5AD68ULL },
+	{ 0xA9C98D8CCB009506ULL, 0x680EFDAF511F18C2ULL },
+	{ 0xD43BF0EFFDC0BA48ULL, 0x0212BD1B2566DEF2ULL },
+	{ 0x84A57695FE98746DULL, 0x014BB630F7604B57ULL },
+	{ 0xA5CED43B7E3E9188ULL, 0x419EA3BD35385E2DULL },
+	{ 0xCF42894A5DCE35EAULL, 0x52064CAC828675B9ULL },
+	{ 0x818995CE7AA0E1B2ULL, 0x7343EFEBD1940993ULL },
+	{ 0xA1EBFB4219491A1FULL, 0x1014EBE6C5F90BF8ULL },
+	{ 0xCA66FA129F9B60A6ULL, 0xD41A26E077774EF6ULL },
+	{ 0xFD00B897478238D0ULL, 0x8920B098955522B4ULL },
+	{ 0x9E20735E8CB16382ULL, 0x55B46E5F5D5535B0ULL },
+	{ 0xC5A890362FDDBC62ULL, 0xEB2189F734AA831DULL },
+	{ 0xF712B443BBD52B7BULL, 0xA5E9EC7501D523E4ULL },
+	{ 0x9A6BB0AA55653B2DULL, 0x47B233C92125366EULL },
+	{ 0xC1069CD4EABE89F8ULL, 0x999EC0BB696E840AULL },
+	{ 0xF148440A256E2C76ULL, 0xC00670EA43CA250DULL },
+	{ 0x96CD2A865764DBCAULL, 0x380406926A5E5728ULL },
+	{ 0xBC807527ED3E12BCULL, 0xC605083704F5ECF2ULL },
+	{ 0xEBA09271E88D976BULL, 0xF7864A44C633682EULL },
+	{ 0x93445B8731587EA3ULL, 0x7AB3EE6AFBE0211DULL },
+	{ 0xB8157268FDAE9E4CULL, 0x5960EA05BAD82964ULL },
+	{ 0xE61ACF033D1A45DFULL, 0x6FB92487298E33BDULL },
+	{ 0x8FD0C16206306BABULL, 0xA5D3B6D479F8E056ULL },
+	{ 0xB3C4F1BA87BC8696ULL, 0x8F48A4899877186CULL },
+	{ 0xE0B62E2929ABA83CULL, 0x331ACDABFE94DE87ULL },
+	{ 0x8C71DCD9BA0B4925ULL, 0x9FF0C08B7F1D0B14ULL },
+	{ 0xAF8E5410288E1B6FULL, 0x07ECF0AE5EE44DD9ULL },
+	{ 0xDB71E91432B1A24AULL, 0xC9E82CD9F69D6150ULL },
+	{ 0x892731AC9FAF056EULL, 0xBE311C083A225CD2ULL },
+	{ 0xAB70FE17C79AC6CAULL, 0x6DBD630A48AAF406ULL },
+	{ 0xD64D3D9DB981787DULL, 0x092CBBCCDAD5B108ULL },
+	{ 0x85F0468293F0EB4EULL, 0x25BBF56008C58EA5ULL },
+	{ 0xA76C582338ED2621ULL, 0xAF2AF2B80AF6F24EULL },
+	{ 0xD1476E2C07286FAAULL, 0x1AF5AF660DB4AEE1ULL },
+	{ 0x82CCA4DB847945CAULL, 0x50D98D9FC890ED4DULL },
+	{ 0xA37FCE126597973CULL, 0xE50FF107BAB528A0ULL },
+	{ 0xCC5FC196FEFD7D0CULL, 0x1E53ED49A96272C8ULL },
+	{ 0xFF77B1FCBEBCDC4FULL, 0x25E8E89C13BB0F7AULL },
+	{ 0x9FAACF3DF73609B1ULL, 0x77B191618C54E9ACULL },
+	{ 0xC795830D75038C1DULL, 0xD59DF5B9EF6A2417ULL },
+	{ 0xF97AE3D0D2446F25ULL, 0x4B0573286B44AD1DULL },
+	{ 0x9BECCE62836AC577ULL, 0x4EE367F9430AEC32ULL },
+	{ 0xC2E801FB244576D5ULL, 0x229C41F793CDA73FULL },
+	{ 0xF3A20279ED56D48AULL, 0x6B43527578C1110FULL },
+	{ 0x9845418C345644D6ULL, 0x830A13896B78AAA9ULL },
+	{ 0xBE5691EF416BD60CULL, 0x23CC986BC656D553ULL },
+	{ 0xEDEC366B11C6CB8FULL, 0x2CBFBE86B7EC8AA8ULL },
+	{ 0x94B3A202EB1C3F39ULL, 0x7BF7D71432F3D6A9ULL },
+	{ 0xB9E08A83A5E34F07ULL, 0xDAF5CCD93FB0CC53ULL },
+	{ 0xE858AD248F5C22C9ULL, 0xD1B3400F8F9CFF68ULL },
+	{ 0x91376C36D99995BEULL, 0x23100809B9C21FA1ULL },
+	{ 0xB58547448FFFFB2DULL, 0xABD40A0C2832A78AULL },
+	{ 0xE2E69915B3FFF9F9ULL, 0x16C90C8F323F516CULL },
+	{ 0x8DD01FAD907FFC3BULL, 0xAE3DA7D97F6792E3ULL },
+	{ 0xB1442798F49FFB4AULL, 0x99CD11CFDF41779CULL },
+	{ 0xDD95317F31C7FA1DULL, 0x40405643D711D583ULL },
+	{ 0x8A7D3EEF7F1CFC52ULL, 0x482835EA666B2572ULL },
+	{ 0xAD1C8EAB5EE43B66ULL, 0xDA3243650005EECFULL },
+	{ 0xD863B256369D4A40ULL, 0x90BED43E40076A82ULL },
+	{ 0x873E4F75E2224E68ULL, 0x5A7744A6E804A291ULL },
+	{ 0xA90DE3535AAAE202ULL, 0x711515D0A205CB36ULL },
+	{ 0xD3515C2831559A83ULL, 0x0D5A5B44CA873E03ULL },
+	{ 0x8412D9991ED58091ULL, 0xE858790AFE9486C2ULL },
+	{ 0xA5178FFF668AE0B6ULL, 0x626E974DBE39A872ULL },
+	{ 0xCE5D73FF402D98E3ULL, 0xFB0A3D212DC8128FULL },
+	{ 0x80FA687F881C7F8EULL, 0x7CE66634BC9D0B99ULL },
+	{ 0xA139029F6A239F72ULL, 0x1C1FFFC1EBC44E80ULL },
+	{ 0xC987434744AC874EULL, 0xA327FFB266B56220ULL },
+	{ 0xFBE9141915D7A922ULL, 0x4BF1FF9F0062BAA8ULL },
+	{ 0x9D71AC8FADA6C9B5ULL, 0x6F773FC3603DB4A9ULL },
+	{ 0xC4CE17B399107C22ULL, 0xCB550FB4384D21D3ULL },
+	{ 0xF6019DA07F549B2BULL, 0x7E2A53A146606A48ULL },
+	{ 0x99C102844F94E0FBULL, 0x2EDA7444CBFC426DULL },
+	{ 0xC0314325637A1939ULL, 0xFA911155FEFB5308ULL },
+	{ 0xF03D93EEBC589F88ULL, 0x793555AB7EBA27CAULL },
+	{ 0x96267C7535B763B5ULL, 0x4BC1558B2F3458DEULL },
+	{ 0xBBB01B9283253CA2ULL, 0x9EB1AAEDFB016F16ULL },
+	{ 0xEA9C227723EE8BCBULL, 0x465E15A979C1CADCULL },
+	{ 0x92A1958A7675175FULL, 0x0BFACD89EC191EC9ULL },
+	{ 0xB749FAED14125D36ULL, 0xCEF980EC671F667BULL },
+	{ 0xE51C79A85916F484ULL, 0x82B7E12780E7401AULL },
+	{ 0x8F31CC0937AE58D2ULL, 0xD1B2ECB8B0908810ULL },
+	{ 0xB2FE3F0B8599EF07ULL, 0x861FA7E6DCB4AA15ULL },
+	{ 0xDFBDCECE67006AC9ULL, 0x67A791E093E1D49AULL },
+	{ 0x8BD6A141006042BDULL, 0xE0C8BB2C5C6D24E0ULL },
+	{ 0xAECC49914078536DULL, 0x58FAE9F773886E18ULL },
+	{ 0xDA7F5BF590966848ULL, 0xAF39A475506A899EULL },
+	{ 0x888F99797A5E012DULL, 0x6D8406C952429603ULL },
+	{ 0xAAB37FD7D8F58178ULL, 0xC8E5087BA6D33B83ULL },
+	{ 0xD5605FCDCF32E1D6ULL, 0xFB1E4A9A90880A64ULL },
+	{ 0x855C3BE0A17FCD26ULL, 0x5CF2EEA09A55067FULL },
+	{ 0xA6B34AD8C9DFC06FULL, 0xF42FAA48C0EA481EULL },
+	{ 0xD0601D8EFC57B08BULL, 0xF13B94DAF124DA26ULL },
+	{ 0x823C12795DB6CE57ULL, 0x76C53D08D6B70858ULL },
+	{ 0xA2CB1717B52481EDULL, 0x54768C4B0C64CA6EULL },
+	{ 0xCB7DDCDDA26DA268ULL, 0xA9942F5DCF7DFD09ULL },
+	{ 0xFE5D54150B090B02ULL, 0xD3F93B35435D7C4CULL },
+	{ 0x9EFA548D26E5A6E1ULL, 0xC47BC5014A1A6DAFULL },
+	{ 0xC6B8E9B0709F109AULL, 0x359AB6419CA1091BULL },
+	{ 0xF867241C8CC6D4C0ULL, 0xC30163D203C94B62ULL },
+	{ 0x9B407691D7FC44F8ULL, 0x79E0DE63425DCF1DULL },
+	{ 0xC21094364DFB5636ULL, 0x985915FC12F542E4ULL },
+	{ 0xF294B943E17A2BC4ULL, 0x3E6F5B7B17B2939DULL },
+	{ 0x979CF3CA6CEC5B5AULL, 0xA705992CEECF9C42ULL },
+	{ 0xBD8430BD08277231ULL, 0x50C6FF782A838353ULL },
+	{ 0xECE53CEC4A314EBDULL, 0xA4F8BF5635246428ULL },
+	{ 0x940F4613AE5ED136ULL, 0x871B7795E136BE99ULL },
+	{ 0xB913179899F68584ULL, 0x28E2557B59846E3FULL },
+	{ 0xE757DD7EC07426E5ULL, 0x331AEADA2FE589CFULL },
+	{ 0x9096EA6F3848984FULL, 0x3FF0D2C85DEF7621ULL },
+	{ 0xB4BCA50B065ABE63ULL, 0x0FED077A756B53A9ULL },
+	{ 0xE1EBCE4DC7F16DFBULL, 0xD3E8495912C62894ULL },
+	{ 0x8D3360F09CF6E4BDULL, 0x64712DD7ABBBD95CULL },
+	{ 0xB080392CC4349DECULL, 0xBD8D794D96AACFB3ULL },
+	{ 0xDCA04777F541C567ULL, 0xECF0D7A0FC5583A0ULL },
+	{ 0x89E42CAAF9491B60ULL, 0xF41686C49DB57244ULL },
+	{ 0xAC5D37D5B79B6239ULL, 0x311C2875C522CED5ULL },
+	{ 0xD77485CB25823AC7ULL, 0x7D633293366B828BULL },
+	{ 0x86A8D39EF77164BCULL, 0xAE5DFF9C02033197ULL },
+	{ 0xA8530886B54DBDEBULL, 0xD9F57F830283FDFCULL },
+	{ 0xD267CAA862A12D66ULL, 0xD072DF63C324FD7BULL },
+	{ 0x8380DEA93DA4BC60ULL, 0x4247CB9E59F71E6DULL },
+	{ 0xA46116538D0DEB78ULL, 0x52D9BE85F074E608ULL },
+	{ 0xCD795BE870516656ULL, 0x67902E276C921F8BULL },
+	{ 0x806BD9714632DFF6ULL, 0x00BA1CD8A3DB53B6ULL },
+	{ 0xA086CFCD97BF97F3ULL, 0x80E8A40ECCD228A4ULL },
+	{ 0xC8A883C0FDAF7DF0ULL, 0x6122CD128006B2CDULL },
+	{ 0xFAD2A4B13D1B5D6CULL, 0x796B805720085F81ULL },
+	{ 0x9CC3A6EEC6311A63ULL, 0xCBE3303674053BB0ULL },
+	{ 0xC3F490AA77BD60FCULL, 0xBEDBFC4411068A9CULL },
+	{ 0xF4F1B4D515ACB93BULL, 0xEE92FB5515482D44ULL },
+	{ 0x991711052D8BF3C5ULL, 0x751BDD152D4D1C4AULL },
+	{ 0xBF5CD54678EEF0B6ULL, 0xD262D45A78A0635DULL },
+	{ 0xEF340A98172AACE4ULL, 0x86FB897116C87C34ULL },
+	{ 0x9580869F0E7AAC0EULL, 0xD45D35E6AE3D4DA0ULL },
+	{ 0xBAE0A846D2195712ULL, 0x8974836059CCA109ULL },
+	{ 0xE998D258869FACD7ULL, 0x2BD1A438703FC94BULL },
+	{ 0x91FF83775423CC06ULL, 0x7B6306A34627DDCFULL },
+	{ 0xB67F6455292CBF08ULL, 0x1A3BC84C17B1D542ULL },
+	{ 0xE41F3D6A7377EECAULL, 0x20CABA5F1D9E4A93ULL },
+	{ 0x8E938662882AF53EULL, 0x547EB47B7282EE9CULL },
+	{ 0xB23867FB2A35B28DULL, 0xE99E619A4F23AA43ULL },
+	{ 0xDEC681F9F4C31F31ULL, 0x6405FA00E2EC94D4ULL },
+	{ 0x8B3C113C38F9F37EULL, 0xDE83BC408DD3DD04ULL },
+	{ 0xAE0B158B4738705EULL, 0x9624AB50B148D445ULL },
+	{ 0xD98DDAEE19068C76ULL, 0x3BADD624DD9B0957ULL },
+	{ 0x87F8A8D4CFA417C9ULL, 0xE54CA5D70A80E5D6ULL },
+	{ 0xA9F6D30A038D1DBCULL, 0x5E9FCF4CCD211F4CULL },
+	{ 0xD47487CC8470652BULL, 0x7647C3200069671FULL },
+	{ 0x84C8D4DFD2C63F3BULL, 0x29ECD9F40041E073ULL },
+	{ 0xA5FB0A17C777CF09ULL, 0xF468107100525890ULL },
+	{ 0xCF79CC9DB955C2CCULL, 0x7182148D4066EEB4ULL },
+	{ 0x81AC1FE293D599BFULL, 0xC6F14CD848405530ULL },
+	{ 0xA21727DB38CB002FULL, 0xB8ADA00E5A506A7CULL },
+	{ 0xCA9CF1D206FDC03BULL, 0xA6D90811F0E4851CULL },
+	{ 0xFD442E4688BD304AULL, 0x908F4A166D1DA663ULL },
+	{ 0x9E4A9CEC15763E2EULL, 0x9A598E4E043287FEULL },
+	{ 0xC5DD44271AD3CDBAULL, 0x40EFF1E1853F29FDULL },
+	{ 0xF7549530E188C128ULL, 0xD12BEE59E68EF47CULL },
+	{ 0x9A94DD3E8CF578B9ULL, 0x82BB74F8301958CEULL },
+	{ 0xC13A148E3032D6E7ULL, 0xE36A52363C1FAF01ULL },
+	{ 0xF18899B1BC3F8CA1ULL, 0xDC44E6C3CB279AC1ULL },
+	{ 0x96F5600F15A7B7E5ULL, 0x29AB103A5EF8C0B9ULL },
+	{ 0xBCB2B812DB11A5DEULL, 0x7415D448F6B6F0E7ULL },
+	{ 0xEBDF661791D60F56ULL, 0x111B495B3464AD21ULL },
+	{ 0x936B9FCEBB25C995ULL, 0xCAB10DD900BEEC34ULL },
+	{ 0xB84687C269EF3BFBULL, 0x3D5D514F40EEA742ULL },
+	{ 0xE65829B3046B0AFAULL, 0x0CB4A5A3112A5112ULL },
+	{ 0x8FF71A0FE2C2E6DCULL, 0x47F0E785EABA72ABULL },
+	{ 0xB3F4E093DB73A093ULL, 0x59ED216765690F56ULL },
+	{ 0xE0F218B8D25088B8ULL, 0x306869C13EC3532CULL },
+	{ 0x8C974F7383725573ULL, 0x1E414218C73A13FBULL },
+	{ 0xAFBD2350644EEACFULL, 0xE5D1929EF90898FAULL },
+	{ 0xDBAC6C247D62A583ULL, 0xDF45F746B74ABF39ULL },
+	{ 0x894BC396CE5DA772ULL, 0x6B8BBA8C328EB783ULL },
+	{ 0xAB9EB47C81F5114FULL, 0x066EA92F3F326564ULL },
+	{ 0xD686619BA27255A2ULL, 0xC80A537B0EFEFEBDULL },
+	{ 0x8613FD0145877585ULL, 0xBD06742CE95F5F36ULL },
+	{ 0xA798FC4196E952E7ULL, 0x2C48113823B73704ULL },
+	{ 0xD17F3B51FCA3A7A0ULL, 0xF75A15862CA504C5ULL },
+	{ 0x82EF85133DE648C4ULL, 0x9A984D73DBE722FBULL },
+	{ 0xA3AB66580D5FDAF5ULL, 0xC13E60D0D2E0EBBAULL },
+	{ 0xCC963FEE10B7D1B3ULL, 0x318DF905079926A8ULL },
+	{ 0xFFBBCFE994E5C61FULL, 0xFDF17746497F7052ULL },
+	{ 0x9FD561F1FD0F9BD3ULL, 0xFEB6EA8BEDEFA633ULL },
+	{ 0xC7CABA6E7C5382C8ULL, 0xFE64A52EE96B8FC0ULL },
+	{ 0xF9BD690A1B68637BULL, 0x3DFDCE7AA3C673B0ULL },
+	{ 0x9C1661A651213E2DULL, 0x06BEA10CA65C084EULL },
+	{ 0xC31BFA0FE5698DB8ULL, 0x486E494FCFF30A62ULL },
+	{ 0xF3E2F893DEC3F126ULL, 0x5A89DBA3C3EFCCFAULL },
+	{ 0x986DDB5C6B3A76B7ULL, 0xF89629465A75E01CULL },
+	{ 0xBE89523386091465ULL, 0xF6BBB397F1135823ULL },
+	{ 0xEE2BA6C0678B597FULL, 0x746AA07DED582E2CULL },
+	{ 0x94DB483840B717EFULL, 0xA8C2A44EB4571CDCULL },
+	{ 0xBA121A4650E4DDEBULL, 0x92F34D62616CE413ULL },
+	{ 0xE896A0D7E51E1566ULL, 0x77B020BAF9C81D17ULL },
+	{ 0x915E2486EF32CD60ULL, 0x0ACE1474DC1D122EULL },
+	{ 0xB5B5ADA8AAFF80B8ULL, 0x0D819992132456BAULL },
+	{ 0xE3231912D5BF60E6ULL, 0x10E1FFF697ED6C69ULL },
+	{ 0x8DF5EFABC5979C8FULL, 0xCA8D3FFA1EF463C1ULL },
+	{ 0xB1736B96B6FD83B3ULL, 0xBD308FF8A6B17CB2ULL },
+	{ 0xDDD0467C64BCE4A0ULL, 0xAC7CB3F6D05DDBDEULL },
+	{ 0x8AA22C0DBEF60EE4ULL, 0x6BCDF07A423AA96BULL },
+	{ 0xAD4AB7112EB3929DULL, 0x86C16C98D2C953C6ULL },
+	{ 0xD89D64D57A607744ULL, 0xE871C7BF077BA8B7ULL },
+	{ 0x87625F056C7C4A8BULL, 0x11471CD764AD4972ULL },
+	{ 0xA93AF6C6C79B5D2DULL, 0xD598E40D3DD89BCFULL },
+	{ 0xD389B47879823479ULL, 0x4AFF1D108D4EC2C3ULL },
+	{ 0x843610CB4BF160CBULL, 0xCEDF722A585139BAULL },
+	{ 0xA54394FE1EEDB8FEULL, 0xC2974EB4EE658828ULL },
+	{ 0xCE947A3DA6A9273EULL, 0x733D226229FEEA32ULL },
+	{ 0x811CCC668829B887ULL, 0x0806357D5A3F525FULL },
+	{ 0xA163FF802A3426A8ULL, 0xCA07C2DCB0CF26F7ULL },
+	{ 0xC9BCFF6034C13052ULL, 0xFC89B393DD02F0B5ULL },
+	{ 0xFC2C3F3841F17C67ULL, 0xBBAC2078D443ACE2ULL },
+	{ 0x9D9BA7832936EDC0ULL, 0xD54B944B84AA4C0DULL },
+	{ 0xC5029163F384A931ULL, 0x0A9E795E65D4DF11ULL },
+	{ 0xF64335BCF065D37DULL, 0x4D4617B5FF4A16D5ULL },
+	{ 0x99EA0196163FA42EULL, 0x504BCED1BF8E4E45ULL },
+	{ 0xC06481FB9BCF8D39ULL, 0xE45EC2862F71E1D6ULL },
+	{ 0xF07DA27A82C37088ULL, 0x5D767327BB4E5A4CULL },
+	{ 0x964E858C91BA2655ULL, 0x3A6A07F8D510F86FULL },
+	{ 0xBBE226EFB628AFEAULL, 0x890489F70A55368BULL },
+	{ 0xEADAB0ABA3B2DBE5ULL, 0x2B45AC74CCEA842EULL },
+	{ 0x92C8AE6B464FC96FULL, 0x3B0B8BC90012929DULL },
+	{ 0xB77ADA0617E3BBCBULL, 0x09CE6EBB40173744ULL },
+	{ 0xE55990879DDCAABDULL, 0xCC420A6A101D0515ULL },
+	{ 0x8F57FA54C2A9EAB6ULL, 0x9FA946824A12232DULL },
+	{ 0xB32DF8E9F3546564ULL, 0x47939822DC96ABF9ULL },
+	{ 0xDFF9772470297EBDULL, 0x59787E2B93BC56F7ULL },
+	{ 0x8BFBEA76C619EF36ULL, 0x57EB4EDB3C55B65AULL },
+	{ 0xAEFAE51477A06B03ULL, 0xEDE622920B6B23F1ULL },
+	{ 0xDAB99E59958885C4ULL, 0xE95FAB368E45ECEDULL },
+	{ 0x88B402F7FD75539BULL, 0x11DBCB0218EBB414ULL },
+	{ 0xAAE103B5FCD2A881ULL, 0xD652BDC29F26A119ULL },
+	{ 0xD59944A37C0752A2ULL, 0x4BE76D3346F0495FULL },
+	{ 0x857FCAE62D8493A5ULL, 0x6F70A4400C562DDBULL },
+	{ 0xA6DFBD9FB8E5B88EULL, 0xCB4CCD500F6BB952ULL },
+	{ 0xD097AD07A71F26B2ULL, 0x7E2000A41346A7A7ULL },
+	{ 0x825ECC24C873782FULL, 0x8ED400668C0C28C8ULL },
+	{ 0xA2F67F2DFA90563BULL, 0x728900802F0F32FAULL },
+	{ 0xCBB41EF979346BCAULL, 0x4F2B40A03AD2FFB9ULL },
+	{ 0xFEA126B7D78186BCULL, 0xE2F610C84987BFA8ULL },
+	{ 0x9F24B832E6B0F436ULL, 0x0DD9CA7D2DF4D7C9ULL },
+	{ 0xC6EDE63FA05D3143ULL, 0x91503D1C79720DBBULL },
+	{ 0xF8A95FCF88747D94ULL, 0x75A44C6397CE912AULL },
+	{ 0x9B69DBE1B548CE7CULL, 0xC986AFBE3EE11ABAULL },
+	{ 0xC24452DA229B021BULL, 0xFBE85BADCE996168ULL },
+	{ 0xF2D56790AB41C2A2ULL, 0xFAE27299423FB9C3ULL },
+	{ 0x97C560BA6B0919A5ULL, 0xDCCD879FC967D41AULL },
+	{ 0xBDB6B8E905CB600FULL, 0x5400E987BBC1C920ULL },
+	{ 0xED246723473E3813ULL, 0x290123E9AAB23B68ULL },
+	{ 0x9436C0760C86E30BULL, 0xF9A0B6720AAF6521ULL },
+	{ 0xB94470938FA89BCEULL, 0xF808E40E8D5B3E69ULL },
+	{ 0xE7958CB87392C2C2ULL, 0xB60B1D1230B20E04ULL },
+	{ 0x90BD77F3483BB9B9ULL, 0xB1C6F22B5E6F48C2ULL },
+	{ 0xB4ECD5F01A4AA828ULL, 0x1E38AEB6360B1AF3ULL },
+	{ 0xE2280B6C20DD5232ULL, 0x25C6DA63C38DE1B0ULL },
+	{ 0x8D590723948A535FULL, 0x579C487E5A38AD0EULL },
+	{ 0xB0AF48EC79ACE837ULL, 0x2D835A9DF0C6D851ULL },
+	{ 0xDCDB1B2798182244ULL, 0xF8E431456CF88E65ULL },
+	{ 0x8A08F0F8BF0F156BULL, 0x1B8E9ECB641B58FFULL },
+	{ 0xAC8B2D36EED2DAC5ULL, 0xE272467E3D222F3FULL },
+	{ 0xD7ADF884AA879177ULL, 0x5B0ED81DCC6ABB0FULL },
+	{ 0x86CCBB52EA94BAEAULL, 0x98E947129FC2B4E9ULL },
+	{ 0xA87FEA27A539E9A5ULL, 0x3F2398D747B36224ULL },
+	{ 0xD29FE4B18E88640EULL, 0x8EEC7F0D19A03AADULL },
+	{ 0x83A3EEEEF9153E89ULL, 0x1953CF68300424ACULL },
+	{ 0xA48CEAAAB75A8E2BULL, 0x5FA8C3423C052DD7ULL },
+	{ 0xCDB02555653131B6ULL, 0x3792F412CB06794DULL },
+	{ 0x808E17555F3EBF11ULL, 0xE2BBD88BBEE40BD0ULL },
+	{ 0xA0B19D2AB70E6ED6ULL, 0x5B6ACEAEAE9D0EC4ULL },
+	{ 0xC8DE047564D20A8BULL, 0xF245825A5A445275ULL },
+	{ 0xFB158592BE068D2EULL, 0xEED6E2F0F0D56712ULL },
+	{ 0x9CED737BB6C4183DULL, 0x55464DD69685606BULL },
+	{ 0xC428D05AA4751E4CULL, 0xAA97E14C3C26B886ULL },
+	{ 0xF53304714D9265DFULL, 0xD53DD99F4B3066A8ULL },
+	{ 0x993FE2C6D07B7FABULL, 0xE546A8038EFE4029ULL },
+	{ 0xBF8FDB78849A5F96ULL, 0xDE98520472BDD033ULL },
+	{ 0xEF73D256A5C0F77CULL, 0x963E66858F6D4440ULL },
+	{ 0x95A8637627989AADULL, 0xDDE7001379A44AA8ULL },
+	{ 0xBB127C53B17EC159ULL, 0x5560C018580D5D52ULL },
+	{ 0xE9D71B689DDE71AFULL, 0xAAB8F01E6E10B4A6ULL },
+	{ 0x9226712162AB070DULL, 0xCAB3961304CA70E8ULL },
+	{ 0xB6B00D69BB55C8D1ULL, 0x3D607B97C5FD0D22ULL },
+	{ 0xE45C10C42A2B3B05ULL, 0x8CB89A7DB77C506AULL },
+	{ 0x8EB98A7A9A5B04E3ULL, 0x77F3608E92ADB242ULL },
+	{ 0xB267ED1940F1C61CULL, 0x55F038B237591ED3ULL },
+	{ 0xDF01E85F912E37A3ULL, 0x6B6C46DEC52F6688ULL },
+	{ 0x8B61313BBABCE2C6ULL, 0x2323AC4B3B3DA015ULL },
+	{ 0xAE397D8AA96C1B77ULL, 0xABEC975E0A0D081AULL },
+	{ 0xD9C7DCED53C72255ULL, 0x96E7BD358C904A21ULL },
+	{ 0x881CEA14545C7575ULL, 0x7E50D64177DA2E54ULL },
+	{ 0xAA242499697392D2ULL, 0xDDE50BD1D5D0B9E9ULL },
+	{ 0xD4AD2DBFC3D07787ULL, 0x955E4EC64B44E864ULL },
+	{ 0x84EC3C97DA624AB4ULL, 0xBD5AF13BEF0B113EULL },
+	{ 0xA6274BBDD0FADD61ULL, 0xECB1AD8AEACDD58EULL },
+	{ 0xCFB11EAD453994BAULL, 0x67DE18EDA5814AF2ULL },
+	{ 0x81CEB32C4B43FCF4ULL, 0x80EACF948770CED7ULL },
+	{ 0xA2425FF75E14FC31ULL, 0xA1258379A94D028DULL },
+	{ 0xCAD2F7F5359A3B3EULL, 0x096EE45813A04330ULL },
+	{ 0xFD87B5F28300CA0DULL, 0x8BCA9D6E188853FCULL },
+	{ 0x9E74D1B791E07E48ULL, 0x775EA264CF55347EULL },
+	{ 0xC612062576589DDAULL, 0x95364AFE032A819EULL },
+	{ 0xF79687AED3EEC551ULL, 0x3A83DDBD83F52205ULL },
+	{ 0x9ABE14CD44753B52ULL, 0xC4926A9672793543ULL },
+	{ 0xC16D9A0095928A27ULL, 0x75B7053C0F178294ULL },
+	{ 0xF1C90080BAF72CB1ULL, 0x5324C68B12DD6339ULL },
+	{ 0x971DA05074DA7BEEULL, 0xD3F6FC16EBCA5E04ULL },
+	{ 0xBCE5086492111AEAULL, 0x88F4BB1CA6BCF585ULL },
+	{ 0xEC1E4A7DB69561A5ULL, 0x2B31E9E3D06C32E6ULL },
+	{ 0x9392EE8E921D5D07ULL, 0x3AFF322E62439FD0ULL },
+	{ 0xB877AA3236A4B449ULL, 0x09BEFEB9FAD487C3ULL },
+	{ 0xE69594BEC44DE15BULL, 0x4C2EBE687989A9B4ULL },
+	{ 0x901D7CF73AB0ACD9ULL, 0x0F9D37014BF60A11ULL },
+	{ 0xB424DC35095CD80FULL, 0x538484C19EF38C95ULL },
+	{ 0xE12E13424BB40E13ULL, 0x2865A5F206B06FBAULL },
+	{ 0x8CBCCC096F5088CBULL, 0xF93F87B7442E45D4ULL },
+	{ 0xAFEBFF0BCB24AAFEULL, 0xF78F69A51539D749ULL },
+	{ 0xDBE6FECEBDEDD5BEULL, 0xB573440E5A884D1CULL },
+	{ 0x89705F4136B4A597ULL, 0x31680A88F8953031ULL },
+	{ 0xABCC77118461CEFCULL, 0xFDC20D2B36BA7C3EULL },
+	{ 0xD6BF94D5E57A42BCULL, 0x3D32907604691B4DULL },
+	{ 0x8637BD05AF6C69B5ULL, 0xA63F9A49C2C1B110ULL },
+	{ 0xA7C5AC471B478423ULL, 0x0FCF80DC33721D54ULL },
+	{ 0xD1B71758E219652BULL, 0xD3C36113404EA4A9ULL },
+	{ 0x83126E978D4FDF3BULL, 0x645A1CAC083126EAULL },
+	{ 0xA3D70A3D70A3D70AULL, 0x3D70A3D70A3D70A4ULL },
+	{ 0xCCCCCCCCCCCCCCCCULL, 0xCCCCCCCCCCCCCCCDULL },
+	{ 0x8000000000000000ULL, 0x0000000000000000ULL },
+	{ 0xA000000000000000ULL, 0x0000000000000000ULL },
+	{ 0xC800000000000000ULL, 0x0000000000000000ULL },
+	{ 0xFA00000000000000ULL, 0x0000000000000000ULL },
+	{ 0x9C40000000000000ULL, 0x0000000000000000ULL },
+	{ 0xC350000000000000ULL, 0x0000000000000000ULL },
+	{ 0xF424000000000000ULL, 0x0000000000000000ULL },
+	{ 0x9896800000000000ULL, 0x0000000000000000ULL },
+	{ 0xBEBC200000000000ULL, 0x0000000000000000ULL },
+	{ 0xEE6B280000000000ULL, 0x0000000000000000ULL },
+	{ 0x9502F90000000000ULL, 0x0000000000000000ULL },
+	{ 0xBA43B74000000000ULL, 0x0000000000000000ULL },
+	{ 0xE8D4A51000000000ULL, 0x0000000000000000ULL },
+	{ 0x9184E72A00000000ULL, 0x0000000000000000ULL },
+	{ 0xB5E620F480000000ULL, 0x0000000000000000ULL },
+	{ 0xE35FA931A0000000ULL, 0x0000000000000000ULL },
+	{ 0x8E1BC9BF04000000ULL, 0x0000000000000000ULL },
+	{ 0xB1A2BC2EC5000000ULL, 0x0000000000000000ULL },
+	{ 0xDE0B6B3A76400000ULL, 0x0000000000000000ULL },
+	{ 0x8AC7230489E80000ULL, 0x0000000000000000ULL },
+	{ 0xAD78EBC5AC620000ULL, 0x0000000000000000ULL },
+	{ 0xD8D726B7177A8000ULL, 0x0000000000000000ULL },
+	{ 0x878678326EAC9000ULL, 0x0000000000000000ULL },
+	{ 0xA968163F0A57B400ULL, 0x0000000000000000ULL },
+	{ 0xD3C21BCECCEDA100ULL, 0x0000000000000000ULL },
+	{ 0x84595161401484A0ULL, 0x0000000000000000ULL },
+	{ 0xA56FA5B99019A5C8ULL, 0x0000000000000000ULL },
+	{ 0xCECB8F27F4200F3AULL, 0x0000000000000000ULL },
+	{ 0x813F3978F8940984ULL, 0x4000000000000000ULL },
+	{ 0xA18F07D736B90BE5ULL, 0x5000000000000000ULL },
+	{ 0xC9F2C9CD04674EDEULL, 0xA400000000000000ULL },
+	{ 0xFC6F7C4045812296ULL, 0x4D00000000000000ULL },
+	{ 0x9DC5ADA82B70B59DULL, 0xF020000000000000ULL },
+	{ 0xC5371912364CE305ULL, 0x6C28000000000000ULL },
+	{ 0xF684DF56C3E01BC6ULL, 0xC732000000000000ULL },
+	{ 0x9A130B963A6C115CULL, 0x3C7F400000000000ULL },
+	{ 0xC097CE7BC90715B3ULL, 0x4B9F100000000000ULL },
+	{ 0xF0BDC21ABB48DB20ULL, 0x1E86D40000000000ULL },
+	{ 0x96769950B50D88F4ULL, 0x1314448000000000ULL },
+	{ 0xBC143FA4E250EB31ULL, 0x17D955A000000000ULL },
+	{ 0xEB194F8E1AE525FDULL, 0x5DCFAB0800000000ULL },
+	{ 0x92EFD1B8D0CF37BEULL, 0x5AA1CAE500000000ULL },
+	{ 0xB7ABC627050305ADULL, 0xF14A3D9E40000000ULL },
+	{ 0xE596B7B0C643C719ULL, 0x6D9CCD05D0000000ULL },
+	{ 0x8F7E32CE7BEA5C6FULL, 0xE4820023A2000000ULL },
+	{ 0xB35DBF821AE4F38BULL, 0xDDA2802C8A800000ULL },
+	{ 0xE0352F62A19E306EULL, 0xD50B2037AD200000ULL },
+	{ 0x8C213D9DA502DE45ULL, 0x4526F422CC340000ULL },
+	{ 0xAF298D050E4395D6ULL, 0x9670B12B7F410000ULL },
+	{ 0xDAF3F04651D47B4CULL, 0x3C0CDD765F114000ULL },
+	{ 0x88D8762BF324CD0FULL, 0xA5880A69FB6AC800ULL },
+	{ 0xAB0E93B6EFEE0053ULL, 0x8EEA0D047A457A00ULL },
+	{ 0xD5D238A4ABE98068ULL, 0x72A4904598D6D880ULL },
+	{ 0x85A36366EB71F041ULL, 0x47A6DA2B7F864750ULL },
+	{ 0xA70C3C40A64E6C51ULL, 0x999090B65F67D924ULL },
+	{ 0xD0CF4B50CFE20765ULL, 0xFFF4B4E3F741CF6DULL },
+	{ 0x82818F1281ED449FULL, 0xBFF8F10E7A8921A4ULL },
+	{ 0xA321F2D7226895C7ULL, 0xAFF72D52192B6A0DULL },
+	{ 0xCBEA6F8CEB02BB39ULL, 0x9BF4F8A69F764490ULL },
+	{ 0xFEE50B7025C36A08ULL, 0x02F236D04753D5B4ULL },
+	{ 0x9F4F2726179A2245ULL, 0x01D762422C946590ULL },
+	{ 0xC722F0EF9D80AAD6ULL, 0x424D3AD2B7B97EF5ULL },
+	{ 0xF8EBAD2B84E0D58BULL, 0xD2E0898765A7DEB2ULL },
+	{ 0x9B934C3B330C8577ULL, 0x63CC55F49F88EB2FULL },
+	{ 0xC2781F49FFCFA6D5ULL, 0x3CBF6B71C76B25FBULL },
+	{ 0xF316271C7FC3908AULL, 0x8BEF464E3945EF7AULL },
+	{ 0x97EDD871CFDA3A56ULL, 0x97758BF0E3CBB5ACULL },
+	{ 0xBDE94E8E43D0C8ECULL, 0x3D52EEED1CBEA317ULL },
+	{ 0xED63A231D4C4FB27ULL, 0x4CA7AAA863EE4BDDULL },
+	{ 0x945E455F24FB1CF8ULL, 0x8FE8CAA93E74EF6AULL },
+	{ 0xB975D6B6EE39E436ULL, 0xB3E2FD538E122B44ULL },
+	{ 0xE7D34C64A9C85D44ULL, 0x60DBBCA87196B616ULL },
+	{ 0x90E40FBEEA1D3A4AULL, 0xBC8955E946FE31CDULL },
+	{ 0xB51D13AEA4A488DDULL, 0x6BABAB6398BDBE41ULL },
+	{ 0xE264589A4DCDAB14ULL, 0xC696963C7EED2DD1ULL },
+	{ 0x8D7EB76070A08AECULL, 0xFC1E1DE5CF543CA2ULL },
+	{ 0xB0DE65388CC8ADA8ULL, 0x3B25A55F43294BCBULL },
+	{ 0xDD15FE86AFFAD912ULL, 0x49EF0EB713F39EBEULL },
+	{ 0x8A2DBF142DFCC7ABULL, 0x6E3569326C784337ULL },
+	{ 0xACB92ED9397BF996ULL, 0x49C2C37F07965404ULL },
+	{ 0xD7E77A8F87DAF7FBULL, 0xDC33745EC97BE906ULL },
+	{ 0x86F0AC99B4E8DAFDULL, 0x69A028BB3DED71A3ULL },
+	{ 0xA8ACD7C0222311BCULL, 0xC40832EA0D68CE0CULL },
+	{ 0xD2D80DB02AABD62BULL, 0xF50A3FA490C30190ULL },
+	{ 0x83C7088E1AAB65DBULL, 0x792667C6DA79E0FAULL },
+	{ 0xA4B8CAB1A1563F52ULL, 0x577001B891185938ULL },
+	{ 0xCDE6FD5E09ABCF26ULL, 0xED4C0226B55E6F86ULL },
+	{ 0x80B05E5AC60B6178ULL, 0x544F8158315B05B4ULL },
+	{ 0xA0DC75F1778E39D6ULL, 0x696361AE3DB1C721ULL },
+	{ 0xC913936DD571C84CULL, 0x03BC3A19CD1E38E9ULL },
+	{ 0xFB5878494ACE3A5FULL, 0x04AB48A04065C723ULL },
+	{ 0x9D174B2DCEC0E47BULL, 0x62EB0D64283F9C76ULL },
+	{ 0xC45D1DF942711D9AULL, 0x3BA5D0BD324F8394ULL },
+	{ 0xF5746577930D6500ULL, 0xCA8F44EC7EE36479ULL },
+	{ 0x9968BF6ABBE85F20ULL, 0x7E998B13CF4E1ECBULL },
+	{ 0xBFC2EF456AE276E8ULL, 0x9E3FEDD8C321A67EULL },
+	{ 0xEFB3AB16C59B14A2ULL, 0xC5CFE94EF3EA101EULL },
+	{ 0x95D04AEE3B80ECE5ULL, 0xBBA1F1D158724A12ULL },
+	{ 0xBB445DA9CA61281FULL, 0x2A8A6E45AE8EDC97ULL },
+	{ 0xEA1575143CF97226ULL, 0xF52D09D71A3293BDULL },
+	{ 0x924D692CA61BE758ULL, 0x593C2626705F9C56ULL },
+	{ 0xB6E0C377CFA2E12EULL, 0x6F8B2FB00C77836CULL },
+	{ 0xE498F455C38B997AULL, 0x0B6DFB9C0F956447ULL },
+	{ 0x8EDF98B59A373FECULL, 0x4724BD4189BD5EACULL },
+	{ 0xB2977EE300C50FE7ULL, 0x58EDEC91EC2CB657ULL },
+	{ 0xDF3D5E9BC0F653E1ULL, 0x2F2967B66737E3EDULL },
+	{ 0x8B865B215899F46CULL, 0xBD79E0D20082EE74ULL },
+	{ 0xAE67F1E9AEC07187ULL, 0xECD8590680A3AA11ULL },
+	{ 0xDA01EE641A708DE9ULL, 0xE80E6F4820CC9495ULL },
+	{ 0x884134FE908658B2ULL, 0x3109058D147FDCDDULL },
+	{ 0xAA51823E34A7EEDEULL, 0xBD4B46F0599FD415ULL },
+	{ 0xD4E5E2CDC1D1EA96ULL, 0x6C9E18AC7007C91AULL },
+	{ 0x850FADC09923329EULL, 0x03E2CF6BC604DDB0ULL },
+	{ 0xA6539930BF6BFF45ULL, 0x84DB8346B786151CULL },
+	{ 0xCFE87F7CEF46FF16ULL, 0xE612641865679A63ULL },
+	{ 0x81F14FAE158C5F6EULL, 0x4FCB7E8F3F60C07EULL },
+	{ 0xA26DA3999AEF7749ULL, 0xE3BE5E330F38F09DULL },
+	{ 0xCB090C8001AB551CULL, 0x5CADF5BFD3072CC5ULL },
+	{ 0xFDCB4FA002162A63ULL, 0x73D9732FC7C8F7F6ULL },
+	{ 0x9E9F11C4014DDA7EULL, 0x2867E7FDDCDD9AFAULL },
+	{ 0xC646D63501A1511DULL, 0xB281E1FD541501B8ULL },
+	{ 0xF7D88BC24209A565ULL, 0x1F225A7CA91A4226ULL },
+	{ 0x9AE757596946075FULL, 0x3375788DE9B06958ULL },
+	{ 0xC1A12D2FC3978937ULL, 0x0052D6B1641C83AEULL },
+	{ 0xF209787BB47D6B84ULL, 0xC0678C5DBD23A49AULL },
+	{ 0x9745EB4D50CE6332ULL, 0xF840B7BA963646E0ULL },
+	{ 0xBD176620A501FBFFULL, 0xB650E5A93BC3D898ULL },
+	{ 0xEC5D3FA8CE427AFFULL, 0xA3E51F138AB4CEBEULL },
+	{ 0x93BA47C980E98CDFULL, 0xC66F336C36B10137ULL },
+	{ 0xB8A8D9BBE123F017ULL, 0xB80B0047445D4184ULL },
+	{ 0xE6D3102AD96CEC1DULL, 0xA60DC059157491E5ULL },
+	{ 0x9043EA1AC7E41392ULL, 0x87C89837AD68DB2FULL },
+	{ 0xB454E4A179DD1877ULL, 0x29BABE4598C311FBULL },
+	{ 0xE16A1DC9D8545E94ULL, 0xF4296DD6FEF3D67AULL },
+	{ 0x8CE2529E2734BB1DULL, 0x1899E4A65F58660CULL },
+	{ 0xB01AE745B101E9E4ULL, 0x5EC05DCFF72E7F8FULL },
+	{ 0xDC21A1171D42645DULL, 0x76707543F4FA1F73ULL },
+	{ 0x899504AE72497EBAULL, 0x6A06494A791C53A8ULL },
+	{ 0xABFA45DA0EDBDE69ULL, 0x0487DB9D17636892ULL },
+	{ 0xD6F8D7509292D603ULL, 0x45A9D2845D3C42B6ULL },
+	{ 0x865B86925B9BC5C2ULL, 0x0B8A2392BA45A9B2ULL },
+	{ 0xA7F26836F282B732ULL, 0x8E6CAC7768D7141EULL },
+	{ 0xD1EF0244AF2364FFULL, 0x3207D795430CD926ULL },
+	{ 0x8335616AED761F1FULL, 0x7F44E6BD49E807B8ULL },
+	{ 0xA402B9C5A8D3A6E7ULL, 0x5F16206C9C6209A6ULL },
+	{ 0xCD036837130890A1ULL, 0x36DBA887C37A8C0FULL },
+	{ 0x802221226BE55A64ULL, 0xC2494954DA2C9789ULL },
+	{ 0xA02AA96B06DEB0FDULL, 0xF2DB9BAA10B7BD6CULL },
+	{ 0xC83553C5C8965D3DULL, 0x6F92829494E5ACC7ULL },
+	{ 0xFA42A8B73ABBF48CULL, 0xCB772339BA1F17F9ULL },
+	{ 0x9C69A97284B578D7ULL, 0xFF2A760414536EFBULL },
+	{ 0xC38413CF25E2D70DULL, 0xFEF5138519684ABAULL },
+	{ 0xF46518C2EF5B8CD1ULL, 0x7EB258665FC25D69ULL },
+	{ 0x98BF2F79D5993802ULL, 0xEF2F773FFBD97A61ULL },
+	{ 0xBEEEFB584AFF8603ULL, 0xAAFB550FFACFD8FAULL },
+	{ 0xEEAABA2E5DBF6784ULL, 0x95BA2A53F983CF38ULL },
+	{ 0x952AB45CFA97A0B2ULL, 0xDD945A747BF26183ULL },
+	{ 0xBA756174393D88DFULL, 0x94F971119AEEF9E4ULL },
+	{ 0xE912B9D1478CEB17ULL, 0x7A37CD5601AAB85DULL },
+	{ 0x91ABB422CCB812EEULL, 0xAC62E055C10AB33AULL },
+	{ 0xB616A12B7FE617AAULL, 0x577B986B314D6009ULL },
+	{ 0xE39C49765FDF9D94ULL, 0xED5A7E85FDA0B80BULL },
+	{ 0x8E41ADE9FBEBC27DULL, 0x14588F13BE847307ULL },
+	{ 0xB1D219647AE6B31CULL, 0x596EB2D8AE258FC8ULL },
+	{ 0xDE469FBD99A05FE3ULL, 0x6FCA5F8ED9AEF3BBULL },
+	{ 0x8AEC23D680043BEEULL, 0x25DE7BB9480D5854ULL },
+	{ 0xADA72CCC20054AE9ULL, 0xAF561AA79A10AE6AULL },
+	{ 0xD910F7FF28069DA4ULL, 0x1B2BA1518094DA04ULL },
+	{ 0x87AA9AFF79042286ULL, 0x90FB44D2F05D0842ULL },
+	{ 0xA99541BF57452B28ULL, 0x353A1607AC744A53ULL },
+	{ 0xD3FA922F2D1675F2ULL, 0x42889B8997915CE8ULL },
+	{ 0x847C9B5D7C2E09B7ULL, 0x69956135FEBADA11ULL },
+	{ 0xA59BC234DB398C25ULL, 0x43FAB9837E699095ULL },
+	{ 0xCF02B2C21207EF2EULL, 0x94F967E45E03F4BBULL },
+	{ 0x8161AFB94B44F57DULL, 0x1D1BE0EEBAC278F5ULL },
+	{ 0xA1BA1BA79E1632DCULL, 0x6462D92A69731732ULL },
+	{ 0xCA28A291859BBF93ULL, 0x7D7B8F7503CFDCFEULL },
+	{ 0xFCB2CB35E702AF78ULL, 0x5CDA735244C3D43EULL },
+	{ 0x9DEFBF01B061ADABULL, 0x3A0888136AFA64A7ULL },
+	{ 0xC56BAEC21C7A1916ULL, 0x088AAA1845B8FDD0ULL },
+	{ 0xF6C69A72A3989F5BULL, 0x8AAD549E57273D45ULL },
+	{ 0x9A3C2087A63F6399ULL, 0x36AC54E2F678864BULL },
+	{ 0xC0CB28A98FCF3C7FULL, 0x84576A1BB416A7DDULL },
+	{ 0xF0FDF2D3F3C30B9FULL, 0x656D44A2A11C51D5ULL },
+	{ 0x969EB7C47859E743ULL, 0x9F644AE5A4B1B325ULL },
+	{ 0xBC4665B596706114ULL, 0x873D5D9F0DDE1FEEULL },
+	{ 0xEB57FF22FC0C7959ULL, 0xA90CB506D155A7EAULL },
+	{ 0x9316FF75DD87CBD8ULL, 0x09A7F12442D588F2ULL },
+	{ 0xB7DCBF5354E9BECEULL, 0x0C11ED6D538AEB2FULL },
+	{ 0xE5D3EF282A242E81ULL, 0x8F1668C8A86DA5FAULL },
+	{ 0x8FA475791A569D10ULL, 0xF96E017D694487BCULL },
+	{ 0xB38D92D760EC4455ULL, 0x37C981DCC395A9ACULL },
+	{ 0xE070F78D3927556AULL, 0x85BBE253F47B1417ULL },
+	{ 0x8C469AB843B89562ULL, 0x93956D7478CCEC8EULL },
+	{ 0xAF58416654A6BABBULL, 0x387AC8D1970027B2ULL },
+	{ 0xDB2E51BFE9D0696AULL, 0x06997B05FCC0319EULL },
+	{ 0x88FCF317F22241E2ULL, 0x441FECE3BDF81F03ULL },
+	{ 0xAB3C2FDDEEAAD25AULL, 0xD527E81CAD7626C3ULL },
+	{ 0xD60B3BD56A5586F1ULL, 0x8A71E223D8D3B074ULL },
+	{ 0x85C7056562757456ULL, 0xF6872D5667844E49ULL },
+	{ 0xA738C6BEBB12D16CULL, 0xB428F8AC016561DBULL },
+	{ 0xD106F86E69D785C7ULL, 0xE13336D701BEBA52ULL },
+	{ 0x82A45B450226B39CULL, 0xECC0024661173473ULL },
+	{ 0xA34D721642B06084ULL, 0x27F002D7F95D0190ULL },
+	{ 0xCC20CE9BD35C78A5ULL, 0x31EC038DF7B441F4ULL },
+	{ 0xFF290242C83396CEULL, 0x7E67047175A15271ULL },
+	{ 0x9F79A169BD203E41ULL, 0x0F0062C6E984D386ULL },
+	{ 0xC75809C42C684DD1ULL, 0x52C07B78A3E60868ULL },
+	{ 0xF92E0C3537826145ULL, 0xA7709A56CCDF8A82ULL },
+	{ 0x9BBCC7A142B17CCBULL, 0x88A66076400BB691ULL },
+	{ 0xC2ABF989935DDBFEULL, 0x6ACFF893D00EA435ULL },
+	{ 0xF356F7EBF83552FEULL, 0x0583F6B8C4124D43ULL },
+	{ 0x98165AF37B2153DEULL, 0xC3727A337A8B704AULL },
+	{ 0xBE1BF1B059E9A8D6ULL, 0x744F18C0592E4C5CULL },
+	{ 0xEDA2EE1C7064130CULL, 0x1162DEF06F79DF73ULL },
+	{ 0x9485D4D1C63E8BE7ULL, 0x8ADDCB5645AC2BA8ULL },
+	{ 0xB9A74A0637CE2EE1ULL, 0x6D953E2BD7173692ULL },
+	{ 0xE8111C87C5C1BA99ULL, 0xC8FA8DB6CCDD0437ULL },
+	{ 0x910AB1D4DB9914A0ULL, 0x1D9C9892400A22A2ULL },
+	{ 0xB54D5E4A127F59C8ULL, 0x2503BEB6D00CAB4BULL },
+	{ 0xE2A0B5DC971F303AULL, 0x2E44AE64840FD61DULL },
+	{ 0x8DA471A9DE737E24ULL, 0x5CEAECFED289E5D2ULL },
+	{ 0xB10D8E1456105DADULL, 0x7425A83E872C5F47ULL },
+	{ 0xDD50F1996B947518ULL, 0xD12F124E28F77719ULL },
+	{ 0x8A5296FFE33CC92FULL, 0x82BD6B70D99AAA6FULL },
+	{ 0xACE73CBFDC0BFB7BULL, 0x636CC64D1001550BULL },
+	{ 0xD8210BEFD30EFA5AULL, 0x3C47F7E05401AA4EULL },
+	{ 0x8714A775E3E95C78ULL, 0x65ACFAEC34810A71ULL },
+	{ 0xA8D9D1535CE3B396ULL, 0x7F1839A741A14D0DULL },
+	{ 0xD31045A8341CA07CULL, 0x1EDE48111209A050ULL },
+	{ 0x83EA2B892091E44DULL, 0x934AED0AAB460432ULL },
+	{ 0xA4E4B66B68B65D60ULL, 0xF81DA84D5617853FULL },
+	{ 0xCE1DE40642E3F4B9ULL, 0x36251260AB9D668EULL },
+	{ 0x80D2AE83E9CE78F3ULL, 0xC1D72B7C6B426019ULL },
+	{ 0xA1075A24E4421730ULL, 0xB24CF65B8612F81FULL },
+	{ 0xC94930AE1D529CFCULL, 0xDEE033F26797B627ULL },
+	{ 0xFB9B7CD9A4A7443CULL, 0x169840EF017DA3B1ULL },
+	{ 0x9D412E0806E88AA5ULL, 0x8E1F289560EE864EULL },
+	{ 0xC491798A08A2AD4EULL, 0xF1A6F2BAB92A27E2ULL },
+	{ 0xF5B5D7EC8ACB58A2ULL, 0xAE10AF696774B1DBULL },
+	{ 0x9991A6F3D6BF1765ULL, 0xACCA6DA1E0A8EF29ULL },
+	{ 0xBFF610B0CC6EDD3FULL, 0x17FD090A58D32AF3ULL },
+	{ 0xEFF394DCFF8A948EULL, 0xDDFC4B4CEF07F5B0ULL },
+	{ 0x95F83D0A1FB69CD9ULL, 0x4ABDAF101564F98EULL },
+	{ 0xBB764C4CA7A4440FULL, 0x9D6D1AD41ABE37F1ULL },
+	{ 0xEA53DF5FD18D5513ULL, 0x84C86189216DC5EDULL },
+	{ 0x92746B9BE2F8552CULL, 0x32FD3CF5B4E49BB4ULL },
+	{ 0xB7118682DBB66A77ULL, 0x3FBC8C33221DC2A1ULL },
+	{ 0xE4D5E82392A40515ULL, 0x0FABAF3FEAA5334AULL },
+	{ 0x8F05B1163BA6832DULL, 0x29CB4D87F2A7400EULL },
+	{ 0xB2C71D5BCA9023F8ULL, 0x743E20E9EF511012ULL },
+	{ 0xDF78E4B2BD342CF6ULL, 0x914DA9246B255416ULL },
+	{ 0x8BAB8EEFB6409C1AULL, 0x1AD089B6C2F7548EULL },
+	{ 0xAE9672ABA3D0C320ULL, 0xA184AC2473B529B1ULL },
+	{ 0xDA3C0F568CC4F3E8ULL, 0xC9E5D72D90A2741EULL },
+	{ 0x8865899617FB1871ULL, 0x7E2FA67C7A658892ULL },
+	{ 0xAA7EEBFB9DF9DE8DULL, 0xDDBB901B98FEEAB7ULL },
+	{ 0xD51EA6FA85785631ULL, 0x552A74227F3EA565ULL },
+	{ 0x8533285C936B35DEULL, 0xD53A88958F87275FULL },
+	{ 0xA67FF273B8460356ULL, 0x8A892ABAF368F137ULL },
+	{ 0xD01FEF10A657842CULL, 0x2D2B7569B0432D85ULL },
+	{ 0x8213F56A67F6B29BULL, 0x9C3B29620E29FC73ULL },
+	{ 0xA298F2C501F45F42ULL, 0x8349F3BA91B47B8FULL },
+	{ 0xCB3F2F7642717713ULL, 0x241C70A936219A73ULL },
+	{ 0xFE0EFB53D30DD4D7ULL, 0xED238CD383AA0110ULL },
+	{ 0x9EC95D1463E8A506ULL, 0xF4363804324A40AAULL },
+	{ 0xC67BB4597CE2CE48ULL, 0xB143C6053EDCD0D5ULL },
+	{ 0xF81AA16FDC1B81DAULL, 0xDD94B7868E94050AULL },
+	{ 0x9B10A4E5E9913128ULL, 0xCA7CF2B4191C8326ULL },
+	{ 0xC1D4CE1F63F57D72ULL, 0xFD1C2F611F63A3F0ULL },
+	{ 0xF24A01A73CF2DCCFULL, 0xBC633B39673C8CECULL },
+	{ 0x976E41088617CA01ULL, 0xD5BE0503E085D813ULL },
+	{ 0xBD49D14AA79DBC82ULL, 0x4B2D8644D8A74E18ULL },
+	{ 0xEC9C459D51852BA2ULL, 0xDDF8E7D60ED1219EULL },
+	{ 0x93E1AB8252F33B45ULL, 0xCABB90E5C942B503ULL },
+	{ 0xB8DA1662E7B00A17ULL, 0x3D6A751F3B936243ULL },
+	{ 0xE7109BFBA19C0C9DULL, 0x0CC512670A783AD4ULL },
+	{ 0x906A617D450187E2ULL, 0x27FB2B80668B24C5ULL },
+	{ 0xB484F9DC9641E9DAULL, 0xB1F9F660802DEDF6ULL },
+	{ 0xE1A63853BBD26451ULL, 0x5E7873F8A0396973ULL },
+	{ 0x8D07E33455637EB2ULL, 0xDB0B487B6423E1E8ULL },
+	{ 0xB049DC016ABC5E5FULL, 0x91CE1A9A3D2CDA62ULL },
+	{ 0xDC5C5301C56B75F7ULL, 0x7641A140CC7810FBULL },
+	{ 0x89B9B3E11B6329BAULL, 0xA9E904C87FCB0A9DULL },
+	{ 0xAC2820D9623BF429ULL, 0x546345FA9FBDCD44ULL },
+	{ 0xD732290FBACAF133ULL, 0xA97C177947AD4095ULL },
+	{ 0x867F59A9D4BED6C0ULL, 0x49ED8EABCCCC485DULL },
+	{ 0xA81F301449EE8C70ULL, 0x5C68F256BFFF5A74ULL },
+	{ 0xD226FC195C6A2F8CULL, 0x73832EEC6FFF3111ULL },
+	{ 0x83585D8FD9C25DB7ULL, 0xC831FD53C5FF7EABULL },
+	{ 0xA42E74F3D032F525ULL, 0xBA3E7CA8B77F5E55ULL },
+	{ 0xCD3A1230C43FB26FULL, 0x28CE1BD2E55F35EBULL },
+	{ 0x80444B5E7AA7CF85ULL, 0x7980D163CF5B81B3ULL },
+	{ 0xA0555E361951C366ULL, 0xD7E105BCC332621FULL },
+	{ 0xC86AB5C39FA63440ULL, 0x8DD9472BF3FEFAA7ULL },
+	{ 0xFA856334878FC150ULL, 0xB14F98F6F0FEB951ULL },
+	{ 0x9C935E00D4B9D8D2ULL, 0x6ED1BF9A569F33D3ULL },
+	{ 0xC3B8358109E84F07ULL, 0x0A862F80EC4700C8ULL },
+	{ 0xF4A642E14C6262C8ULL, 0xCD27BB612758C0FAULL },
+	{ 0x98E7E9CCCFBD7DBDULL, 0x8038D51CB897789CULL },
+	{ 0xBF21E44003ACDD2CULL, 0xE0470A63E6BD56C3ULL },
+	{ 0xEEEA5D5004981478ULL, 0x1858CCFCE06CAC74ULL },
+	{ 0x95527A5202DF0CCBULL, 0x0F37801E0C43EBC8ULL },
+	{ 0xBAA718E68396CFFDULL, 0xD30560258F54E6BAULL },
+	{ 0xE950DF20247C83FDULL, 0x47C6B82EF32A2069ULL },
+	{ 0x91D28B7416CDD27EULL, 0x4CDC331D57FA5441ULL },
+	{ 0xB6472E511C81471DULL, 0xE0133FE4ADF8E952ULL },
+	{ 0xE3D8F9E563A198E5ULL, 0x58180FDDD97723A6ULL },
+	{ 0x8E679C2F5E44FF8FULL, 0x570F09EAA7EA7648ULL }
+};
+
+
+static u128_t full_mul(uint64_t x, uint64_t y) {
+	const uint64_t x_lo = x & 0xFFFFFFFFU;
+	const uint64_t x_hi = x >> 32U;
+	const uint64_t y_lo = y & 0xFFFFFFFFU;
+	const uint64_t y_hi = y >> 32U;
+
+	const uint64_t p0 = x_lo * y_lo;
+	const uint64_t p1 = x_lo * y_hi;
+	const uint64_t p2 = x_hi * y_lo;
+	const uint64_t p3 = x_hi * y_hi;
+
+	const uint64_t mid = (p0 >> 32U) + (p1 & 0xFFFFFFFFU) + (p2 & 0xFFFFFFFFU);
+
+	u128_t r;
+
+	r.lo = (mid << 32U) | (p0 & 0xFFFFFFFFU);
+	r.hi = p3 + (p1 >> 32U) + (p2 >> 32U) + (mid >> 32U);
+
+	return r;
+}
+
+
+static int leading_zeros(uint64_t x) {
+	int n = 0;
+
+	while ( !(x & 0x8000000000000000ULL) ) {
+		x <<= 1U;
+		n++;
+	}
+
+	return n;
+}
+
+
+static uint64_t eisel_lemire(uint64_t w, int q) {
+	// returns the IEEE-754 bits of w * 10^q without the sign, w must be non-zero
+	u128_t product;
+	uint64_t mantissa;
+	int upper_bit;
+	int shift;
+	int power2;
+	int lz;
+
+	if ( q < -342 ) {
+		return 0;
+	}
+
+	if ( q > 308 ) {
+		return 0x7FFULL << 52U;
+	}
+
+	lz = leading_zeros(w);
+	w <<= lz;
+
+	product = full_mul(w, POWERS_OF_FIVE[q + 342].hi);
+
+	if ( (product.hi & 0x1FF) == 0x1FF ) {
+		u128_t second = full_mul(w, POWERS_OF_FIVE[q + 342].lo);
+
+		product.lo += second.hi;
+
+		if ( second.hi > product.lo ) {
+			product.hi++;
+		}
+	}
+
+	upper_bit = (int) (product.hi >> 63U);
+	shift = upper_bit + 64 - 52 - 3;
+	mantissa = product.hi >> shift;
+	power2 = (((152170 + 65536) * q) >> 16) + 63 + upper_bit - lz + 1023;
+
+	if ( power2 <= 0 ) {
+		// subnormal
+		if ( -power2 + 1 >= 64 ) {
+			return 0;
+		}
+
+		mantissa >>= -power2 + 1;
+		mantissa += (mantissa & 1);
+		mantissa >>= 1;
+		power2 = (mantissa < (1ULL << 52U)) ? 0 : 1;
+
+		return (mantissa & ((1ULL << 52U) - 1)) | ((uint64_t) power2 << 52U);
+	}
+
+	// exactly halfway between two doubles, round to even rather than up
+	if ( product.lo <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 && (mantissa << shift) == product.hi ) {
+		mantissa &= ~1ULL;
+	}
+
+	mantissa += (mantissa & 1);
+	mantissa >>= 1;
+
+	if ( mantissa >= (2ULL << 52U) ) {
+		mantissa = 1ULL << 52U;
+		power2++;
+	}
+
+	if ( power2 >= 0x7FF ) {
+		return 0x7FFULL << 52U;
+	}
+
+	return (mantissa & ((1ULL << 52U) - 1)) | ((uint64_t) power2 << 52U);
+}
+
+
+// Arbitrary precision arithmetic for the slow path, just enough to compare a long decimal with
+// the point halfway between two doubles. 4096 bits is more than either side can need with at
+// most 19 + DECIMAL_EXTRA_DIGITS digits and an exponent in the range of a double.
+
+#define BIGNUM_LIMBS			128
+
+
+typedef struct {
+	uint32_t limbs[BIGNUM_LIMBS];
+	int count;
+	bool overflow;
+} bignum_t;
+
+
+static void bignum_set(bignum_t* n, uint64_t value) {
+	n->limbs[0] = (uint32_t) value;
+	n->limbs[1] = (uint32_t) (value >> 32U);
+	n->count = n->limbs[1] ? 2 : (n->limbs[0] ? 1 : 0);
+	n->overflow = false;
+}
+
+
+static void bignum_mul_add(bignum_t* n, uint32_t mul, uint32_t add) {
+	uint64_t carry = add;
+	int i;
+
+	for (i = 0; i < n->count; i++) {
+		uint64_t product = (uint64_t) n->limbs[i] * mul + carry;
+
+		n->limbs[i] = (uint32_t) product;
+		carry = product >> 32U;
+	}
+
+	if ( carry ) {
+		if ( n->count == BIGNUM_LIMBS ) {
+			n->overflow = true;
+		} else {
+			n->limbs[n->count++] = (uint32_t) carry;
+		}
+	}
+}
+
+
+static void bignum_mul_pow5(bignum_t* n, int e) {
+	static const uint32_t SMALL_POWERS_OF_FIVE[14] = {
+		1, 5, 25, 125, 625, 3125, 15625, 78125, 390625, 1953125, 9765625, 48828125, 244140625, 1220703125
+	};
+
+	for (; e >= 13; e -= 13) {
+		bignum_mul_add(n, SMALL_POWERS_OF_FIVE[13], 0);
+	}
+
+	bignum_mul_add(n, SMALL_POWERS_OF_FIVE[e], 0);
+}
+
+
+static void bignum_shift_left(bignum_t* n, int bits) {
+	int words = bits / 32;
+	int shift = bits % 32;
+	int i;
+
+	if ( n->count == 0 ) {
+		return;
+	}
+
+	if ( n->count + words + 1 > BIGNUM_LIMBS ) {
+		n->overflow = true;
+		return;
+	}
+
+	n->limbs[n->count + words] = 0;
+
+	for (i = n->count - 1; i >= 0; i--) {
+		uint64_t v = (uint64_t) n->limbs[i] << shift;
+
+		n->limbs[i + words + 1] |= (uint32_t) (v >> 32U);
+		n->limbs[i + words] = (uint32_t) v;
+	}
+
+	for (i = 0; i < words; i++) {
+		n->limbs[i] = 0;
+	}
+
+	n->count += words + 1;
+
+	while ( n->count > 0 && n->limbs[n->count - 1] == 0 ) {
+		n->count--;
+	}
+}
+
+
+static int bignum_compare(const bignum_t* a, const bignum_t* b) {
+	int i;
+
+	if ( a->count != b->count ) {
+		return a->count < b->count ? -1 : 1;
+	}
+
+	for (i = a->count - 1; i >= 0; i--) {
+		if ( a->limbs[i] != b->limbs[i] ) {
+			return a->limbs[i] < b->limbs[i] ? -1 : 1;
+		}
+	}
+
+	return 0;
+}
+
+
+static ZETES_NOINLINE uint64_t round_decimal(const decimal_t* dec, int exponent, uint64_t bits) {
+	// Decides between bits and the double after it, for a decimal lying between them, by comparing
+	// all of its digits with the point halfway between. The decimal is N * 10^k, N being every
+	// digit kept, and the halfway point is H * 2^f. Kept out of line, as the bignums would otherwise
+	// take their space on the stack of every number lexed.
+	static const uint32_t POWERS_OF_TEN_32[10] = {
+		1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+	};
+
+	bignum_t n;
+	bignum_t h;
+	uint64_t significand = bits & ((1ULL << 52U) - 1);
+	int biased = (int) (bits >> 52U);
+	int k = exponent - dec->extra_count;
+	int f;
+	int i;
+	int cmp;
+
+	if ( biased ) {
+		significand |= 1ULL << 52U;
+		f = biased - 1075 - 1;
+	} else {
+		f = -1074 - 1;
+	}
+
+	bignum_set(&n, dec->mantissa);
+
+	for (i = 0; i < dec->extra_count; i += 9) {
+		int chunk = dec->extra_count - i < 9 ? dec->extra_count - i : 9;
+		uint32_t value = 0;
+		int j;
+
+		for (j = 0; j < chunk; j++) {
+			value = value * 10 + (uint32_t) dec->extra_top[-1 - (i + j)];
+		}
+
+		bignum_mul_add(&n, POWERS_OF_TEN_32[chunk], value);
+	}
+
+	bignum_set(&h, significand * 2 + 1);
+
+	// N * 5^k * 2^k against H * 2^f, then both brought to the same power of two
+	if ( k >= 0 ) {
+		bignum_mul_pow5(&n, k);
+	} else {
+		bignum_mul_pow5(&h, -k);
+	}
+
+	if ( k > f ) {
+		bignum_shift_left(&n, k - f);
+	} else {
+		bignum_shift_left(&h, f - k);
+	}
+
+	if ( n.overflow || h.overflow ) {
+		return bits;
+	}
+
+	cmp = bignum_compare(&n, &h);
+
+	// digits past those kept are non-zero, so an apparent tie is above halfway
+	if ( cmp == 0 && dec->truncated ) {
+		cmp = 1;
+	}
+
+	if ( cmp > 0 || (cmp == 0 && (bits & 1)) ) {
+		return bits + 1;
+	}
+
+	return bits;
+}
+
+#endif
+
+
+static double decimal_to_double(const decimal_t* dec, int exponent) {
+	double value;
+
+	if ( dec->mantissa == 0 ) {
+		return 0.0;
+	}
+
+	// Clinger's fast path, exact when both operands are exactly representable
+	if ( !dec->dropped && dec->mantissa <= (1ULL << 53U) && exponent >= -22 && exponent <= 22 ) {
+		value = (double) dec->mantissa;
+
+		if ( exponent < 0 ) {
+			return value / EXACT_POWERS_OF_TEN[-exponent];
+		} else {
+			return value * EXACT_POWERS_OF_TEN[exponent];
+		}
+	}
+
+#if ZETES_EXACT_NUMBERS
+	{
+		uint64_t bits = eisel_lemire(dec->mantissa, exponent);
+
+		// With digits dropped the value lies between mantissa and mantissa + 1 times 10^exponent.
+		// Nearly always both round the same way, and otherwise the digits decide.
+		if ( dec->dropped && eisel_lemire(dec->mantissa + 1, exponent) != bits ) {
+			bits = round_decimal(dec, exponent, bits);
+		}
+
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+#else
+	{
+		double power = 10.0;
+		long exp = exponent;
+
+		value = (double) dec->mantissa;
+
+		if ( exp < 0 ) {
+			exp = -exp;
+
+			while (exp) {
+				if ( exp & 1 ) value /= power;
+				exp >>= 1;
+				power *= power;
+			}
+		} else {
+			while (exp) {
+				if ( exp & 1 ) value *= power;
+				exp >>= 1;
+				power *= power;
+			}
+		}
+
+		return value;
+	}
+#endif
+}
+
+
+static void lex_number_value(rstate_t* state) {
+	zetes_t* ctx = state->ctx;
+	decimal_t dec;
+	char c;
+	int count = 0;
+	int is_negative = 0;
+	bool is_integer = true;
+	long exp = 0;
+	double value;
+
+	dec.mantissa = 0;
+	dec.digits = 0;
+	dec.dropped = 0;
+#if ZETES_EXACT_NUMBERS
+	dec.extra_count = 0;
+	dec.truncated = false;
+	dec.extra_top = (const char*) ctx->buffer_end;
+#endif
+
+	c = next_char(state);
+
+	if ( is_minus(c) )
+	{
+		is_negative = 1;
+		c = next_char(state);
+	}
+
+	if ( is_digit_1_to_9(c) )
+	{
+		c = lex_digits(state, &dec, c, &count);
+		exp = dec.dropped;
+	}
+	else if ( !is_zero(c) )
+	{
+		set_error(ctx, ZETES_RESULT_INVALID_NUMBER);
+		return;
+	}
+	else
+	{
+		c = next_char(state);
+	}
+
+	if ( is_decimal_point(c) )
+	{
+		int dropped = dec.dropped;
+
+		is_integer = false;
+		c = next_char(state);
+
+		if ( !is_digit(c) )
+		{
+			set_error(ctx, ZETES_RESULT_INVALID_NUMBER);
+			return;
+		}
+
+		count = 0;
+		c = lex_digits(state, &dec, c, &count);
+		exp -= count - (dec.dropped - dropped);
+	}
+
+	if ( is_exponent_delimiter(c) )
+	{
+		long exp_part = 0;
+		int exp_negative = 0;
+
+		is_integer = false;
+		c = next_char(state);
+
+		if ( is_plus(c) )
+		{
+			c = next_char(state);
+		}
+		else if ( is_minus(c) )
+		{
+			exp_negative = 1;
+			c = next_char(state);
+		}
+
+		if ( !is_digit(c) )
+		{
+			set_error(ctx, ZETES_RESULT_INVALID_NUMBER);
+			return;
+		}
+
+		do
+		{
+			// anything beyond this saturates to zero or infinity anyway
+			if ( exp_part < 100000 ) {
+				exp_part = (exp_part * 10) + (long) c - (long) '0';
+			}
+
+			c = next_char(state);
+		} while ( is_digit(c) );
+
+		if ( exp_negative ) exp -= exp_part;
+		else exp += exp_part;
+	}
+
+	putback_char(state, c);
+
+	if ( exp < -100000 ) {
+		exp = -100000;
+	} else if ( exp > 100000 ) {
+		exp = 100000;
+	}
+
+	state->token_type = TOKEN_TYPE_LITERAL;
+
+	// plain integers are kept exact, except -0 which only a floating point value can hold
+	if ( is_integer && !dec.dropped && dec.mantissa <= (uint64_t) INT64_MAX + is_negative && !(is_negative && !dec.mantissa) ) {
+		int64_t integer = is_negative ? -(int64_t) (dec.mantissa - 1) - 1 : (int64_t) dec.mantissa;
+
+		if ( (int64_t) (zetes_int_t) integer == integer ) {
+			state->token_value.type = ZETES_TYPE_INTEGER;
+			state->token_value.variant._int = (zetes_int_t) integer;
+			return;
+		}
+	}
+
+	value = decimal_to_double(&dec, (int) exp);
+
+	if ( is_negative ) value = -value;
+
+	state->token_value.type = ZETES_TYPE_NUMBER;
+	state->token_value.variant._number = (zetes_number_t) value;
+}
+
+
+static void lex_number(rstate_t* state) {
+	zetes_t* ctx = state->ctx;
+	void* scratch = ctx->buffer_end;
+
+	// any digits lex_digits() kept in free arena space are only needed until the number is converted
+	lex_number_value(state);
+	ctx->buffer_end = scratch;
+}
+
+
+static void next_token(rstate_t* state) {
+	zetes_t* ctx = state->ctx;
+	state->token_type = TOKEN_TYPE_UNDEFINED;
+	state->token_value.type = ZETES_TYPE_NONE;
+
+	for (;;) {
+		char c;
+
+#if ZETES_DIRECT_READ
+		while ( state->buffer_i < state->buffer_e && is_whitespace(*state->buffer_i) ) {
+			state->buffer_i++;
+		}
+#endif
+
+		c = next_char(state);
+
+		if ( is_whitespace(c) ) {
+			continue;
+		} else if ( is_end_of_input(c) ) {
+			state->token_type = TOKEN_TYPE_END_OF_INPUT;
+		} else if ( is_key_val_separator(c) ) {
+			state->token_type = TOKEN_TYPE_KEY_VAL_SEPARATOR;
+		} else if ( is_comma(c) ) {
+			state->token_type = TOKEN_TYPE_COMMA;
+		} else if ( is_object_open(c) ) {
+			state->token_type = TOKEN_TYPE_OBJECT_OPEN;
+		} else if ( is_object_close(c) ) {
+			state->token_type = TOKEN_TYPE_OBJECT_CLOSE;
+		} else if ( is_array_open(c) ) {
+			state->token_type = TOKEN_TYPE_ARRAY_OPEN;
+		} else if ( is_array_close(c) ) {
+			state->token_type = TOKEN_TYPE_ARRAY_CLOSE;
+		} else if ( is_quote(c) ) {
+			lex_string(state);
+		} else if ( is_digit(c) || is_minus(c) ) {
+			putback_char(state, c);
+			lex_number(state);
+		} else if ( c == SYMBOL_NULL[0] ) {
+			if ( next_char(state) != SYMBOL_NULL[1] ||
+					next_char(state) != SYMBOL_NULL[2] ||
+					next_char(state) != SYMBOL_NULL[3] ) {
+				set_error(ctx, ZETES_RESULT_UNKNOWN_KEYWORD);
+			} else {
+				state->token_type = TOKEN_TYPE_LITERAL;
+				state->token_value.type = ZETES_TYPE_NULL;
+			}
+		} else if ( c == SYMBOL_FALSE[0] ) {
+			if ( next_char(state) != SYMBOL_FALSE[1] ||
+					next_char(state) != SYMBOL_FALSE[2] ||
+					next_char(state) != SYMBOL_FALSE[3] ||
+					next_char(state) != SYMBOL_FALSE[4] ) {
+				set_error(ctx, ZETES_RESULT_UNKNOWN_KEYWORD);
+			} else {
+				state->token_type = TOKEN_TYPE_LITERAL;
+				state->token_value.type = ZETES_TYPE_BOOL;
+				state->token_value.variant._bool = false;
+			}
+		} else if ( c == SYMBOL_TRUE[0] ) {
+			if ( next_char(state) != SYMBOL_TRUE[1] ||
+					next_char(state) != SYMBOL_TRUE[2] ||
+					next_char(state) != SYMBOL_TRUE[3] ) {
+				set_error(ctx, ZETES_RESULT_UNKNOWN_KEYWORD);
+			} else {
+				state->token_type = TOKEN_TYPE_LITERAL;
+				state->token_value.type = ZETES_TYPE_BOOL;
+				state->token_value.variant._bool = true;
+			}
+		} else {
+			set_error(ctx, ZETES_RESULT_INVALID_CHARACTER);
+		}
+		
+		break;
+	}
+}
+
+
+static bool expect_token(rstate_t* state, token_type_t type) {
+	zetes_t* ctx = state->ctx;
+
+	if ( state->token_type != type ) {
+		set_error(ctx, ZETES_RESULT_SYNTAX_ERROR);
+		return false;
+	} else {
+		return true;
+	}
+}
+
+
+static void move_scratch_to_array(zetes_t* ctx, zetes_array_t* array, zetes_value_t* scratch, size_t count) {
+	// must be called once buffer_end has been moved back above the scratch area
+	zetes_value_t* values;
+	size_t i;
+
+	// elements were stacked downwards; put them in order before moving them
+	for (i = 0; i < count / 2; i++) {
+		zetes_value_t temp = scratch[i];
+		scratch[i] = scratch[count - 1 - i];
+		scratch[count - 1 - i] = temp;
+	}
+
+	// can't fail, the scratch area itself proves there is room
+	values = (zetes_value_t*) alloc(ctx, count * sizeof(zetes_value_t));
+	memmove(values, scratch, count * sizeof(zetes_value_t));
+
+	array->values = values;
+	array->count = count;
+	array->size = count;
+}
+
+
+static void move_scratch_to_object(zetes_t* ctx, zetes_object_t* object, zetes_object_member_t* scratch, size_t count) {
+	// as move_scratch_to_array(), then a key seen more than once keeps its first place and its last value
+	zetes_object_member_t* members;
+	size_t i;
+
+	for (i = 0; i < count / 2; i++) {
+		zetes_object_member_t temp = scratch[i];
+		scratch[i] = scratch[count - 1 - i];
+		scratch[count - 1 - i] = temp;
+	}
+
+	// can't fail, the scratch area itself proves there is room
+	members = (zetes_object_member_t*) alloc(ctx, count * sizeof(zetes_object_member_t));
+	memmove(members, scratch, count * sizeof(zetes_object_member_t));
+
+	object->members = members;
+	object->count = 0;
+
+	if ( count >= ZETES_OBJECT_INDEX_THRESHOLD ) {
+		build_index(ctx, object, count);
+	}
+
+	for (i = 0; i < count; i++) {
+		zetes_object_member_t* member = find_member(object, members[i].key, members[i].key_length, members[i].key_hash);
+
+		if ( member ) {
+			member->value = members[i].value;
+		} else {
+			member = &members[object->count++];
+			*member = members[i];
+
+			if ( object->index ) {
+				index_member(object, member);
+			}
+		}
+	}
+
+	object->size = object->count;
+}
+
+
+void zetes_set_max_depth(zetes_t* ctx, size_t max_depth) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+	ZETES_ASSERT(max_depth > 0);
+	ZETES_ASSERT(ctx->buffer_ptr == ctx->buffer_base);
+
+	uint8_t* bits = NULL;
+
+	if ( max_depth > ZETES_MAX_DEPTH ) {
+		// more than the context itself has room for
+		bits = (uint8_t*) alloc(ctx, (max_depth + 7) / 8);
+
+		if ( !bits ) {
+			return;
+		}
+
+		keep_allocations(ctx);
+	}
+
+	ctx->reader.nesting_ext = bits;
+	ctx->reader.max_depth = max_depth;
+}
+
+
+void zetes_set_read_buffer(zetes_t* ctx, void* buffer, size_t buffer_size) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+	ZETES_ASSERT(buffer_size > 0);
+	ZETES_ASSERT(ctx->buffer_ptr == ctx->buffer_base);
+
+	if ( buffer_size > INT_MAX ) {
+		buffer_size = INT_MAX;
+	}
+
+	if ( !buffer ) {
+		// carve the buffer from the arena and keep it across zetes_reset()
+		buffer = alloc(ctx, buffer_size);
+
+		if ( !buffer ) {
+			return;
+		}
+
+		keep_allocations(ctx);
+	}
+
+	ctx->read_buffer = (char*) buffer;
+	ctx->read_buffer_size = buffer_size;
+}
+
+
+static void init_rstate(rstate_t* state, zetes_t* ctx, zetes_read_func_t read_func, void* user_data, char* buffer_i,
+		char* buffer_e, bool insitu) {
+	state->ctx = ctx;
+	state->read_func = read_func;
+	state->user_data = user_data;
+	state->buffer_i = buffer_i;
+	state->buffer_e = buffer_e;
+	state->insitu = insitu;
+	state->partial = false;
+	state->starved = false;
+	state->multiple = false;
+	state->next_i = NULL;
+	state->next_e = NULL;
+	state->token_type = TOKEN_TYPE_UNDEFINED;
+}
+
+
+static zetes_result_t read_document(rstate_t* state) {
+	zetes_t* ctx = state->ctx;
+	zetes_reader_t* reader = &ctx->reader;
+
+	reader->saved_depth = scratch_depth(ctx);
+
+	parse_document(state);
+
+	// array scratch areas left open by an error
+	ctx->buffer_end = scratch_at(ctx, reader->saved_depth);
+
+	return ctx->result;
+}
+
+zetes_result_t zetes_read(zetes_t* ctx, zetes_read_func_t read_func, void* user_data) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+	ZETES_ASSERT(read_func);
+
+	if ( ok(ctx) ) {
+		rstate_t rstate;
+
+		init_rstate(&rstate, ctx, read_func, user_data, NULL, NULL, false);
+
+		read_document(&rstate);
+	}
+
+	return ctx->result;
+}
+
+
+#if ZETES_DIRECT_READ
+
+zetes_result_t zetes_read_buffer(zetes_t* ctx, const char* buffer, size_t buffer_size) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+	ZETES_ASSERT(buffer);
+
+	if ( ok(ctx) ) {
+		rstate_t rstate;
+
+		// the buffer is only ever read from, insitu is false
+		init_rstate(&rstate, ctx, NULL, NULL, (char*) buffer, (char*) buffer + buffer_size, false);
+
+		read_document(&rstate);
+	}
+
+	return ctx->result;
+}
+
+#else
+
+static int read_buffer_func(void* buffer, int length, void* user_data) {
+	read_buffer_state_t* state = (read_buffer_state_t*) user_data;
+	size_t remaining = state->e - state->i;
+
+	if ( length > remaining ) {
+		length = remaining;
+	}
+
+	memcpy(buffer, state->i, length);
+	state->i += length;
+
+	return length;
+}
+
+
+zetes_result_t zetes_read_buffer(zetes_t* ctx, const char* buffer, size_t buffer_size) {
+	read_buffer_state_t state;
+
+	state.i = buffer;
+	state.e = buffer + buffer_size;
+
+	return zetes_read(ctx, read_buffer_func, &state);
+}
+
+#endif
+
+
+zetes_result_t zetes_read_insitu(zetes_t* ctx, char* buffer, size_t buffer_size) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+	ZETES_ASSERT(buffer);
+
+	if ( ok(ctx) ) {
+		rstate_t rstate;
+
+		init_rstate(&rstate, ctx, NULL, NULL, buffer, buffer + buffer_size, true);
+
+		read_document(&rstate);
+	}
+
+	return ctx->result;
+}
+
+
+static void begin_documents(zetes_t* ctx, zetes_read_func_t read_func, void* user_data, char* buffer_i,
+		char* buffer_e, bool insitu) {
+	zetes_reader_t* reader = &ctx->reader;
+
+	// the input position is kept with the event reader's, but the event state stays idle so that
+	// zetes_reset() between documents leaves it alone
+	ZETES_ASSERT(reader->state == EVENT_STATE_IDLE);
+
+	reader->read_func = read_func;
+	reader->user_data = user_data;
+	reader->buffer_i = buffer_i;
+	reader->buffer_e = buffer_e;
+	reader->insitu = insitu;
+}
+
+
+void zetes_begin_documents(zetes_t* ctx, zetes_read_func_t read_func, void* user_data) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+	ZETES_ASSERT(read_func);
+
+	begin_documents(ctx, read_func, user_data, NULL, NULL, false);
+}
+
+
+void zetes_begin_documents_buffer(zetes_t* ctx, const char* buffer, size_t buffer_size) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+	ZETES_ASSERT(buffer);
+
+	begin_documents(ctx, NULL, NULL, (char*) buffer, (char*) buffer + buffer_size, false);
+}
+
+
+void zetes_begin_documents_insitu(zetes_t* ctx, char* buffer, size_t buffer_size) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+	ZETES_ASSERT(buffer);
+
+	begin_documents(ctx, NULL, NULL, buffer, buffer + buffer_size, true);
+}
+
+
+bool zetes_read_next(zetes_t* ctx) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+	ZETES_ASSERT(ctx->reader.state == EVENT_STATE_IDLE);
+
+	zetes_reader_t* reader = &ctx->reader;
+	rstate_t rstate;
+	char c;
+
+	if ( !ok(ctx) ) {
+		return false;
+	}
+
+	init_rstate(&rstate, ctx, reader->read_func, reader->user_data, reader->buffer_i, reader->buffer_e, reader->insitu);
+	rstate.multiple = true;
+
+	// whitespace between documents, or after the last one
+	do {
+		c = next_char(&rstate);
+	} while ( is_whitespace(c) );
+
+	if ( !is_end_of_input(c) ) {
+		putback_char(&rstate, c);
+		read_document(&rstate);
+	}
+
+	reader->buffer_i = rstate.buffer_i;
+	reader->buffer_e = rstate.buffer_e;
+
+	return ok(ctx) && !is_end_of_input(c);
+}
+
+
+size_t zetes_split_documents(const char* buffer, size_t buffer_size, size_t* offsets, size_t count) {
+	ZETES_ASSERT(buffer || buffer_size == 0);
+	ZETES_ASSERT(offsets);
+	ZETES_ASSERT(count > 0);
+
+	size_t chunks = 0;
+	size_t offset = 0;
+
+	// Divides newline delimited documents into up to count chunks of about the same size, for parsing
+	// separately (each with its own context, which shares nothing with any other). A raw newline
+	// can't appear inside a string, so every one of them is a boundary between documents.
+	while ( chunks < count && offset < buffer_size ) {
+		size_t target = offset + (buffer_size - offset) / (count - chunks);
+		const char* newline = NULL;
+
+		offsets[chunks++] = offset;
+
+		if ( target < buffer_size ) {
+			newline = (const char*) memchr(buffer + target, '\n', buffer_size - target);
+		}
+
+		offset = newline ? (size_t) (newline - buffer) + 1 : buffer_size;
+	}
+
+	return chunks;
+}
+
+
+static size_t voffset(const vstate_t* vs) {
+	return vs->consumed + (size_t) (vs->i - vs->window);
+}
+
+
+static bool vfail(vstate_t* vs, zetes_result_t result, size_t offset) {
+	if ( vs->result == ZETES_RESULT_OK ) {
+		vs->result = result;
+		vs->error_offset = offset;
+	}
+
+	return false;
+}
+
+
+static bool vrefill(vstate_t* vs) {
+	int n_read;
+
+	vs->consumed += (size_t) (vs->e - vs->window);
+	vs->window = vs->e;
+	vs->i = vs->e;
+
+	if ( !vs->read_func ) {
+		return false;
+	}
+
+	n_read = vs->read_func(vs->buffer, (int) vs->buffer_size, vs->user_data);
+
+	if ( n_read < 0 ) {
+		return vfail(vs, ZETES_RESULT_READ_ERROR, vs->consumed);
+	}
+
+	vs->window = vs->buffer;
+	vs->i = vs->buffer;
+	vs->e = vs->buffer + n_read;
+
+	return n_read > 0;
+}
+
+
+static inline int vnext(vstate_t* vs) {
+	// the next byte, or -1 at the end of the input
+	if ( vs->i >= vs->e && !vrefill(vs) ) {
+		return -1;
+	}
+
+	return (uint8_t) *(vs->i++);
+}
+
+
+static bool vdigit(int c) {
+	return c >= '0' && c <= '9';
+}
+
+
+static bool validate_utf8(vstate_t* vs, int c) {
+	// c, just read, starts a multi-byte sequence
+	size_t offset = voffset(vs) - 1;
+	char sequence[4];
+	int n;
+
+	if ( c < 0xC2 || c > 0xF4 ) {
+		return vfail(vs, ZETES_RESULT_INVALID_STRING, offset);
+	}
+
+	if ( vs->e - vs->i >= 3 ) {
+		n = utf8_length(vs->i - 1, vs->e);
+
+		if ( n == 0 ) {
+			return vfail(vs, ZETES_RESULT_INVALID_STRING, offset);
+		}
+
+		vs->i += n - 1;
+		return true;
+	}
+
+	// near the end of the window the sequence may continue into the next one
+	n = (c < 0xE0) ? 2 : (c < 0xF0) ? 3 : 4;
+	sequence[0] = (char) c;
+
+	for (int k = 1; k < n; k++) {
+		c = vnext(vs);
+
+		if ( c < 0 ) {
+			return vfail(vs, ZETES_RESULT_UNEXPECTED_END_OF_INPUT, voffset(vs));
+		}
+
+		sequence[k] = (char) c;
+	}
+
+	return utf8_length(sequence, sequence + n) == n || vfail(vs, ZETES_RESULT_INVALID_STRING, offset);
+}
+
+
+static bool validate_string(vstate_t* vs) {
+	// checks a string up to and including its closing quote, the opening one having been read
+	for (;;) {
+		int c;
+
+#if ZETES_SIMD
+		vs->i = scan_unescaped(vs->i, vs->e);
+#endif
+
+		while ( vs->i < vs->e && (uint8_t) *vs->i >= 0x20 && (uint8_t) *vs->i < 0x80 && !is_quote(*vs->i) &&
+				!is_escape(*vs->i) ) {
+			vs->i++;
+		}
+
+		c = vnext(vs);
+
+		if ( c < 0 ) {
+			return vfail(vs, ZETES_RESULT_UNEXPECTED_END_OF_INPUT, voffset(vs));
+		} else if ( c == '"' ) {
+			return true;
+		} else if ( c < 0x20 ) {
+			return vfail(vs, ZETES_RESULT_INVALID_CHARACTER, voffset(vs) - 1);
+		} else if ( c >= 0x80 ) {
+			if ( vs->check_utf8 && !validate_utf8(vs, c) ) {
+				return false;
+			}
+		} else if ( c == '\\' ) {
+			c = vnext(vs);
+
+			if ( c == 'u' ) {
+				for (int n = 0; n < 4; n++) {
+					c = vnext(vs);
+
+					if ( !vdigit(c) && !(c >= 'a' && c <= 'f') && !(c >= 'A' && c <= 'F') ) {
+						return vfail(vs, ZETES_RESULT_INVALID_STRING, voffset(vs) - (c >= 0));
+					}
+				}
+			} else if ( c <= 0 || !strchr("\"\\/bfnrt", c) ) {
+				return vfail(vs, ZETES_RESULT_INVALID_STRING, voffset(vs) - (c >= 0));
+			}
+		}
+	}
+}
+
+
+static int vskip_digits(vstate_t* vs) {
+	// the first character after a run of digits
+	int c;
+
+	do {
+		while ( vs->i < vs->e && is_digit(*vs->i) ) {
+			vs->i++;
+		}
+
+		c = vnext(vs);
+	} while ( vdigit(c) );
+
+	return c;
+}
+
+
+static bool validate_number(vstate_t* vs, int c) {
+	// -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?, c being its first character
+	size_t offset = voffset(vs) - 1;
+
+	if ( c == '-' ) {
+		c = vnext(vs);
+	}
+
+	if ( c == '0' ) {
+		c = vnext(vs);
+	} else if ( vdigit(c) ) {
+		c = vskip_digits(vs);
+	} else {
+		return vfail(vs, ZETES_RESULT_INVALID_NUMBER, offset);
+	}
+
+	if ( c == '.' ) {
+		c = vnext(vs);
+
+		if ( !vdigit(c) ) {
+			return vfail(vs, ZETES_RESULT_INVALID_NUMBER, offset);
+		}
+
+		c = vskip_digits(vs);
+	}
+
+	if ( c == 'e' || c == 'E' ) {
+		c = vnext(vs);
+
+		if ( c == '+' || c == '-' ) {
+			c = vnext(vs);
+		}
+
+		if ( !vdigit(c) ) {
+			return vfail(vs, ZETES_RESULT_INVALID_NUMBER, offset);
+		}
+
+		c = vskip_digits(vs);
+	}
+
+	// the character after the number belongs to the next token
+	if ( c >= 0 ) {
+		vs->i--;
+	}
+
+	return true;
+}
+
+
+static bool validate_keyword(vstate_t* vs, const char* keyword, size_t length) {
+	// the first character has been read already
+	size_t offset = voffset(vs) - 1;
+
+	for (size_t n = 1; n < length; n++) {
+		if ( vnext(vs) != (uint8_t) keyword[n] ) {
+			return vfail(vs, ZETES_RESULT_UNKNOWN_KEYWORD, offset);
+		}
+	}
+
+	return true;
+}
+
+
+static token_type_t validate_token(vstate_t* vs) {
+	// as next_token(), but only checking each token: is_string tells keys apart from other literals
+	int c;
+
+	for (;;) {
+		while ( vs->i < vs->e && is_whitespace(*vs->i) ) {
+			vs->i++;
+		}
+
+		c = vnext(vs);
+
+		if ( c < 0 || !is_whitespace((char) c) ) {
+			break;
+		}
+	}
+
+	vs->token_offset = voffset(vs) - (c >= 0);
+	vs->is_string = false;
+
+	switch(c) {
+	case -1:	return vs->result == ZETES_RESULT_OK ? TOKEN_TYPE_END_OF_INPUT : TOKEN_TYPE_UNDEFINED;
+	case ':':	return TOKEN_TYPE_KEY_VAL_SEPARATOR;
+	case ',':	return TOKEN_TYPE_COMMA;
+	case '{':	return TOKEN_TYPE_OBJECT_OPEN;
+	case '}':	return TOKEN_TYPE_OBJECT_CLOSE;
+	case '[':	return TOKEN_TYPE_ARRAY_OPEN;
+	case ']':	return TOKEN_TYPE_ARRAY_CLOSE;
+
+	case '"':
+		vs->is_string = true;
+		return validate_string(vs) ? TOKEN_TYPE_LITERAL : TOKEN_TYPE_UNDEFINED;
+
+	case 't':
+		return validate_keyword(vs, SYMBOL_TRUE, sizeof(SYMBOL_TRUE)) ? TOKEN_TYPE_LITERAL : TOKEN_TYPE_UNDEFINED;
+
+	case 'f':
+		return validate_keyword(vs, SYMBOL_FALSE, sizeof(SYMBOL_FALSE)) ? TOKEN_TYPE_LITERAL : TOKEN_TYPE_UNDEFINED;
+
+	case 'n':
+		return validate_keyword(vs, SYMBOL_NULL, sizeof(SYMBOL_NULL)) ? TOKEN_TYPE_LITERAL : TOKEN_TYPE_UNDEFINED;
+
+	default:
+		if ( c == '-' || vdigit(c) ) {
+			return validate_number(vs, c) ? TOKEN_TYPE_LITERAL : TOKEN_TYPE_UNDEFINED;
+		}
+
+		vfail(vs, ZETES_RESULT_INVALID_CHARACTER, vs->token_offset);
+		return TOKEN_TYPE_UNDEFINED;
+	}
+}
+
+
+static bool validate_expect(vstate_t* vs, token_type_t token, token_type_t type) {
+	// a token that failed to lex has already set the result
+	return token == type || vfail(vs, ZETES_RESULT_SYNTAX_ERROR, vs->token_offset);
+}
+
+
+static bool validate_key(vstate_t* vs, token_type_t token) {
+	if ( token != TOKEN_TYPE_LITERAL || !vs->is_string ) {
+		return vfail(vs, ZETES_RESULT_SYNTAX_ERROR, vs->token_offset);
+	}
+
+	return validate_expect(vs, validate_token(vs), TOKEN_TYPE_KEY_VAL_SEPARATOR);
+}
+
+
+static zetes_result_t validate_document(vstate_t* vs, uint8_t* nesting, size_t max_depth, size_t* error_offset) {
+	// parse_document() without building anything; only the kind of each open container is kept
+	size_t depth = 0;
+	token_type_t token = validate_token(vs);
+
+	while ( vs->result == ZETES_RESULT_OK ) {
+		bool is_object;
+
+		// a value is due, and token is its first
+		if ( token == TOKEN_TYPE_OBJECT_OPEN || token == TOKEN_TYPE_ARRAY_OPEN ) {
+			is_object = (token == TOKEN_TYPE_OBJECT_OPEN);
+			token = validate_token(vs);
+
+			if ( depth >= max_depth ) {
+				vfail(vs, ZETES_RESULT_NESTING_TOO_DEEP, vs->token_offset);
+				break;
+			}
+
+			if ( token != (is_object ? TOKEN_TYPE_OBJECT_CLOSE : TOKEN_TYPE_ARRAY_CLOSE) ) {
+				if ( is_object ) {
+					nesting[depth / 8] |= (uint8_t) (1U << (depth % 8));
+				} else {
+					nesting[depth / 8] &= (uint8_t) ~(1U << (depth % 8));
+				}
+
+				depth++;
+
+				if ( is_object && validate_key(vs, token) ) {
+					token = validate_token(vs);
+				}
+
+				continue;
+			}
+		} else if ( !validate_expect(vs, token, TOKEN_TYPE_LITERAL) ) {
+			break;
+		}
+
+		// the value is complete: close any containers that end with it, until the next value is due
+		while ( vs->result == ZETES_RESULT_OK ) {
+			token = validate_token(vs);
+
+			if ( depth == 0 ) {
+				validate_expect(vs, token, TOKEN_TYPE_END_OF_INPUT);
+				break;
+			}
+
+			is_object = (nesting[(depth - 1) / 8] & (1U << ((depth - 1) % 8))) != 0;
+
+			if ( token == TOKEN_TYPE_COMMA ) {
+				token = validate_token(vs);
+
+				if ( is_object && validate_key(vs, token) ) {
+					token = validate_token(vs);
+				}
+
+				break;
+			} else if ( validate_expect(vs, token, is_object ? TOKEN_TYPE_OBJECT_CLOSE : TOKEN_TYPE_ARRAY_CLOSE) ) {
+				depth--;
+			}
+		}
+
+		if ( depth == 0 ) {
+			break;
+		}
+	}
+
+	if ( vs->result != ZETES_RESULT_OK && error_offset ) {
+		*error_offset = vs->error_offset;
+	}
+
+	return vs->result;
+}
+
+
+static void init_vstate(vstate_t* vs, zetes_read_func_t read_func, void* user_data, char* buffer, size_t buffer_size) {
+	vs->read_func = read_func;
+	vs->user_data = user_data;
+	vs->buffer = buffer;
+	vs->buffer_size = buffer_size;
+	vs->window = buffer;
+	vs->i = buffer;
+	vs->e = buffer;
+	vs->consumed = 0;
+	vs->result = ZETES_RESULT_OK;
+	vs->error_offset = 0;
+	vs->token_offset = 0;
+	vs->is_string = false;
+	vs->check_utf8 = true;
+}
+
+
+zetes_result_t zetes_validate(zetes_read_func_t read_func, void* user_data, char* buffer, size_t buffer_size,
+		size_t* error_offset) {
+	ZETES_ASSERT(read_func);
+	ZETES_ASSERT(buffer);
+	ZETES_ASSERT(buffer_size > 0);
+
+	uint8_t nesting[(ZETES_MAX_DEPTH + 7) / 8];
+	vstate_t vs;
+
+	init_vstate(&vs, read_func, user_data, buffer, buffer_size > INT_MAX ? INT_MAX : buffer_size);
+
+	return validate_document(&vs, nesting, ZETES_MAX_DEPTH, error_offset);
+}
+
+
+zetes_result_t zetes_validate_buffer(const char* buffer, size_t buffer_size, size_t* error_offset) {
+	ZETES_ASSERT(buffer || buffer_size == 0);
+
+	uint8_t nesting[(ZETES_MAX_DEPTH + 7) / 8];
+	vstate_t vs;
+
+	// the whole input is the one window, so there is never anything to read into
+	init_vstate(&vs, NULL, NULL, (char*) buffer, 0);
+	vs.e = buffer + buffer_size;
+
+	return validate_document(&vs, nesting, ZETES_MAX_DEPTH, error_offset);
+}
+
+
+static void begin_events(zetes_t* ctx, zetes_read_func_t read_func, void* user_data, char* buffer_i, char* buffer_e,
+		bool insitu) {
+	zetes_reader_t* reader = &ctx->reader;
+
+	reader->read_func = read_func;
+	reader->user_data = user_data;
+	reader->buffer_i = buffer_i;
+	reader->buffer_e = buffer_e;
+	reader->insitu = insitu;
+	reader->state = EVENT_STATE_VALUE;
+	reader->event = ZETES_EVENT_NONE;
+	reader->depth = 0;
+	reader->transient = NULL;
+	reader->transient_end = NULL;
+	reader->value.type = ZETES_TYPE_NONE;
+	reader->saved_depth = scratch_depth(ctx);
+	reader->carry = NULL;
+	reader->carry_length = 0;
+	reader->carry_escape = false;
+}
+
+
+void zetes_begin_events(zetes_t* ctx, zetes_read_func_t read_func, void* user_data) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+	ZETES_ASSERT(read_func);
+
+	begin_events(ctx, read_func, user_data, NULL, NULL, false);
+}
+
+
+void zetes_begin_events_buffer(zetes_t* ctx, const char* buffer, size_t buffer_size) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+	ZETES_ASSERT(buffer);
+
+	// the buffer is only ever read from, insitu is false
+	begin_events(ctx, NULL, NULL, (char*) buffer, (char*) buffer + buffer_size, false);
+}
+
+
+void zetes_begin_events_insitu(zetes_t* ctx, char* buffer, size_t buffer_size) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+	ZETES_ASSERT(buffer);
+
+	begin_events(ctx, NULL, NULL, buffer, buffer + buffer_size, true);
+}
+
+
+static uint8_t* nesting_bits(zetes_reader_t* reader) {
+	return reader->nesting_ext ? reader->nesting_ext : reader->nesting;
+}
+
+
+static bool push_nesting(zetes_t* ctx, size_t depth, bool is_object) {
+	// one bit per open container, set for objects
+	zetes_reader_t* reader = &ctx->reader;
+	uint8_t* bits = nesting_bits(reader);
+	uint8_t bit = (uint8_t) (1U << (depth % 8));
+
+	if ( depth >= reader->max_depth ) {
+		set_error(ctx, ZETES_RESULT_NESTING_TOO_DEEP);
+		return false;
+	}
+
+#if ZETES_STATS
+	if ( depth + 1 > ctx->stats.depth_peak ) {
+		ctx->stats.depth_peak = depth + 1;
+	}
+#endif
+
+	if ( is_object ) {
+		bits[depth / 8] |= bit;
+	} else {
+		bits[depth / 8] &= (uint8_t) ~bit;
+	}
+
+	return true;
+}
+
+
+static bool is_object_nesting(zetes_reader_t* reader, size_t depth) {
+	size_t level = depth - 1;
+
+	return (nesting_bits(reader)[level / 8] >> (level % 8)) & 1U;
+}
+
+
+static bool event_push_nesting(zetes_t* ctx, bool is_object) {
+	zetes_reader_t* reader = &ctx->reader;
+
+	if ( !push_nesting(ctx, reader->depth, is_object) ) {
+		return false;
+	}
+
+	reader->depth++;
+
+	return true;
+}
+
+
+static bool event_in_object(zetes_reader_t* reader) {
+	return is_object_nesting(reader, reader->depth);
+}
+
+
+static void event_after_value(zetes_reader_t* reader) {
+	reader->state = reader->depth ? EVENT_STATE_NEXT : EVENT_STATE_END;
+}
+
+
+static zetes_event_t event_pop_nesting(zetes_reader_t* reader) {
+	zetes_event_t event = event_in_object(reader) ? ZETES_EVENT_OBJECT_END : ZETES_EVENT_ARRAY_END;
+
+	reader->depth--;
+	event_after_value(reader);
+
+	return event;
+}
+
+
+static zetes_event_t event_value(rstate_t* state) {
+	zetes_t* ctx = state->ctx;
+	zetes_reader_t* reader = &ctx->reader;
+	zetes_event_t event = ZETES_EVENT_NONE;
+
+	if ( state->token_type == TOKEN_TYPE_OBJECT_OPEN ) {
+		if ( event_push_nesting(ctx, true) ) {
+			reader->state = EVENT_STATE_FIRST_KEY;
+			event = ZETES_EVENT_OBJECT_BEGIN;
+		}
+	} else if ( state->token_type == TOKEN_TYPE_ARRAY_OPEN ) {
+		if ( event_push_nesting(ctx, false) ) {
+			reader->state = EVENT_STATE_FIRST_VALUE;
+			event = ZETES_EVENT_ARRAY_BEGIN;
+		}
+	} else if ( expect_token(state, TOKEN_TYPE_LITERAL) ) {
+		reader->value = state->token_value;
+		event_after_value(reader);
+		event = ZETES_EVENT_VALUE;
+	}
+
+	return event;
+}
+
+
+static zetes_event_t event_key(rstate_t* state) {
+	zetes_t* ctx = state->ctx;
+	zetes_reader_t* reader = &ctx->reader;
+	zetes_event_t event = ZETES_EVENT_NONE;
+
+	if ( state->token_type != TOKEN_TYPE_LITERAL || state->token_value.type != ZETES_TYPE_STRING ) {
+		set_error(ctx, ZETES_RESULT_SYNTAX_ERROR);
+	} else {
+		reader->value = state->token_value;
+		reader->state = EVENT_STATE_COLON;
+		event = ZETES_EVENT_KEY;
+	}
+
+	return event;
+}
+
+
+static zetes_event_t read_event_token(rstate_t* state) {
+	// Consumes a single token and advances the event state machine, returning the event it completes,
+	// if any. A token cut short by the end of a fed chunk leaves the state machine untouched.
+	zetes_t* ctx = state->ctx;
+	zetes_reader_t* reader = &ctx->reader;
+	zetes_event_t event = ZETES_EVENT_NONE;
+
+	if ( reader->state == EVENT_STATE_DONE ) {
+		return ZETES_EVENT_END;
+	}
+
+	state->starved = false;
+	next_token(state);
+
+	if ( state->starved ) {
+		// whatever the lexer made of running out of input doesn't count
+		ctx->result = ZETES_RESULT_OK;
+		return ZETES_EVENT_NONE;
+	}
+
+	switch ( reader->state ) {
+	case EVENT_STATE_FIRST_VALUE:
+		if ( state->token_type == TOKEN_TYPE_ARRAY_CLOSE ) {
+			event = event_pop_nesting(reader);
+			break;
+		}
+
+		// fall through
+	case EVENT_STATE_VALUE:
+		event = event_value(state);
+		break;
+
+	case EVENT_STATE_FIRST_KEY:
+		if ( state->token_type == TOKEN_TYPE_OBJECT_CLOSE ) {
+			event = event_pop_nesting(reader);
+			break;
+		}
+
+		// fall through
+	case EVENT_STATE_KEY:
+		event = event_key(state);
+		break;
+
+	case EVENT_STATE_COLON:
+		if ( expect_token(state, TOKEN_TYPE_KEY_VAL_SEPARATOR) ) {
+			reader->state = EVENT_STATE_VALUE;
+		}
+
+		break;
+
+	case EVENT_STATE_NEXT:
+		if ( state->token_type == TOKEN_TYPE_COMMA ) {
+			reader->state = event_in_object(reader) ? EVENT_STATE_KEY : EVENT_STATE_VALUE;
+		} else if ( state->token_type == (event_in_object(reader) ? TOKEN_TYPE_OBJECT_CLOSE : TOKEN_TYPE_ARRAY_CLOSE) ) {
+			event = event_pop_nesting(reader);
+		} else {
+			set_error(ctx, ZETES_RESULT_SYNTAX_ERROR);
+		}
+
+		break;
+
+	default:
+		if ( expect_token(state, TOKEN_TYPE_END_OF_INPUT) ) {
+			reader->state = EVENT_STATE_DONE;
+			event = ZETES_EVENT_END;
+		}
+
+		break;
+	}
+
+	return ok(ctx) ? event : ZETES_EVENT_NONE;
+}
+
+
+zetes_event_t zetes_next_event(zetes_t* ctx) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+	ZETES_ASSERT(ctx->reader.state != EVENT_STATE_IDLE);
+
+	zetes_reader_t* reader = &ctx->reader;
+	zetes_event_t event = ZETES_EVENT_NONE;
+	rstate_t rstate;
+	void* mark;
+
+	// strings lexed for the previous event are released again, unless the arena was used since
+	if ( reader->transient && ctx->buffer_ptr == reader->transient_end ) {
+		ctx->buffer_ptr = reader->transient;
+	}
+
+	reader->transient = NULL;
+	reader->value.type = ZETES_TYPE_NONE;
+
+	if ( !ok(ctx) ) {
+		reader->event = ZETES_EVENT_NONE;
+		return ZETES_EVENT_NONE;
+	}
+
+	init_rstate(&rstate, ctx, reader->read_func, reader->user_data, reader->buffer_i, reader->buffer_e, reader->insitu);
+	mark = ctx->buffer_ptr;
+
+	while ( event == ZETES_EVENT_NONE && ok(ctx) ) {
+		event = read_event_token(&rstate);
+	}
+
+	if ( ctx->buffer_ptr != mark ) {
+		reader->transient = mark;
+		reader->transient_end = ctx->buffer_ptr;
+	}
+
+	reader->buffer_i = rstate.buffer_i;
+	reader->buffer_e = rstate.buffer_e;
+	reader->event = event;
+
+	return event;
+}
+
+
+void zetes_skip_event(zetes_t* ctx) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+
+	zetes_reader_t* reader = &ctx->reader;
+	zetes_event_t event = reader->event;
+
+	// skipping a key skips its value as well
+	if ( event == ZETES_EVENT_KEY ) {
+		event = zetes_next_event(ctx);
+	}
+
+	if ( event == ZETES_EVENT_OBJECT_BEGIN || event == ZETES_EVENT_ARRAY_BEGIN ) {
+		size_t depth = reader->depth;
+
+		while ( reader->depth >= depth && zetes_next_event(ctx) != ZETES_EVENT_NONE ) {
+			// discard everything up to the matching end event
+		}
+	}
+}
+
+
+size_t zetes_event_depth(const zetes_t* ctx) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+
+	return ctx->reader.depth;
+}
+
+
+zetes_type_t zetes_event_type(const zetes_t* ctx) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+
+	return ctx->reader.value.type;
+}
+
+
+const char* zetes_event_string_n(zetes_t* ctx, size_t* length) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+
+	const char* value = NULL;
+
+	if ( ok(ctx) && type_validate(ctx, ZETES_TYPE_STRING, ctx->reader.value.type) ) {
+		value = ctx->reader.value.variant._string;
+
+		if ( length ) {
+			*length = ctx->reader.value.length;
+		}
+	}
+
+	return value;
+}
+
+
+void zetes_push_event_value(zetes_t* ctx) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+
+	if ( ok(ctx) ) {
+		if ( ctx->reader.value.type == ZETES_TYPE_NONE ) {
+			set_error(ctx, ZETES_RESULT_TYPE_MISMATCH);
+		} else {
+			zetes_value_t* slot = stack_emplace(ctx);
+
+			if ( slot ) {
+				*slot = ctx->reader.value;
+
+				// the value now outlives the event, so its string must too
+				ctx->reader.transient = NULL;
+			}
+		}
+	}
+}
+
+
+static void* push_scratch(zetes_t* ctx, size_t size) {
+	// makes room for an entry in the scratch area of the innermost open container
+	char* scratch = (char*) ctx->buffer_end;
+
+	if ( scratch - (char*) ctx->buffer_ptr < (ptrdiff_t) size ) {
+		// with an allocator the whole scratch area moves to a new block, with room to double
+		if ( !grow_arena(ctx, scratch_depth(ctx) + size) ) {
+			set_error(ctx, ZETES_RESULT_OUT_OF_MEMORY);
+			return NULL;
+		}
+
+		scratch = (char*) ctx->buffer_end;
+	}
+
+	scratch -= size;
+	ctx->buffer_end = scratch;
+
+#if ZETES_STATS
+	count_arena(ctx, 0);
+#endif
+
+	return scratch;
+}
+
+
+static bool build_append(zetes_t* ctx, const zetes_value_t* value) {
+	// adds a value to the scratch area of the innermost open array
+	zetes_value_t* slot = (zetes_value_t*) push_scratch(ctx, sizeof(zetes_value_t));
+
+	if ( slot ) {
+		*slot = *value;
+	}
+
+	return slot != NULL;
+}
+
+
+static bool build_member(zetes_t* ctx, const char* key, size_t key_length, uint32_t hash, const zetes_value_t* value) {
+	// adds a member to the scratch area of the innermost open object
+	zetes_object_member_t* member = (zetes_object_member_t*) push_scratch(ctx, sizeof(zetes_object_member_t));
+
+	if ( member ) {
+		member->key = key;
+		member->key_length = (uint32_t) key_length;
+		member->key_hash = hash;
+		member->value = *value;
+	}
+
+	return member != NULL;
+}
+
+
+static void build_end_object(zetes_t* ctx) {
+	zetes_object_t* object = ctx->stack_ptr->variant._object;
+	zetes_object_member_t* scratch_top = (zetes_object_member_t*) scratch_at(ctx, object->size);
+	zetes_object_member_t* scratch = (zetes_object_member_t*) ctx->buffer_end;
+	size_t count = scratch_top - scratch;
+
+	ctx->buffer_end = scratch_top;
+	object->size = 0;
+
+	if ( count > 0 ) {
+		move_scratch_to_object(ctx, object, scratch, count);
+	}
+}
+
+
+static void build_begin_object(zetes_t* ctx) {
+	zetes_push_new_object(ctx);
+
+	if ( ok(ctx) ) {
+		zetes_object_t* object = ctx->stack_ptr->variant._object;
+
+		// as with arrays, until the object is closed its size holds the depth of its scratch area
+		object->size = (size_t) ((char*) ctx->buffer_top - (char*) align_down(ctx->buffer_end));
+		ctx->buffer_end = scratch_at(ctx, object->size);
+	}
+}
+
+
+static void build_end_array(zetes_t* ctx) {
+	zetes_array_t* array = ctx->stack_ptr->variant._array;
+	zetes_value_t* scratch_top = (zetes_value_t*) scratch_at(ctx, array->size);
+	zetes_value_t* scratch = (zetes_value_t*) ctx->buffer_end;
+	size_t count = scratch_top - scratch;
+
+	ctx->buffer_end = scratch_top;
+	array->size = 0;
+
+	if ( count > 0 ) {
+		move_scratch_to_array(ctx, array, scratch, count);
+	}
+}
+
+
+static void build_begin_array(zetes_t* ctx) {
+	zetes_push_new_array(ctx);
+
+	if ( ok(ctx) ) {
+		zetes_array_t* array = ctx->stack_ptr->variant._array;
+
+		// until the array is closed its size holds the depth of the top of its scratch area
+		array->size = (size_t) ((char*) ctx->buffer_top - (char*) align_down(ctx->buffer_end));
+		ctx->buffer_end = scratch_at(ctx, array->size);
+	}
+}
+
+
+static void build_key(zetes_t* ctx, const zetes_value_t* key) {
+	zetes_value_t* slot = stack_emplace(ctx);
+
+	if ( slot ) {
+		const char* str = key->variant._string;
+		size_t length = key->length;
+
+		*slot = *key;
+
+		if ( ctx->intern_table ) {
+			slot->variant._string = intern_key(ctx, str, length, hash_key(str, length), false);
+
+			// drop the freshly lexed copy if an earlier one was found
+			if ( slot->variant._string != str && (char*) str + length + 1 == (char*) ctx->buffer_ptr ) {
+				ctx->buffer_ptr = (void*) str;
+			}
+		}
+	}
+}
+
+
+static void build_attach(zetes_t* ctx, bool in_object) {
+	// moves the value on top of the stack into the container below it (and below its key)
+	if ( in_object ) {
+		const zetes_value_t* value = ctx->stack_ptr;
+		const zetes_value_t* key = value + 1;
+
+		if ( build_member(ctx, key->variant._string, key->length, hash_key(key->variant._string, key->length), value) ) {
+			ctx->stack_ptr += 2;
+		}
+	} else if ( build_append(ctx, ctx->stack_ptr) ) {
+		ctx->stack_ptr++;
+	}
+}
+
+
+static void build_event(zetes_t* ctx, zetes_event_t event, size_t base) {
+	// Assembles a value from events into the same shape parse_document() produces, base being the
+	// depth it starts at. An open array collects its elements in a scratch area at the top of the
+	// arena, and an object's pending key sits on the value stack above it until the member's value
+	// is complete.
+	zetes_reader_t* reader = &ctx->reader;
+	zetes_value_t* slot;
+
+	switch ( event ) {
+	case ZETES_EVENT_OBJECT_BEGIN:
+		build_begin_object(ctx);
+		return;
+
+	case ZETES_EVENT_ARRAY_BEGIN:
+		build_begin_array(ctx);
+		return;
+
+	case ZETES_EVENT_KEY:
+		build_key(ctx, &reader->value);
+		return;
+
+	case ZETES_EVENT_VALUE:
+		slot = stack_emplace(ctx);
+
+		if ( slot ) {
+			*slot = reader->value;
+		}
+
+		break;
+
+	case ZETES_EVENT_ARRAY_END:
+		build_end_array(ctx);
+		break;
+
+	case ZETES_EVENT_OBJECT_END:
+		build_end_object(ctx);
+		break;
+
+	default:
+		return;
+	}
+
+	if ( ok(ctx) ) {
+		if ( reader->depth > base ) {
+			build_attach(ctx, event_in_object(reader));
+		} else if ( base == 0 ) {
+			ctx->buffer_end = scratch_at(ctx, reader->saved_depth);
+		}
+	}
+}
+
+
+static bool is_token_char(char c) {
+	return is_digit(c) || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '-' || c == '+' || c == '.';
+}
+
+
+static bool scan_carry(zetes_reader_t* reader, const char* data, size_t length, size_t* used) {
+	// Looks for the end of the partial token held in the carry buffer. Returns true if it ends within
+	// data, setting used to the number of bytes that belong to it: up to and including a string's
+	// closing quote, or up to but excluding whatever ends a number or keyword.
+	size_t i;
+
+	if ( is_quote(reader->carry[0]) ) {
+		for (i = 0; i < length; i++) {
+			if ( reader->carry_escape ) {
+				reader->carry_escape = false;
+			} else if ( is_escape(data[i]) ) {
+				reader->carry_escape = true;
+			} else if ( is_quote(data[i]) ) {
+				*used = i + 1;
+				return true;
+			}
+		}
+	} else {
+		for (i = 0; i < length; i++) {
+			if ( !is_token_char(data[i]) ) {
+				*used = i;
+				return true;
+			}
+		}
+	}
+
+	*used = length;
+
+	return false;
+}
+
+
+static bool append_carry(zetes_t* ctx, const char* data, size_t length) {
+	zetes_reader_t* reader = &ctx->reader;
+	char* end = reader->carry + reader->carry_length;
+
+	// the carry buffer is always the latest allocation, so it can grow in place
+	ZETES_ASSERT((void*) end == ctx->buffer_ptr);
+
+	if ( length > (size_t) ((char*) ctx->buffer_end - end) ) {
+		// it has to stay in one piece, so it moves to a new block
+		if ( !grow_arena(ctx, 2 * (reader->carry_length + length)) ) {
+			set_error(ctx, ZETES_RESULT_OUT_OF_MEMORY);
+			return false;
+		}
+
+		memcpy(ctx->buffer_ptr, reader->carry, reader->carry_length);
+		reader->carry = (char*) ctx->buffer_ptr;
+		end = reader->carry + reader->carry_length;
+	}
+
+	if ( length > 0 ) {
+		memcpy(end, data, length);
+		reader->carry_length += length;
+		ctx->buffer_ptr = end + length;
+	}
+
+	return true;
+}
+
+
+static void save_carry(zetes_t* ctx, const char* token_i, const char* token_e) {
+	zetes_reader_t* reader = &ctx->reader;
+	size_t unused;
+
+	while ( token_i < token_e && is_whitespace(*token_i) ) {
+		token_i++;
+	}
+
+	reader->carry = (char*) ctx->buffer_ptr;
+	reader->carry_length = 0;
+	reader->carry_escape = false;
+
+	if ( token_i < token_e && append_carry(ctx, token_i, token_e - token_i) ) {
+		// only to pick up a trailing backslash, the token is known not to end here
+		scan_carry(reader, token_i + 1, token_e - token_i - 1, &unused);
+	}
+}
+
+
+zetes_result_t zetes_feed(zetes_t* ctx, const void* data, size_t length) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+	ZETES_ASSERT(data || length == 0);
+
+	zetes_reader_t* reader = &ctx->reader;
+	char* data_i = (char*) data;
+	char* data_e = data_i + length;
+	rstate_t rstate;
+
+	if ( !ok(ctx) ) {
+		return ctx->result;
+	}
+
+	if ( reader->state == EVENT_STATE_IDLE ) {
+		begin_events(ctx, NULL, NULL, NULL, NULL, false);
+	}
+
+	// an empty chunk marks the end of the input
+	init_rstate(&rstate, ctx, NULL, NULL, data_i, data_e, false);
+	rstate.partial = (length > 0);
+
+	if ( reader->carry_length > 0 ) {
+		size_t used;
+		bool complete = scan_carry(reader, data_i, length, &used);
+
+		if ( !append_carry(ctx, data_i, used) ) {
+			return ctx->result;
+		}
+
+		if ( !complete && length > 0 ) {
+			return ZETES_RESULT_NEED_MORE;
+		}
+
+		// the carried token is lexed in place from the arena, so its storage is released first
+		ctx->buffer_ptr = reader->carry;
+		rstate.buffer_i = reader->carry;
+		rstate.buffer_e = reader->carry + reader->carry_length;
+		rstate.next_i = data_i + used;
+		rstate.next_e = data_e;
+		reader->carry_length = 0;
+	}
+
+	while ( ok(ctx) && reader->state != EVENT_STATE_END ) {
+		zetes_event_t event;
+		char* token_i;
+		bool in_carry;
+
+		if ( rstate.next_i && rstate.buffer_i == rstate.buffer_e ) {
+			rstate.buffer_i = rstate.next_i;
+			rstate.buffer_e = rstate.next_e;
+			rstate.next_i = NULL;
+		}
+
+		token_i = rstate.buffer_i;
+		in_carry = (rstate.next_i != NULL);
+		event = read_event_token(&rstate);
+
+		if ( rstate.starved ) {
+			if ( in_carry ) {
+				// only happens when the carried token was followed by something that can't follow it
+				set_error(ctx, ZETES_RESULT_SYNTAX_ERROR);
+				return ctx->result;
+			}
+
+			save_carry(ctx, token_i, data_e);
+
+			return ok(ctx) ? ZETES_RESULT_NEED_MORE : ctx->result;
+		}
+
+		build_event(ctx, event, 0);
+	}
+
+	if ( ok(ctx) ) {
+		char c;
+
+		// only whitespace may follow the document, in this chunk or any later one
+		while ( is_whitespace(c = next_char(&rstate)) ) {
+		}
+
+		if ( c ) {
+			set_error(ctx, ZETES_RESULT_SYNTAX_ERROR);
+		}
+	}
+
+	return ctx->result;
+}
+
+
+static bool parse_member(rstate_t* state) {
+	// Reads a key and the separator after it. A literal value is added to the object straight away,
+	// returning true; otherwise the key is left on the value stack for the value to join later.
+	zetes_t* ctx = state->ctx;
+	zetes_value_t* slot;
+	const char* key;
+	size_t key_length;
+	uint32_t hash;
+
+	if ( state->token_type != TOKEN_TYPE_LITERAL || state->token_value.type != ZETES_TYPE_STRING ) {
+		set_error(ctx, ZETES_RESULT_SYNTAX_ERROR);
+		return false;
+	}
+
+	key = state->token_value.variant._string;
+	key_length = state->token_value.length;
+	hash = hash_key(key, key_length);
+
+	// in-situ keys point into the caller's buffer, which may not outlive the table
+	if ( ctx->intern_table && !state->insitu ) {
+		const char* interned = intern_key(ctx, key, key_length, hash, false);
+
+		// drop the freshly lexed copy if an earlier one was found
+		if ( interned != key && (char*) key + key_length + 1 == (char*) ctx->buffer_ptr ) {
+			ctx->buffer_ptr = (void*) key;
+		}
+
+		key = interned;
+	}
+
+	next_token(state);
+
+	if ( !expect_token(state, TOKEN_TYPE_KEY_VAL_SEPARATOR) ) {
+		return false;
+	}
+
+	next_token(state);
+
+	if ( state->token_type == TOKEN_TYPE_LITERAL ) {
+		return build_member(ctx, key, key_length, hash, &state->token_value);
+	}
+
+	slot = stack_emplace(ctx);
+
+	if ( !slot ) {
+		return false;
+	}
+
+	slot->type = ZETES_TYPE_STRING;
+	slot->length = (uint32_t) key_length;
+	slot->variant._string = key;
+
+	return false;
+}
+
+
+static void parse_document(rstate_t* state) {
+	// Parses without recursion. Open containers wait on the value stack, with the reader's nesting
+	// bitset recording which kind each one is, so C stack use doesn't grow with the document.
+	zetes_t* ctx = state->ctx;
+	zetes_reader_t* reader = &ctx->reader;
+	size_t depth = 0;
+	bool is_object = false;
+
+	bool member = false;
+
+	next_token(state);
+
+	while ( ok(ctx) ) {
+		bool attach = true;
+
+		// a member or value is due: open a container (and carry on into it, unless it is empty) or push
+		// a literal
+		if ( member ) {
+			member = false;
+
+			if ( !parse_member(state) ) {
+				continue;
+			}
+
+			attach = false;
+		} else if ( state->token_type == TOKEN_TYPE_OBJECT_OPEN ) {
+			build_begin_object(ctx);
+			next_token(state);
+
+			if ( !ok(ctx) || !push_nesting(ctx, depth, true) ) {
+				return;
+			}
+
+			if ( state->token_type != TOKEN_TYPE_OBJECT_CLOSE ) {
+				depth++;
+				is_object = true;
+				member = true;
+				continue;
+			}
+
+			build_end_object(ctx);
+		} else if ( state->token_type == TOKEN_TYPE_ARRAY_OPEN ) {
+			build_begin_array(ctx);
+			next_token(state);
+
+			if ( !ok(ctx) || !push_nesting(ctx, depth, false) ) {
+				return;
+			}
+
+			if ( state->token_type != TOKEN_TYPE_ARRAY_CLOSE ) {
+				depth++;
+				is_object = false;
+				continue;
+			}
+
+			build_end_array(ctx);
+		} else if ( !expect_token(state, TOKEN_TYPE_LITERAL) ) {
+			return;
+		} else if ( depth > 0 ) {
+			// only array elements get here as literal member values are set by parse_member(), so this
+			// one can go straight into the scratch area
+			if ( !build_append(ctx, &state->token_value) ) {
+				return;
+			}
+
+			attach = false;
+		} else {
+			zetes_value_t* slot = stack_emplace(ctx);
+
+			if ( slot ) {
+				*slot = state->token_value;
+			}
+		}
+
+		// the value on top of the stack is complete (or, for a literal member, already in place): add it
+		// to its container, closing any containers that end along with it, until the next value is due
+		while ( ok(ctx) ) {
+			if ( depth == 0 && state->multiple ) {
+				// the next document starts with the next token, so it is left unread
+				return;
+			}
+
+			next_token(state);
+
+			if ( depth == 0 ) {
+				expect_token(state, TOKEN_TYPE_END_OF_INPUT);
+				return;
+			}
+
+			if ( attach ) {
+				build_attach(ctx, is_object);
+
+				if ( !ok(ctx) ) {
+					return;
+				}
+			}
+
+			attach = true;
+
+			if ( state->token_type == TOKEN_TYPE_COMMA ) {
+				next_token(state);
+				member = is_object;
+				break;
+			} else if ( state->token_type == (is_object ? TOKEN_TYPE_OBJECT_CLOSE : TOKEN_TYPE_ARRAY_CLOSE) ) {
+				if ( is_object ) {
+					build_end_object(ctx);
+				} else {
+					build_end_array(ctx);
+				}
+
+				depth--;
+				is_object = depth > 0 && is_object_nesting(reader, depth);
+			} else {
+				set_error(ctx, ZETES_RESULT_SYNTAX_ERROR);
+			}
+		}
+	}
+}
+
+
+static const char* skip_string(const char* i, const char* e) {
+	// i is just past the opening quote, returns just past the closing one or NULL if there isn't one
+	for (;;) {
+#if ZETES_SIMD
+		i = scan_plain(i, e);
+#endif
+
+		while ( i < e && !is_quote(*i) && !is_escape(*i) ) {
+			i++;
+		}
+
+		if ( i == e ) {
+			return NULL;
+		}
+
+		if ( is_quote(*i++) ) {
+			return i;
+		}
+
+		if ( i == e ) {
+			return NULL;
+		}
+
+		i++;
+	}
+}
+
+
+static const char* skip_container(const char* i, const char* e) {
+	// i is just past an opening bracket, returns just past its matching close or NULL if it isn't
+	// closed. Only the balance of brackets is checked; the contents are validated when resolved.
+	size_t depth = 1;
+	bool in_string = false;
+
+	while ( i < e ) {
+		char c;
+
+#if defined(ZETES_SIMD_SSE2)
+		// a block without backslashes can be settled from masks of its quotes and brackets, setting
+		// bit 5 folds '[' and ']' onto '{' and '}'
+		if ( e - i >= 16 ) {
+			__m128i v = _mm_loadu_si128((const __m128i*) i);
+
+			if ( !_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))) ) {
+				__m128i f = _mm_or_si128(v, _mm_set1_epi8(0x20));
+				unsigned quotes = (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')));
+				unsigned opens = (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(f, _mm_set1_epi8('{')));
+				unsigned marks = quotes | opens | (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(f, _mm_set1_epi8('}')));
+
+				for (; marks; marks &= marks - 1) {
+					unsigned bit = marks & (~marks + 1);
+
+					if ( quotes & bit ) {
+						in_string = !in_string;
+					} else if ( in_string ) {
+						continue;
+					} else if ( opens & bit ) {
+						depth++;
+					} else if ( --depth == 0 ) {
+						while ( !(bit & 1) ) {
+							bit >>= 1;
+							i++;
+						}
+
+						return i + 1;
+					}
+				}
+
+				i += 16;
+				continue;
+			}
+		}
+#endif
+
+		c = *i++;
+
+		if ( in_string ) {
+			if ( is_quote(c) ) {
+				in_string = false;
+			} else if ( is_escape(c) ) {
+				if ( i == e ) {
+					return NULL;
+				}
+
+				i++;
+			}
+		} else if ( is_quote(c) ) {
+			in_string = true;
+		} else if ( is_object_open(c) || is_array_open(c) ) {
+			depth++;
+		} else if ( (is_object_close(c) || is_array_close(c)) && --depth == 0 ) {
+			return i;
+		}
+	}
+
+	return NULL;
+}
+
+
+static bool validate_lazy(zetes_t* ctx, const char* i, const char* e) {
+	// checks deferred source text as the reader would, failing with the error it would give; like the
+	// reader, that doesn't insist on valid UTF-8
+	uint8_t nesting[(ZETES_MAX_DEPTH + 7) / 8];
+	vstate_t vs;
+
+	init_vstate(&vs, NULL, NULL, (char*) i, 0);
+	vs.e = e;
+	vs.check_utf8 = false;
+
+	if ( validate_document(&vs, ctx->reader.nesting_ext ? ctx->reader.nesting_ext : nesting, ctx->reader.max_depth,
+			NULL) != ZETES_RESULT_OK ) {
+		set_error(ctx, vs.result);
+		return false;
+	}
+
+	return true;
+}
+
+
+static bool lazy_value(rstate_t* state, zetes_value_t* value) {
+	// converts the current token into a value, deferring any container it opens
+	zetes_t* ctx = state->ctx;
+
+	if ( state->token_type == TOKEN_TYPE_ARRAY_OPEN || state->token_type == TOKEN_TYPE_OBJECT_OPEN ) {
+		const char* open = state->buffer_i - 1;
+		const char* close = skip_container(state->buffer_i, state->buffer_e);
+
+		if ( !close ) {
+			// unclosed, but whatever goes wrong first is the error the reader would give
+			if ( validate_lazy(ctx, open, state->buffer_e) ) {
+				set_error(ctx, ZETES_RESULT_UNEXPECTED_END_OF_INPUT);
+			}
+
+			return false;
+		}
+
+		state->buffer_i = (char*) close;
+
+		if ( state->token_type == TOKEN_TYPE_ARRAY_OPEN ) {
+			zetes_array_t* array = new_array(ctx);
+
+			if ( !array ) {
+				return false;
+			}
+
+			array->lazy = open;
+			array->lazy_end = close;
+			value->type = ZETES_TYPE_ARRAY;
+			value->variant._array = array;
+		} else {
+			zetes_object_t* object = new_object(ctx);
+
+			if ( !object ) {
+				return false;
+			}
+
+			object->lazy = open;
+			object->lazy_end = close;
+			value->type = ZETES_TYPE_OBJECT;
+			value->variant._object = object;
+		}
+
+		return true;
+	}
+
+	if ( expect_token(state, TOKEN_TYPE_LITERAL) ) {
+		*value = state->token_value;
+		return true;
+	}
+
+	return false;
+}
+
+
+static void resolve_array(zetes_t* ctx, zetes_array_t* array) {
+	// elements gather in a scratch area as parse_document() does, so the values end up contiguous
+	size_t saved_depth = scratch_depth(ctx);
+	size_t top_depth = (size_t) ((char*) ctx->buffer_top - (char*) align_down(ctx->buffer_end));
+	zetes_value_t value;
+	rstate_t state;
+
+	init_rstate(&state, ctx, NULL, NULL, (char*) array->lazy + 1, (char*) array->lazy_end, false);
+	ctx->buffer_end = scratch_at(ctx, top_depth);
+	next_token(&state);
+
+	if ( state.token_type != TOKEN_TYPE_ARRAY_CLOSE ) {
+		while ( lazy_value(&state, &value) && build_append(ctx, &value) ) {
+			next_token(&state);
+
+			if ( state.token_type == TOKEN_TYPE_COMMA ) {
+				next_token(&state);
+			} else {
+				expect_token(&state, TOKEN_TYPE_ARRAY_CLOSE);
+				break;
+			}
+		}
+	}
+
+	if ( ok(ctx) ) {
+		zetes_value_t* scratch = (zetes_value_t*) ctx->buffer_end;
+		size_t count = (zetes_value_t*) scratch_at(ctx, top_depth) - scratch;
+
+		ctx->buffer_end = scratch_at(ctx, saved_depth);
+
+		if ( count > 0 ) {
+			move_scratch_to_array(ctx, array, scratch, count);
+		}
+
+		array->lazy = NULL;
+	}
+
+	ctx->buffer_end = scratch_at(ctx, saved_depth);
+}
+
+
+static void resolve_object(zetes_t* ctx, zetes_object_t* object) {
+	// members gather in a scratch area too
+	size_t saved_depth = scratch_depth(ctx);
+	size_t top_depth = (size_t) ((char*) ctx->buffer_top - (char*) align_down(ctx->buffer_end));
+	zetes_value_t value;
+	rstate_t state;
+
+	init_rstate(&state, ctx, NULL, NULL, (char*) object->lazy + 1, (char*) object->lazy_end, false);
+	ctx->buffer_end = scratch_at(ctx, top_depth);
+	next_token(&state);
+
+	if ( state.token_type != TOKEN_TYPE_OBJECT_CLOSE ) {
+		while ( ok(ctx) ) {
+			const char* key;
+			size_t key_length;
+			uint32_t hash;
+
+			if ( state.token_type != TOKEN_TYPE_LITERAL || state.token_value.type != ZETES_TYPE_STRING ) {
+				set_error(ctx, ZETES_RESULT_SYNTAX_ERROR);
+				break;
+			}
+
+			key = state.token_value.variant._string;
+			key_length = state.token_value.length;
+			hash = hash_key(key, key_length);
+
+			if ( ctx->intern_table ) {
+				const char* interned = intern_key(ctx, key, key_length, hash, false);
+
+				// drop the freshly lexed copy if an earlier one was found
+				if ( interned != key && (char*) key + key_length + 1 == (char*) ctx->buffer_ptr ) {
+					ctx->buffer_ptr = (void*) key;
+				}
+
+				key = interned;
+			}
+
+			next_token(&state);
+
+			if ( !expect_token(&state, TOKEN_TYPE_KEY_VAL_SEPARATOR) ) {
+				break;
+			}
+
+			next_token(&state);
+
+			if ( !lazy_value(&state, &value) || !build_member(ctx, key, key_length, hash, &value) ) {
+				break;
+			}
+
+			next_token(&state);
+
+			if ( state.token_type == TOKEN_TYPE_COMMA ) {
+				next_token(&state);
+			} else {
+				expect_token(&state, TOKEN_TYPE_OBJECT_CLOSE);
+				break;
+			}
+		}
+	}
+
+	if ( ok(ctx) ) {
+		zetes_object_member_t* scratch = (zetes_object_member_t*) ctx->buffer_end;
+		size_t count = (zetes_object_member_t*) scratch_at(ctx, top_depth) - scratch;
+
+		ctx->buffer_end = scratch_at(ctx, saved_depth);
+
+		if ( count > 0 ) {
+			move_scratch_to_object(ctx, object, scratch, count);
+		}
+
+		object->lazy = NULL;
+	}
+
+	ctx->buffer_end = scratch_at(ctx, saved_depth);
+}
+
+
+static bool resolve(zetes_t* ctx, const zetes_value_t* value) {
+	// materialises one level of a container from zetes_read_lazy(), nested containers stay deferred
+	if ( value->type == ZETES_TYPE_ARRAY ) {
+		if ( value->variant._array->lazy ) {
+			resolve_array(ctx, value->variant._array);
+		}
+	} else if ( value->variant._object->lazy ) {
+		resolve_object(ctx, value->variant._object);
+	}
+
+	return ok(ctx);
+}
+
+
+zetes_result_t zetes_read_lazy(zetes_t* ctx, const char* buffer, size_t buffer_size) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+	ZETES_ASSERT(buffer);
+
+	if ( ok(ctx) ) {
+		rstate_t rstate;
+		zetes_value_t value;
+
+		// Containers are only checked for balanced brackets as they are deferred. The rest of a
+		// container's syntax is checked one level at a time as it's resolved, or all at once if it's
+		// written out unresolved, so an error within one surfaces then rather than here. A container
+		// written unresolved is copied from its source text, numbers and escapes included, so 1e400 is
+		// written as it stands rather than as null, and \u00e9 rather than \u00E9.
+		//
+		// the buffer is only ever read from and must outlive the values, insitu is false
+		init_rstate(&rstate, ctx, NULL, NULL, (char*) buffer, (char*) buffer + buffer_size, false);
+		next_token(&rstate);
+
+		if ( ok(ctx) && lazy_value(&rstate, &value) ) {
+			next_token(&rstate);
+
+			if ( expect_token(&rstate, TOKEN_TYPE_END_OF_INPUT) ) {
+				zetes_value_t* slot = stack_emplace(ctx);
+
+				if ( slot ) {
+					*slot = value;
+				}
+			}
+		}
+	}
+
+	return ctx->result;
+}
+
+
+static bool write_lazy(wstate_t* state, const char* i, const char* e) {
+	// Copies an unresolved container's source text, less any whitespace between tokens. The text is
+	// validated first, as the reader would have, so no two tokens run together once it's gone, and
+	// each string is closed with well formed escapes. Those are copied as they are, and the rest of a
+	// string is escaped as write_string() would, which checks its UTF-8 as it would be for a resolved
+	// container.
+	if ( !validate_lazy(state->ctx, i, e) ) {
+		return false;
+	}
+
+	while ( i < e ) {
+		const char* run = i;
+
+		while ( i < e && !is_whitespace(*i) && !is_quote(*i) ) {
+			i++;
+		}
+
+		if ( i > run && !write_run(state, run, i - run) ) {
+			return false;
+		}
+
+		if ( i < e && is_quote(*i) ) {
+			const char* str_e = skip_string(i + 1, e) - 1;
+
+			if ( !write_all(state, SYMBOL_STRING_DELIM, sizeof(SYMBOL_STRING_DELIM)) ) {
+				return false;
+			}
+
+			for (i++; i < str_e;) {
+				run = i;
+
+				while ( i < str_e && !is_escape(*i) ) {
+					i++;
+				}
+
+				if ( !write_string_text(state, run, i - run) ) {
+					return false;
+				}
+
+				if ( i < str_e ) {
+					size_t n = (i[1] == 'u') ? 6 : 2;
+
+					if ( !write_run(state, i, n) ) {
+						return false;
+					}
+
+					i += n;
+				}
+			}
+
+			if ( !write_all(state, SYMBOL_STRING_DELIM, sizeof(SYMBOL_STRING_DELIM)) ) {
+				return false;
+			}
+
+			i = str_e + 1;
+		}
+
+		while ( i < e && is_whitespace(*i) ) {
+			i++;
+		}
+	}
+
+	return true;
+}
+
+
+static bool decode_path_token(const char* i, const char* e, char* out, ptoken_t* token) {
+	// Decodes one reference token of a JSON pointer (RFC 6901), i being just past its '/'. A token
+	// with escapes is unescaped into out, which must have room for e - i bytes. Returns false if an
+	// escape is malformed.
+	const char* digits = i;
+
+	token->key = i;
+	token->key_length = e - i;
+	token->index = SIZE_MAX;
+
+	if ( memchr(i, '~', e - i) ) {
+		char* out_i = out;
+
+		while ( i < e ) {
+			char c = *i++;
+
+			if ( c == '~' ) {
+				if ( i == e || (*i != '0' && *i != '1') ) {
+					return false;
+				}
+
+				c = (*i++ == '0') ? '~' : '/';
+			}
+
+			*out_i++ = c;
+		}
+
+		token->key = out;
+		token->key_length = out_i - out;
+	}
+
+	token->hash = hash_key(token->key, token->key_length);
+
+	// array indices have no leading zeros, and "-" (one past the end) never refers to anything here
+	if ( digits < e && (*digits != '0' || e - digits == 1) ) {
+		size_t index = 0;
+
+		while ( digits < e && is_digit(*digits) && index <= (SIZE_MAX - 10) / 10 ) {
+			index = index * 10 + (size_t) (*digits++ - '0');
+		}
+
+		if ( digits == e ) {
+			token->index = index;
+		}
+	}
+
+	return true;
+}
+
+
+static const zetes_value_t* path_step(zetes_t* ctx, const zetes_value_t* value, const ptoken_t* token, zetes_result_t* miss) {
+	// returns the member or element token refers to, or NULL with the reason in miss
+	const zetes_value_t* next = NULL;
+
+	if ( value->type == ZETES_TYPE_OBJECT ) {
+		if ( resolve(ctx, value) ) {
+			zetes_object_member_t* member = find_member(value->variant._object, token->key, token->key_length, token->hash);
+
+			next = member ? &member->value : NULL;
+			*miss = ZETES_RESULT_KEY_NOT_FOUND;
+		}
+	} else if ( value->type == ZETES_TYPE_ARRAY ) {
+		if ( resolve(ctx, value) ) {
+			next = (token->index != SIZE_MAX) ? array_at(value->variant._array, token->index) : NULL;
+			*miss = ZETES_RESULT_INDEX_OUT_OF_BOUNDS;
+		}
+	} else {
+		*miss = ZETES_RESULT_TYPE_MISMATCH;
+	}
+
+	if ( !ok(ctx) ) {
+		*miss = ctx->result;
+	}
+
+	return next;
+}
+
+
+void zetes_get_path(zetes_t* ctx, const char* path) {
+	ZETES_ASSERT(path);
+
+	zetes_get_path_n(ctx, path, strlen(path));
+}
+
+
+void zetes_get_path_n(zetes_t* ctx, const char* path, size_t path_length) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+	ZETES_ASSERT(path);
+
+	if ( stack_validate(ctx, 1) ) {
+		const zetes_value_t* value = ctx->stack_ptr;
+		const char* path_i = path;
+		const char* path_e = path + path_length;
+		zetes_result_t miss = ZETES_RESULT_OK;
+
+		while ( value && path_i < path_e ) {
+			const char* token_e;
+			char* out;
+			ptoken_t token;
+
+			if ( *path_i++ != '/' ) {
+				set_error(ctx, ZETES_RESULT_INVALID_PATH);
+				return;
+			}
+
+			token_e = (const char*) memchr(path_i, '/', path_e - path_i);
+			token_e = token_e ? token_e : path_e;
+
+			// unescaped keys are decoded into free space, so a deferred container has to be resolved
+			// first; nothing else is allocated until the lookup is done
+			if ( (value->type == ZETES_TYPE_ARRAY || value->type == ZETES_TYPE_OBJECT) && !resolve(ctx, value) ) {
+				return;
+			}
+
+			if ( !reserve(ctx, token_e - path_i) ) {
+				set_error(ctx, ZETES_RESULT_OUT_OF_MEMORY);
+				return;
+			}
+
+			out = (char*) ctx->buffer_ptr;
+
+			if ( !decode_path_token(path_i, token_e, out, &token) ) {
+				set_error(ctx, ZETES_RESULT_INVALID_PATH);
+				return;
+			}
+
+			value = path_step(ctx, value, &token, &miss);
+			path_i = token_e;
+		}
+
+		if ( value ) {
+			zetes_value_t* slot = stack_emplace(ctx);
+
+			if ( slot ) {
+				*slot = *value;
+			}
+		} else {
+			set_error(ctx, miss);
+		}
+	}
+}
+
+
+static xpath_t* compile_paths(zetes_t* ctx, const char* const* paths, size_t path_count, size_t* max_tokens,
+		size_t** indices, size_t* size) {
+	// Decodes every path into a scratch area at the top of the arena, which the caller releases. That
+	// could move if a block is chained on while extracting, so with an allocator the paths get a
+	// separate allocation instead, for the caller to free.
+	void* saved_end = ctx->buffer_end;
+	size_t token_count = 0;
+	size_t text_size = 0;
+	char* scratch;
+	xpath_t* xpaths;
+	ptoken_t* tokens;
+	char* text;
+	size_t i;
+
+	*max_tokens = 0;
+
+	for (i = 0; i < path_count; i++) {
+		const char* path = paths[i];
+		size_t n = 0;
+
+		if ( *path && *path != '/' ) {
+			set_error(ctx, ZETES_RESULT_INVALID_PATH);
+			return NULL;
+		}
+
+		for (; *path; path++) {
+			n += (*path == '/');
+			text_size++;
+		}
+
+		token_count += n;
+		*max_tokens = (n > *max_tokens) ? n : *max_tokens;
+	}
+
+	*size = path_count * sizeof(xpath_t) + token_count * sizeof(ptoken_t) + *max_tokens * sizeof(size_t) + text_size;
+
+	if ( ctx->alloc_func ) {
+		scratch = (char*) ctx->alloc_func(*size + 1, ctx->alloc_user_data);
+
+		if ( !scratch ) {
+			set_error(ctx, ZETES_RESULT_OUT_OF_MEMORY);
+			return NULL;
+		}
+	} else {
+		if ( (size_t) ((char*) ctx->buffer_end - (char*) ctx->buffer_ptr) < *size + ZETES_ALIGN ) {
+			set_error(ctx, ZETES_RESULT_OUT_OF_MEMORY);
+			return NULL;
+		}
+
+		scratch = (char*) align_down((char*) ctx->buffer_end - *size);
+		ctx->buffer_end = scratch;
+
+#if ZETES_STATS
+		count_arena(ctx, 0);
+#endif
+	}
+
+	xpaths = (xpath_t*) scratch;
+	tokens = (ptoken_t*) (xpaths + path_count);
+	*indices = (size_t*) (tokens + token_count);
+	text = (char*) (*indices + *max_tokens);
+
+	for (i = 0; i < path_count; i++) {
+		const char* path_i = paths[i];
+		const char* path_e = path_i + strlen(path_i);
+		xpath_t* xpath = &xpaths[i];
+
+		xpath->path = paths[i];
+		xpath->path_length = path_e - path_i;
+		xpath->tokens = tokens;
+		xpath->count = 0;
+		xpath->matched = 0;
+
+		while ( path_i++ < path_e ) {
+			const char* token_e = (const char*) memchr(path_i, '/', path_e - path_i);
+
+			token_e = token_e ? token_e : path_e;
+
+			if ( !decode_path_token(path_i, token_e, text, &xpath->tokens[xpath->count]) ) {
+				// the caller only releases the paths it gets back
+				if ( ctx->alloc_func ) {
+					if ( ctx->free_func ) {
+						ctx->free_func(scratch, *size + 1, ctx->alloc_user_data);
+					}
+				} else {
+					ctx->buffer_end = saved_end;
+				}
+
+				set_error(ctx, ZETES_RESULT_INVALID_PATH);
+				return NULL;
+			}
+
+			text += token_e - path_i;
+			xpath->count++;
+			path_i = token_e;
+		}
+
+		tokens += xpath->count;
+	}
+
+	return xpaths;
+}
+
+
+static void match_paths(xpath_t* xpaths, size_t path_count, size_t level, const char* key, size_t key_length,
+		size_t index) {
+	// the location has moved on to a new key or index at level, paths that matched up to it check
+	// their token for that level again
+	size_t i;
+
+	for (i = 0; i < path_count; i++) {
+		xpath_t* xpath = &xpaths[i];
+
+		if ( xpath->matched >= level ) {
+			xpath->matched = level;
+
+			if ( level < xpath->count ) {
+				const ptoken_t* token = &xpath->tokens[level];
+
+				if ( key ? (token->key_length == key_length && memcmp(token->key, key, key_length) == 0) : token->index == index ) {
+					xpath->matched++;
+				}
+			}
+		}
+	}
+}
+
+
+static void extract_put(zetes_t* ctx, zetes_object_t* result, const xpath_t* xpath, const zetes_value_t* value) {
+	uint32_t hash = hash_key(xpath->path, xpath->path_length);
+	zetes_object_member_t* member = find_member(result, xpath->path, xpath->path_length, hash);
+
+	if ( !member ) {
+		const char* key = intern_key(ctx, xpath->path, xpath->path_length, hash, true);
+		zetes_object_element_t* element = key ? (zetes_object_element_t*) alloc(ctx, sizeof(zetes_object_element_t)) : NULL;
+
+		if ( !element ) {
+			return;
+		}
+
+		member = &element->member;
+		member->key = key;
+		member->key_length = (uint32_t) xpath->path_length;
+		member->key_hash = hash;
+		insert_element(ctx, result, element);
+	}
+
+	member->value = *value;
+}
+
+
+static void extract_value(zetes_t* ctx, zetes_event_t event, zetes_object_t* result, xpath_t* xpaths, size_t path_count,
+		size_t length) {
+	// Builds the value the current event starts, at a location of the given length, and adds it to
+	// the result for every path that ends there. Paths that continue below it are looked up within it.
+	zetes_reader_t* reader = &ctx->reader;
+	size_t i;
+
+	if ( event == ZETES_EVENT_VALUE ) {
+		zetes_push_event_value(ctx);
+	} else {
+		build_event(ctx, event, length);
+
+		while ( ok(ctx) && reader->depth > length ) {
+			build_event(ctx, zetes_next_event(ctx), length);
+
+			// anything lexed for the event now belongs to the value
+			reader->transient = NULL;
+		}
+	}
+
+	for (i = 0; i < path_count && ok(ctx); i++) {
+		const xpath_t* xpath = &xpaths[i];
+
+		if ( xpath->matched == length ) {
+			const zetes_value_t* value = ctx->stack_ptr;
+			zetes_result_t miss;
+			size_t n;
+
+			for (n = length; value && n < xpath->count; n++) {
+				value = path_step(ctx, value, &xpath->tokens[n], &miss);
+			}
+
+			if ( value ) {
+				extract_put(ctx, result, xpath, value);
+			}
+		}
+	}
+
+	if ( ok(ctx) ) {
+		ctx->stack_ptr++;
+	}
+}
+
+
+static void extract_skip(zetes_t* ctx) {
+	// Skips the container just begun. Reading from a buffer, the text can be stepped over without
+	// lexing it, checking only that brackets balance.
+	zetes_reader_t* reader = &ctx->reader;
+
+	if ( !reader->read_func ) {
+		const char* close = skip_container(reader->buffer_i, reader->buffer_e);
+
+		if ( !close ) {
+			set_error(ctx, ZETES_RESULT_UNEXPECTED_END_OF_INPUT);
+		} else {
+			reader->buffer_i = (char*) close;
+			reader->event = event_pop_nesting(reader);
+		}
+	} else {
+		zetes_skip_event(ctx);
+	}
+}
+
+
+void zetes_extract(zetes_t* ctx, const char* const* paths, size_t path_count) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+	ZETES_ASSERT(ctx->reader.state == EVENT_STATE_VALUE && ctx->reader.depth == 0);
+	ZETES_ASSERT(paths || path_count == 0);
+
+	// Reads the document from the event reader, pushing an object keyed by each path found. Subtrees
+	// no path leads into are skipped without being built.
+	zetes_reader_t* reader = &ctx->reader;
+	void* saved_end = ctx->buffer_end;
+	xpath_t* xpaths;
+	size_t* indices;
+	size_t max_tokens;
+	size_t size;
+	bool after_key = false;
+
+	// indices holds the next index at each level of the location that is inside an array
+	if ( !ok(ctx) || !(xpaths = compile_paths(ctx, paths, path_count, &max_tokens, &indices, &size)) ) {
+		return;
+	}
+
+	zetes_push_new_object(ctx);
+
+	while ( ok(ctx) ) {
+		zetes_event_t event = zetes_next_event(ctx);
+		size_t length;
+		bool found = false;
+		bool inside = false;
+		size_t i;
+
+		if ( event == ZETES_EVENT_KEY ) {
+			size_t key_length;
+			const char* key = zetes_event_string_n(ctx, &key_length);
+
+			if ( reader->depth <= max_tokens ) {
+				match_paths(xpaths, path_count, reader->depth - 1, key, key_length, 0);
+			}
+
+			after_key = true;
+			continue;
+		} else if ( event == ZETES_EVENT_VALUE ) {
+			length = reader->depth;
+		} else if ( event == ZETES_EVENT_OBJECT_BEGIN || event == ZETES_EVENT_ARRAY_BEGIN ) {
+			length = reader->depth - 1;
+		} else if ( event == ZETES_EVENT_OBJECT_END || event == ZETES_EVENT_ARRAY_END ) {
+			continue;
+		} else {
+			break;
+		}
+
+		// the value is an array element unless a key came just before it
+		if ( length > 0 && length <= max_tokens && !after_key ) {
+			match_paths(xpaths, path_count, length - 1, NULL, 0, indices[length - 1]++);
+		}
+
+		after_key = false;
+
+		if ( event == ZETES_EVENT_ARRAY_BEGIN && length < max_tokens ) {
+			indices[length] = 0;
+		}
+
+		for (i = 0; i < path_count; i++) {
+			if ( xpaths[i].matched == length ) {
+				found = found || xpaths[i].count == length;
+				inside = inside || xpaths[i].count > length;
+			}
+		}
+
+		if ( found ) {
+			extract_value(ctx, event, ctx->stack_ptr->variant._object, xpaths, path_count, length);
+		} else if ( !inside && event != ZETES_EVENT_VALUE ) {
+			extract_skip(ctx);
+		}
+	}
+
+	if ( ctx->alloc_func ) {
+		if ( ctx->free_func ) {
+			ctx->free_func(xpaths, size + 1, ctx->alloc_user_data);
+		}
+	} else {
+		ctx->buffer_end = saved_end;
+	}
+}
+
+
+// CBOR (RFC 8949) encoding of the same tree. Each item starts with a byte holding its major type in
+// the top three bits and, in the low five, either its argument (an integer, a length or a count) or
+// how many big-endian bytes of argument follow.
+
+#define CBOR_UNSIGNED		0
+#define CBOR_NEGATIVE		1
+#define CBOR_TEXT			3
+#define CBOR_ARRAY			4
+#define CBOR_MAP			5
+#define CBOR_TAG			6
+#define CBOR_SIMPLE			7
+
+#define CBOR_FALSE			0xF4
+#define CBOR_TRUE			0xF5
+#define CBOR_NULL			0xF6
+#define CBOR_UNDEFINED		0xF7
+#define CBOR_HALF			0xF9
+#define CBOR_FLOAT			0xFA
+#define CBOR_DOUBLE			0xFB
+#define CBOR_BREAK			0xFF
+
+// low bits of an array or map that is ended by CBOR_BREAK rather than preceded by its count
+#define CBOR_INDEFINITE		31
+
+
+static bool write_cbor_fixed(wstate_t* state, uint8_t initial, uint64_t argument, size_t size) {
+	char buffer[9];
+	size_t i;
+
+	buffer[0] = (char) initial;
+
+	for (i = size; i > 0; i--) {
+		buffer[i] = (char) (uint8_t) argument;
+		argument >>= 8;
+	}
+
+	return write_all(state, buffer, size + 1);
+}
+
+
+static bool write_cbor_head(wstate_t* state, int major, uint64_t argument) {
+	uint8_t initial = (uint8_t) (major << 5);
+
+	if ( argument < 24 ) {
+		return write_cbor_fixed(state, initial | (uint8_t) argument, 0, 0);
+	} else if ( argument <= 0xFF ) {
+		return write_cbor_fixed(state, initial | 24, argument, 1);
+	} else if ( argument <= 0xFFFF ) {
+		return write_cbor_fixed(state, initial | 25, argument, 2);
+	} else if ( argument <= 0xFFFFFFFF ) {
+		return write_cbor_fixed(state, initial | 26, argument, 4);
+	} else {
+		return write_cbor_fixed(state, initial | 27, argument, 8);
+	}
+}
+
+
+static bool write_cbor_int(wstate_t* state, int64_t value) {
+	// a negative integer is stored as -1 - n, so every int64_t has an encoding
+	if ( value < 0 ) {
+		return write_cbor_head(state, CBOR_NEGATIVE, (uint64_t) -(value + 1));
+	}
+
+	return write_cbor_head(state, CBOR_UNSIGNED, (uint64_t) value);
+}
+
+
+static bool write_cbor_number(wstate_t* state, zetes_number_t value) {
+	// always full width, so a number reads back as a number and unchanged
+	if ( (zetes_number_t) 0.5 == 0 ) {
+		// ZETES_NUMBER_TYPE is an integer type
+		return write_cbor_int(state, (int64_t) value);
+	} else if ( sizeof(zetes_number_t) <= sizeof(float) ) {
+		float f = (float) value;
+		uint32_t bits;
+
+		memcpy(&bits, &f, sizeof(bits));
+		return write_cbor_fixed(state, CBOR_FLOAT, bits, 4);
+	} else {
+		double d = (double) value;
+		uint64_t bits;
+
+		memcpy(&bits, &d, sizeof(bits));
+		return write_cbor_fixed(state, CBOR_DOUBLE, bits, 8);
+	}
+}
+
+
+static bool write_cbor_string(wstate_t* state, const char* value, size_t length) {
+	return write_cbor_head(state, CBOR_TEXT, length) && write_all(state, value, length);
+}
+
+
+static bool write_cbor_scalar(wstate_t* state, const zetes_value_t* value) {
+	switch(value->type) {
+	case ZETES_TYPE_NULL:
+		return write_cbor_fixed(state, CBOR_NULL, 0, 0);
+
+	case ZETES_TYPE_BOOL:
+		return write_cbor_fixed(state, value->variant._bool ? CBOR_TRUE : CBOR_FALSE, 0, 0);
+
+	case ZETES_TYPE_NUMBER:
+		return write_cbor_number(state, value->variant._number);
+
+	case ZETES_TYPE_INTEGER:
+		return write_cbor_int(state, (int64_t) value->variant._int);
+
+	case ZETES_TYPE_STRING:
+		return write_cbor_string(state, value->variant._string, value->length);
+
+	default:
+		set_error(state->ctx, ZETES_RESULT_INVALID_STACK);
+		return false;
+	}
+}
+
+
+static bool write_cbor_items(wstate_t* state, const zetes_value_t* value, size_t base) {
+	// As write_value(), except that a container from zetes_read_lazy() must be resolved before its
+	// count can be written, which allocates. So the frames are kept in a scratch area, base being the
+	// depth it starts at, and the top one is always found afresh as the arena may have grown.
+	zetes_t* ctx = state->ctx;
+
+	for (;;) {
+		const zetes_array_t* array;
+		const zetes_object_t* object;
+		wframe_t* frame;
+
+		// write the value, or open a container and descend into its first value
+		switch(value->type) {
+		case ZETES_TYPE_ARRAY:
+			if ( !resolve(ctx, value) ) {
+				return false;
+			}
+
+			array = value->variant._array;
+
+			if ( !write_cbor_head(state, CBOR_ARRAY, array->size) ) {
+				return false;
+			}
+
+			if ( array->size > 0 ) {
+				frame = (wframe_t*) push_scratch(ctx, sizeof(wframe_t));
+
+				if ( !frame ) {
+					return false;
+				}
+
+				frame_begin(frame, array->count > 0 ? array : NULL, array->first, false);
+				value = array->count > 0 ? &array->values[0] : &array->first->value;
+				continue;
+			}
+
+			break;
+
+		case ZETES_TYPE_OBJECT:
+			if ( !resolve(ctx, value) ) {
+				return false;
+			}
+
+			object = value->variant._object;
+
+			if ( !write_cbor_head(state, CBOR_MAP, object->size) ) {
+				return false;
+			}
+
+			if ( object->size > 0 ) {
+				const zetes_object_member_t* member;
+
+				frame = (wframe_t*) push_scratch(ctx, sizeof(wframe_t));
+
+				if ( !frame ) {
+					return false;
+				}
+
+				frame_begin(frame, object->count > 0 ? object : NULL, object->first, true);
+				member = object->count > 0 ? &object->members[0] : &object->first->member;
+
+				if ( !write_cbor_string(state, member->key, member->key_length) ) {
+					return false;
+				}
+
+				value = &member->value;
+				continue;
+			}
+
+			break;
+
+		default:
+			if ( !write_cbor_scalar(state, value) ) {
+				return false;
+			}
+
+			break;
+		}
+
+		// the value is complete, move on to the next one; counts were written up front so nothing closes
+		for (;;) {
+			if ( scratch_depth(ctx) == base ) {
+				return true;
+			}
+
+			frame = (wframe_t*) ctx->buffer_end;
+
+			if ( frame_is_object(frame) ) {
+				const zetes_object_member_t* member = next_frame_member(frame);
+
+				if ( member ) {
+					if ( !write_cbor_string(state, member->key, member->key_length) ) {
+						return false;
+					}
+
+					value = &member->value;
+					break;
+				}
+			} else {
+				value = next_frame_value(frame);
+
+				if ( value ) {
+					break;
+				}
+			}
+
+			ctx->buffer_end = frame + 1;
+		}
+	}
+}
+
+
+static bool write_cbor_value(wstate_t* state, const zetes_value_t* value) {
+	zetes_t* ctx = state->ctx;
+	size_t saved_depth = scratch_depth(ctx);
+	size_t base = (size_t) ((char*) ctx->buffer_top - (char*) align_down(ctx->buffer_end));
+	bool result;
+
+	ctx->buffer_end = scratch_at(ctx, base);
+	result = write_cbor_items(state, value, base);
+	ctx->buffer_end = scratch_at(ctx, saved_depth);
+
+	return result;
+}
+
+
+zetes_result_t zetes_write_cbor(zetes_t* ctx, zetes_write_func_t write_func, void* user_data) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+	ZETES_ASSERT(write_func);
+
+	if ( ok(ctx) && stack_validate(ctx, 1) ) {
+		wstate_t state;
+
+		init_wstate(&state, ctx, write_func, user_data);
+
+		// the arena may be allocated from while writing, so unlike zetes_write() free space is no use
+		if ( ctx->write_buffer ) {
+			state.buffer_b = ctx->write_buffer;
+			state.buffer_e = state.buffer_b + ctx->write_buffer_size;
+		} else {
+			state.buffer_b = ctx->temp;
+			state.buffer_e = state.buffer_b + ZETES_TEMP_BUFFER_SIZE;
+		}
+
+		state.buffer_i = state.buffer_b;
+		state.buffer_m = state.buffer_b;
+
+		if ( write_cbor_value(&state, ctx->stack_ptr) ) {
+			flush(&state);
+		}
+	}
+
+	return ctx->result;
+}
+
+
+zetes_result_t zetes_write_cbor_buffer(zetes_t* ctx, void* buffer, size_t buffer_size, size_t* length) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+	ZETES_ASSERT(buffer);
+
+	if ( ok(ctx) && stack_validate(ctx, 1) ) {
+		wstate_t state;
+
+		init_wstate(&state, ctx, NULL, NULL);
+		state.buffer_b = (char*) buffer;
+		state.buffer_i = state.buffer_b;
+		state.buffer_e = state.buffer_b + buffer_size;
+
+		// unlike JSON text the output has no terminator, so its length is the only way to know its end
+		if ( write_cbor_value(&state, ctx->stack_ptr) && length ) {
+			*length = (size_t) (state.buffer_i - state.buffer_b);
+		}
+	}
+
+	return ctx->result;
+}
+
+
+static bool read_cbor_bytes(rstate_t* state, void* out, size_t length) {
+	// copies the next length bytes of input, which may span any number of refills
+	char* out_i = (char*) out;
+
+	while ( length > 0 ) {
+		size_t available;
+
+		if ( state->buffer_i >= state->buffer_e && !refill(state) ) {
+			set_error(state->ctx, ZETES_RESULT_UNEXPECTED_END_OF_INPUT);
+			return false;
+		}
+
+		available = (size_t) (state->buffer_e - state->buffer_i);
+
+		if ( available > length ) {
+			available = length;
+		}
+
+		memcpy(out_i, state->buffer_i, available);
+		state->buffer_i += available;
+		out_i += available;
+		length -= available;
+	}
+
+	return true;
+}
+
+
+static bool read_cbor_head(rstate_t* state, uint8_t* initial, uint64_t* argument) {
+	uint8_t bytes[8];
+	int info;
+	size_t i, size;
+
+	if ( !read_cbor_bytes(state, initial, 1) ) {
+		return false;
+	}
+
+	info = *initial & 0x1F;
+	*argument = 0;
+
+	if ( info < 24 ) {
+		*argument = (uint64_t) info;
+		return true;
+	} else if ( info == CBOR_INDEFINITE ) {
+		return true;
+	} else if ( info > 27 ) {
+		set_error(state->ctx, ZETES_RESULT_SYNTAX_ERROR);
+		return false;
+	}
+
+	size = (size_t) 1 << (info - 24);
+
+	if ( !read_cbor_bytes(state, bytes, size) ) {
+		return false;
+	}
+
+	for (i = 0; i < size; i++) {
+		*argument = (*argument << 8) | bytes[i];
+	}
+
+	return true;
+}
+
+
+static void cbor_integer(zetes_value_t* value, bool is_negative, uint64_t argument) {
+	// kept exact where zetes_int_t can hold it, as lex_number() does
+	if ( argument <= (uint64_t) INT64_MAX ) {
+		int64_t integer = is_negative ? -(int64_t) argument - 1 : (int64_t) argument;
+
+		if ( (int64_t) (zetes_int_t) integer == integer ) {
+			value->type = ZETES_TYPE_INTEGER;
+			value->variant._int = (zetes_int_t) integer;
+			return;
+		}
+	}
+
+	value->type = ZETES_TYPE_NUMBER;
+	value->variant._number = (zetes_number_t) (is_negative ? -1.0 - (double) argument : (double) argument);
+}
+
+
+static double cbor_half(uint64_t half) {
+	// widens the bits of a half precision number into those of a double
+	uint64_t sign = (half & 0x8000) << 48;
+	uint64_t exponent = (half >> 10) & 0x1F;
+	uint64_t mantissa = half & 0x3FF;
+	uint64_t bits;
+	double d;
+
+	if ( exponent == 0 ) {
+		// zero or subnormal, mantissa * 2^-24
+		d = (double) mantissa / 16777216.0;
+		return sign ? -d : d;
+	}
+
+	exponent = exponent == 0x1F ? 0x7FF : exponent - 15 + 1023;
+	bits = sign | (exponent << 52) | (mantissa << 42);
+	memcpy(&d, &bits, sizeof(d));
+
+	return d;
+}
+
+
+static bool read_cbor_simple(zetes_t* ctx, uint8_t initial, uint64_t argument, zetes_value_t* value) {
+	float f;
+	uint32_t bits;
+	double d;
+
+	switch ( initial ) {
+	case CBOR_FALSE:
+	case CBOR_TRUE:
+		value->type = ZETES_TYPE_BOOL;
+		value->variant._bool = initial == CBOR_TRUE;
+		return true;
+
+	case CBOR_NULL:
+	case CBOR_UNDEFINED:
+		// JSON has no undefined
+		value->type = ZETES_TYPE_NULL;
+		return true;
+
+	case CBOR_HALF:
+		d = cbor_half(argument);
+		break;
+
+	case CBOR_FLOAT:
+		bits = (uint32_t) argument;
+		memcpy(&f, &bits, sizeof(f));
+		d = f;
+		break;
+
+	case CBOR_DOUBLE:
+		memcpy(&d, &argument, sizeof(d));
+		break;
+
+	default:
+		set_error(ctx, ZETES_RESULT_SYNTAX_ERROR);
+		return false;
+	}
+
+	value->type = ZETES_TYPE_NUMBER;
+	value->variant._number = (zetes_number_t) d;
+
+	return true;
+}
+
+
+static bool read_cbor_string(rstate_t* state, uint64_t length, zetes_value_t* value) {
+	// strings are NUL terminated, so even a buffer's are copied
+	char* str;
+
+	if ( length >= SIZE_MAX ) {
+		set_error(state->ctx, ZETES_RESULT_OUT_OF_MEMORY);
+		return false;
+	}
+
+	str = alloc_string(state->ctx, (size_t) length + 1);
+
+	if ( !str || !read_cbor_bytes(state, str, (size_t) length) ) {
+		return false;
+	}
+
+	str[length] = 0;
+	value->type = ZETES_TYPE_STRING;
+	value->variant._string = str;
+	value->length = (size_t) length;
+
+	return true;
+}
+
+
+static size_t* cbor_remaining(zetes_t* ctx, bool in_object) {
+	zetes_value_t* container = ctx->stack_ptr;
+
+	return in_object ? &container->variant._object->count : &container->variant._array->count;
+}
+
+
+static void parse_cbor(rstate_t* state) {
+	// Builds the tree without recursion, in the same way as build_event(). Until a container is closed
+	// its count holds how many more values it expects, or SIZE_MAX if it ends with a break. Within an
+	// object the top of the value stack is the object itself until a key is read, then that key.
+	zetes_t* ctx = state->ctx;
+	zetes_reader_t* reader = &ctx->reader;
+	size_t depth = 0;
+
+	while ( ok(ctx) ) {
+		bool in_object = depth > 0 && is_object_nesting(reader, depth);
+		bool is_key = in_object && ctx->stack_ptr->type == ZETES_TYPE_OBJECT;
+		bool is_closed = false;
+		zetes_value_t value;
+		uint8_t initial;
+		uint64_t argument;
+		int major;
+
+		if ( !read_cbor_head(state, &initial, &argument) ) {
+			return;
+		}
+
+		major = initial >> 5;
+
+		if ( major == CBOR_TAG ) {
+			// a tag only qualifies the item after it, which is read as it is
+			continue;
+		}
+
+		if ( is_key && major != CBOR_TEXT && initial != CBOR_BREAK ) {
+			set_error(ctx, ZETES_RESULT_SYNTAX_ERROR);
+			return;
+		}
+
+		switch ( major ) {
+		case CBOR_UNSIGNED:
+		case CBOR_NEGATIVE:
+			cbor_integer(&value, major == CBOR_NEGATIVE, argument);
+			break;
+
+		case CBOR_TEXT:
+			if ( (initial & 0x1F) == CBOR_INDEFINITE ) {
+				set_error(ctx, ZETES_RESULT_SYNTAX_ERROR);
+				return;
+			}
+
+			if ( !read_cbor_string(state, argument, &value) ) {
+				return;
+			}
+
+			break;
+
+		case CBOR_ARRAY:
+		case CBOR_MAP:
+			if ( (initial & 0x1F) == CBOR_INDEFINITE ) {
+				argument = SIZE_MAX;
+			} else if ( argument >= SIZE_MAX ) {
+				set_error(ctx, ZETES_RESULT_UNEXPECTED_END_OF_INPUT);
+				return;
+			}
+
+			if ( !push_nesting(ctx, depth, major == CBOR_MAP) ) {
+				return;
+			}
+
+			if ( major == CBOR_MAP ) {
+				build_begin_object(ctx);
+			} else {
+				build_begin_array(ctx);
+			}
+
+			if ( !ok(ctx) ) {
+				return;
+			}
+
+			if ( argument == 0 ) {
+				if ( major == CBOR_MAP ) {
+					build_end_object(ctx);
+				} else {
+					build_end_array(ctx);
+				}
+
+				is_closed = true;
+				break;
+			}
+
+			*cbor_remaining(ctx, major == CBOR_MAP) = (size_t) argument;
+			depth++;
+			continue;
+
+		case CBOR_SIMPLE:
+			if ( initial == CBOR_BREAK ) {
+				size_t* remaining;
+
+				// only an indefinite container can end here, and not between a key and its value
+				if ( depth == 0 || (in_object && !is_key) ) {
+					set_error(ctx, ZETES_RESULT_SYNTAX_ERROR);
+					return;
+				}
+
+				remaining = cbor_remaining(ctx, in_object);
+
+				if ( *remaining != SIZE_MAX ) {
+					set_error(ctx, ZETES_RESULT_SYNTAX_ERROR);
+					return;
+				}
+
+				*remaining = 0;
+
+				if ( in_object ) {
+					build_end_object(ctx);
+				} else {
+					build_end_array(ctx);
+				}
+
+				depth--;
+				is_closed = true;
+				break;
+			}
+
+			if ( !read_cbor_simple(ctx, initial, argument, &value) ) {
+				return;
+			}
+
+			break;
+
+		default:
+			// byte strings have no JSON counterpart
+			set_error(ctx, ZETES_RESULT_SYNTAX_ERROR);
+			return;
+		}
+
+		if ( !is_closed ) {
+			zetes_value_t* slot;
+
+			if ( is_key ) {
+				build_key(ctx, &value);
+				continue;
+			}
+
+			slot = stack_emplace(ctx);
+
+			if ( !slot ) {
+				return;
+			}
+
+			*slot = value;
+		}
+
+		// the value is complete: add it to its container, closing any that it was the last value of
+		while ( ok(ctx) ) {
+			size_t* remaining;
+
+			if ( depth == 0 ) {
+				// a single item, with nothing after it
+				if ( state->buffer_i < state->buffer_e || refill(state) ) {
+					set_error(ctx, ZETES_RESULT_SYNTAX_ERROR);
+				}
+
+				return;
+			}
+
+			in_object = is_object_nesting(reader, depth);
+			build_attach(ctx, in_object);
+
+			if ( !ok(ctx) ) {
+				return;
+			}
+
+			remaining = cbor_remaining(ctx, in_object);
+
+			if ( *remaining == SIZE_MAX || --*remaining > 0 ) {
+				break;
+			}
+
+			if ( in_object ) {
+				build_end_object(ctx);
+			} else {
+				build_end_array(ctx);
+			}
+
+			depth--;
+		}
+	}
+}
+
+
+static zetes_result_t read_cbor(rstate_t* state) {
+	zetes_t* ctx = state->ctx;
+	size_t saved_depth = scratch_depth(ctx);
+
+	parse_cbor(state);
+
+	// scratch areas left open by an error
+	ctx->buffer_end = scratch_at(ctx, saved_depth);
+
+	return ctx->result;
+}
+
+
+zetes_result_t zetes_read_cbor(zetes_t* ctx, zetes_read_func_t read_func, void* user_data) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+	ZETES_ASSERT(read_func);
+
+	if ( ok(ctx) ) {
+		rstate_t rstate;
+
+		init_rstate(&rstate, ctx, read_func, user_data, NULL, NULL, false);
+
+		read_cbor(&rstate);
+	}
+
+	return ctx->result;
+}
+
+
+zetes_result_t zetes_read_cbor_buffer(zetes_t* ctx, const void* buffer, size_t buffer_size) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+	ZETES_ASSERT(buffer);
+
+	if ( ok(ctx) ) {
+		rstate_t rstate;
+
+		init_rstate(&rstate, ctx, NULL, NULL, (char*) buffer, (char*) buffer + buffer_size, false);
+
+		read_cbor(&rstate);
+	}
+
+	return ctx->result;
+}
+
+
+// A snapshot is a copy of a tree laid out in a single buffer, so it can be used again without being
+// parsed. Each container is followed by its values or members (and its index), then come the strings
+// and containers they refer to, in the order write_value() visits them. Pointers are valid for the
+// buffer the snapshot was made in. The header also gives the deepest nesting of non-empty containers,
+// so loading knows up front how many frames it needs.
+
+#define SNAPSHOT_MAGIC		0x5A534E31
+
+
+static uint32_t snapshot_layout(void) {
+	// tells apart builds whose trees are laid out differently in memory
+	uint32_t layout = (uint32_t) sizeof(void*);
+
+	layout = layout * 31 + (uint32_t) sizeof(zetes_value_t);
+	layout = layout * 31 + (uint32_t) sizeof(zetes_array_t);
+	layout = layout * 31 + (uint32_t) sizeof(zetes_object_t);
+	layout = layout * 31 + (uint32_t) sizeof(zetes_object_member_t);
+	layout = layout * 31 + (uint32_t) sizeof(zetes_number_t);
+	layout = layout * 31 + (uint32_t) sizeof(zetes_int_t);
+	layout = layout * 31 + (uint32_t) ZETES_ALIGN;
+
+	return layout * 2 + ((zetes_number_t) 0.5 == 0);
+}
+
+
+static size_t snapshot_place(sstate_t* s, size_t size, bool aligned) {
+	// claims the next size bytes of the snapshot and returns their offset, failing with
+	// ZETES_RESULT_WRITE_ERROR if they don't fit
+	size_t offset = s->length;
+
+	if ( aligned ) {
+		offset = (offset + (ZETES_ALIGN - 1)) / ZETES_ALIGN * ZETES_ALIGN;
+	}
+
+	if ( offset < s->length || size > SIZE_MAX - offset || (s->image && offset + size > s->capacity) ) {
+		set_error(s->ctx, ZETES_RESULT_WRITE_ERROR);
+		return 0;
+	}
+
+	s->length = offset + size;
+
+	return offset;
+}
+
+
+static void* snapshot_at(const sstate_t* s, size_t offset) {
+	// NULL when only measuring
+	return s->image ? s->image + offset : NULL;
+}
+
+
+static void snapshot_put(sstate_t* s, size_t offset, const void* data, size_t size) {
+	if ( s->image ) {
+		memcpy(s->image + offset, data, size);
+	}
+}
+
+
+static const char* snapshot_string(sstate_t* s, const char* str, size_t length) {
+	size_t offset = snapshot_place(s, length + 1, false);
+
+	if ( !ok(s->ctx) ) {
+		return NULL;
+	}
+
+	snapshot_put(s, offset, str, length);
+	snapshot_put(s, offset + length, "", 1);
+
+	return (const char*) snapshot_at(s, offset);
+}
+
+
+static void snapshot_array(sstate_t* s, const zetes_array_t* array, zetes_array_t** copy, sframe_t* frame) {
+	// places a copy of the array, with its values to be filled in from frame->slot on if it has any
+	zetes_array_t header;
+	size_t offset = snapshot_place(s, sizeof(zetes_array_t), true);
+	size_t values = snapshot_place(s, array->size * sizeof(zetes_value_t), true);
+
+	if ( !ok(s->ctx) ) {
+		return;
+	}
+
+	// appended elements join the rest, so a copy is always frozen
+	header.values = array->size > 0 ? (zetes_value_t*) snapshot_at(s, values) : NULL;
+	header.count = array->size;
+	header.size = array->size;
+	header.first = NULL;
+	header.last = NULL;
+	header.lazy = NULL;
+	header.lazy_end = NULL;
+
+	snapshot_put(s, offset, &header, sizeof(header));
+	*copy = (zetes_array_t*) snapshot_at(s, offset);
+
+	if ( frame ) {
+		frame->slot = values;
+		frame->index = 0;
+		frame->index_mask = 0;
+	}
+}
+
+
+static void snapshot_object(sstate_t* s, const zetes_object_t* object, zetes_object_t** copy, sframe_t* frame) {
+	// as snapshot_array(), with an empty index of the same capacity if the object has one
+	zetes_object_t header;
+	size_t offset = snapshot_place(s, sizeof(zetes_object_t), true);
+	size_t members = snapshot_place(s, object->size * sizeof(zetes_object_member_t), true);
+	size_t capacity = object->index ? (size_t) object->index_mask + 1 : 0;
+	size_t index = capacity > 0 ? snapshot_place(s, capacity * sizeof(zetes_object_member_t*), true) : 0;
+
+	if ( !ok(s->ctx) ) {
+		return;
+	}
+
+	header.members = object->size > 0 ? (zetes_object_member_t*) snapshot_at(s, members) : NULL;
+	header.count = object->size;
+	header.size = object->size;
+	header.first = NULL;
+	header.last = NULL;
+	header.index = capacity > 0 ? (zetes_object_member_t**) snapshot_at(s, index) : NULL;
+	header.index_mask = capacity > 0 ? object->index_mask : 0;
+	header.lazy = NULL;
+	header.lazy_end = NULL;
+
+	snapshot_put(s, offset, &header, sizeof(header));
+
+	if ( s->image && capacity > 0 ) {
+		memset(s->image + index, 0, capacity * sizeof(zetes_object_member_t*));
+	}
 
-		if ( exp_negative ) exp -= exp_part;
-		else exp += exp_part;
+	*copy = (zetes_object_t*) snapshot_at(s, offset);
+
+	if ( frame ) {
+		frame->slot = members;
+		frame->index = index;
+		frame->index_mask = header.index_mask;
 	}
+}
 
-	putback_char(state, c);
 
-	power = (zetes_number_t) 10.0;
+static size_t snapshot_member(sstate_t* s, const sframe_t* frame, const zetes_object_member_t* member) {
+	// copies a member with its key, returning the offset of its value which is filled in next
+	zetes_object_member_t copy = *member;
 
-	if ( exp < 0 )
-	{
-		exp = -exp;
+	copy.key = snapshot_string(s, member->key, member->key_length);
 
-		while (exp)
-		{
-			if ( exp & 1 ) value /= power;
-			exp >>= 1;
-			power *= power;
-		}
+	if ( !ok(s->ctx) ) {
+		return 0;
 	}
-	else
-	{
-		while (exp)
-		{
-			if ( exp & 1 ) value *= power;
-			exp >>= 1;
-			power *= power;
+
+	snapshot_put(s, frame->slot, &copy, sizeof(copy));
+
+	if ( s->image && frame->index ) {
+		zetes_object_member_t** index = (zetes_object_member_t**) (s->image + frame->index);
+		uint32_t i = member->key_hash & frame->index_mask;
+
+		while ( index[i] ) {
+			i = (i + 1) & frame->index_mask;
 		}
-	}
 
-	if ( is_negative ) value = -value;
+		index[i] = (zetes_object_member_t*) (s->image + frame->slot);
+	}
 
-	state->token_type = TOKEN_TYPE_LITERAL;
-	state->token_value.type = ZETES_TYPE_NUMBER;
-	state->token_value.variant._number = value;
+	return frame->slot + offsetof(zetes_object_member_t, value);
 }
 
 
-static void next_token(rstate_t* state) {
-	zetes_t* ctx = state->ctx;
-	state->token_type = TOKEN_TYPE_UNDEFINED;
-	state->token_value.type = ZETES_TYPE_NONE;
+static bool snapshot_items(sstate_t* s, const zetes_value_t* value, size_t slot, size_t base) {
+	// Copies each value into the slot placed for it, visiting them as write_value() does. As in
+	// write_cbor_items() the frames are in a scratch area, since lazy containers are resolved on the way.
+	zetes_t* ctx = s->ctx;
 
 	for (;;) {
-		char c = next_char(state);
+		const zetes_array_t* array;
+		const zetes_object_t* object;
+		const zetes_object_member_t* member = NULL;
+		const zetes_value_t* next = NULL;
+		zetes_value_t copy = *value;
+		sframe_t* frame;
+
+		switch(value->type) {
+		case ZETES_TYPE_STRING:
+			copy.variant._string = snapshot_string(s, value->variant._string, value->length);
+			break;
 
-		if ( is_whitespace(c) ) {
-			continue;
-		} else if ( is_end_of_input(c) ) {
-			state->token_type = TOKEN_TYPE_END_OF_INPUT;
-		} else if ( is_key_val_separator(c) ) {
-			state->token_type = TOKEN_TYPE_KEY_VAL_SEPARATOR;
-		} else if ( is_comma(c) ) {
-			state->token_type = TOKEN_TYPE_COMMA;
-		} else if ( is_object_open(c) ) {
-			state->token_type = TOKEN_TYPE_OBJECT_OPEN;
-		} else if ( is_object_close(c) ) {
-			state->token_type = TOKEN_TYPE_OBJECT_CLOSE;
-		} else if ( is_array_open(c) ) {
-			state->token_type = TOKEN_TYPE_ARRAY_OPEN;
-		} else if ( is_array_close(c) ) {
-			state->token_type = TOKEN_TYPE_ARRAY_CLOSE;
-		} else if ( is_quote(c) ) {
-			lex_string(state);
-		} else if ( is_digit(c) || is_minus(c) ) {
-			putback_char(state, c);
-			lex_number(state);
-		} else if ( c == SYMBOL_NULL[0] ) {
-			if ( next_char(state) != SYMBOL_NULL[1] ||
-					next_char(state) != SYMBOL_NULL[2] ||
-					next_char(state) != SYMBOL_NULL[3] ) {
-				set_error(ctx, ZETES_RESULT_UNKNOWN_KEYWORD);
+		case ZETES_TYPE_ARRAY:
+			if ( !resolve(ctx, value) ) {
+				return false;
+			}
+
+			array = value->variant._array;
+
+			if ( array->size > 0 && (frame = (sframe_t*) push_scratch(ctx, sizeof(sframe_t))) ) {
+				frame_begin(&frame->source, array->count > 0 ? array : NULL, array->first, false);
+				next = array->count > 0 ? &array->values[0] : &array->first->value;
 			} else {
-				state->token_type = TOKEN_TYPE_LITERAL;
-				state->token_value.type = ZETES_TYPE_NULL;
+				frame = NULL;
 			}
-		} else if ( c == SYMBOL_FALSE[0] ) {
-			if ( next_char(state) != SYMBOL_FALSE[1] ||
-					next_char(state) != SYMBOL_FALSE[2] ||
-					next_char(state) != SYMBOL_FALSE[3] ||
-					next_char(state) != SYMBOL_FALSE[4] ) {
-				set_error(ctx, ZETES_RESULT_UNKNOWN_KEYWORD);
+
+			if ( ok(ctx) ) {
+				snapshot_array(s, array, &copy.variant._array, frame);
+			}
+
+			break;
+
+		case ZETES_TYPE_OBJECT:
+			if ( !resolve(ctx, value) ) {
+				return false;
+			}
+
+			object = value->variant._object;
+
+			if ( object->size > 0 && (frame = (sframe_t*) push_scratch(ctx, sizeof(sframe_t))) ) {
+				frame_begin(&frame->source, object->count > 0 ? object : NULL, object->first, true);
+				member = object->count > 0 ? &object->members[0] : &object->first->member;
 			} else {
-				state->token_type = TOKEN_TYPE_LITERAL;
-				state->token_value.type = ZETES_TYPE_BOOL;
-				state->token_value.variant._bool = false;
+				frame = NULL;
 			}
-		} else if ( c == SYMBOL_TRUE[0] ) {
-			if ( next_char(state) != SYMBOL_TRUE[1] ||
-					next_char(state) != SYMBOL_TRUE[2] ||
-					next_char(state) != SYMBOL_TRUE[3] ) {
-				set_error(ctx, ZETES_RESULT_UNKNOWN_KEYWORD);
+
+			if ( ok(ctx) ) {
+				snapshot_object(s, object, &copy.variant._object, frame);
+			}
+
+			break;
+
+		default:
+			break;
+		}
+
+		if ( !ok(ctx) ) {
+			return false;
+		}
+
+		if ( (scratch_depth(ctx) - base) / sizeof(sframe_t) > s->depth ) {
+			s->depth = (scratch_depth(ctx) - base) / sizeof(sframe_t);
+		}
+
+		snapshot_put(s, slot, &copy, sizeof(copy));
+
+		// descend into a container, or move on to the next value of the innermost one with any left
+		while ( !next && !member ) {
+			if ( scratch_depth(ctx) == base ) {
+				return true;
+			}
+
+			frame = (sframe_t*) ctx->buffer_end;
+
+			if ( frame_is_object(&frame->source) ) {
+				member = next_frame_member(&frame->source);
+				frame->slot += sizeof(zetes_object_member_t);
 			} else {
-				state->token_type = TOKEN_TYPE_LITERAL;
-				state->token_value.type = ZETES_TYPE_BOOL;
-				state->token_value.variant._bool = true;
+				next = next_frame_value(&frame->source);
+				frame->slot += sizeof(zetes_value_t);
+			}
+
+			if ( !next && !member ) {
+				ctx->buffer_end = frame + 1;
+			}
+		}
+
+		frame = (sframe_t*) ctx->buffer_end;
+
+		if ( member ) {
+			slot = snapshot_member(s, frame, member);
+			value = &member->value;
+
+			if ( !ok(ctx) ) {
+				return false;
 			}
 		} else {
-			set_error(ctx, ZETES_RESULT_INVALID_CHARACTER);
+			slot = frame->slot;
+			value = next;
 		}
-		
-		break;
 	}
 }
 
 
-static bool match_token(rstate_t* state, token_type_t type) {
-	if ( state->token_type == type ) {
-		next_token(state);
-		return true;
-	} else {
-		return false;
+zetes_result_t zetes_snapshot(zetes_t* ctx, void* buffer, size_t buffer_size, size_t* length) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+	ZETES_ASSERT(buffer || length);
+	ZETES_ASSERT((uintptr_t) buffer % ZETES_ALIGN == 0);
+
+	if ( ok(ctx) && stack_validate(ctx, 1) ) {
+		size_t saved_depth = scratch_depth(ctx);
+		size_t base = (size_t) ((char*) ctx->buffer_top - (char*) align_down(ctx->buffer_end));
+		sstate_t s;
+
+		// without a buffer the snapshot is only measured
+		s.ctx = ctx;
+		s.image = (char*) buffer;
+		s.capacity = buffer_size;
+		s.length = 0;
+		s.depth = 0;
+		snapshot_place(&s, sizeof(snapshot_t), true);
+
+		ctx->buffer_end = scratch_at(ctx, base);
+		snapshot_items(&s, ctx->stack_ptr, offsetof(snapshot_t, root), base);
+		ctx->buffer_end = scratch_at(ctx, saved_depth);
+
+		if ( ok(ctx) ) {
+			snapshot_t* header = (snapshot_t*) buffer;
+
+			if ( header ) {
+				header->magic = SNAPSHOT_MAGIC;
+				header->layout = snapshot_layout();
+				header->size = s.length;
+				header->depth = s.depth;
+				header->base = buffer;
+			}
+
+			if ( length ) {
+				*length = s.length;
+			}
+		}
 	}
+
+	return ctx->result;
 }
 
 
-static bool expect_token(rstate_t* state, token_type_t type) {
-	zetes_t* ctx = state->ctx;
+static void* relocate(lstate_t* ls, const void* ptr, size_t size, bool aligned) {
+	// Moves a pointer by the distance the snapshot has moved. Everything it points to must come after
+	// whatever was relocated before, as it was laid out, so nothing can be relocated twice.
+	uintptr_t p = (uintptr_t) ptr + ls->delta;
 
-	if ( state->token_type != type ) {
-		set_error(ctx, ZETES_RESULT_SYNTAX_ERROR);
-		return false;
-	} else {
-		return true;
+	if ( p < ls->high || p > ls->end || size > ls->end - p || (aligned && p % ZETES_ALIGN != 0) ) {
+		return NULL;
 	}
+
+	ls->high = p + size;
+
+	return (void*) p;
 }
 
 
-static void parse_array(rstate_t* state) {
-	zetes_t* ctx = state->ctx;
+static bool relocate_index(lstate_t* ls, zetes_object_t* object) {
+	size_t capacity = (size_t) object->index_mask + 1;
+	uintptr_t members = (uintptr_t) object->members;
+	size_t used = 0;
+	size_t i;
 
-	zetes_push_new_array(ctx);
+	if ( (capacity & object->index_mask) != 0 || capacity > SIZE_MAX / sizeof(zetes_object_member_t*) ) {
+		return false;
+	}
 
-	if ( !match_token(state, TOKEN_TYPE_ARRAY_CLOSE) ) {
-		while ( ok(ctx) ) {
-			parse_value(state);
-			zetes_array_append(ctx);
+	object->index = (zetes_object_member_t**) relocate(ls, object->index, capacity * sizeof(zetes_object_member_t*), true);
 
-			if ( match_token(state, TOKEN_TYPE_COMMA) ) {
-				continue;
-			}
+	if ( !object->index ) {
+		return false;
+	}
 
-			if ( !match_token(state, TOKEN_TYPE_ARRAY_CLOSE) ) {
-				set_error(ctx, ZETES_RESULT_SYNTAX_ERROR);
+	for (i = 0; i < capacity; i++) {
+		if ( object->index[i] ) {
+			// must be one of the object's members, and leave a slot free to end each probe
+			uintptr_t p = (uintptr_t) object->index[i] + ls->delta;
+
+			if ( p < members || (p - members) % sizeof(zetes_object_member_t) != 0 ||
+					(p - members) / sizeof(zetes_object_member_t) >= object->size || ++used >= capacity ) {
+				return false;
 			}
 
-			break;
+			object->index[i] = (zetes_object_member_t*) p;
 		}
 	}
+
+	return true;
 }
 
 
-static void parse_object(rstate_t* state) {
-	zetes_t* ctx = state->ctx;
+static bool relocate_value(lstate_t* ls, zetes_value_t* value) {
+	// relocates a value and, for a container, the values or members it holds (but not what they refer to)
+	const char* str;
+	zetes_array_t* array;
+	zetes_object_t* object;
 
-	zetes_push_new_object(ctx);
+	bool no = false;
+	bool yes = true;
 
-	if ( !match_token(state, TOKEN_TYPE_OBJECT_CLOSE) ) {
-		while ( ok(ctx) ) {
-			const char* key;
+	switch(value->type) {
+	case ZETES_TYPE_NULL:
+	case ZETES_TYPE_NUMBER:
+	case ZETES_TYPE_INTEGER:
+		return true;
 
-			if ( !expect_token(state, TOKEN_TYPE_LITERAL) || state->token_value.type != ZETES_TYPE_STRING ) {
-				set_error(ctx, ZETES_RESULT_SYNTAX_ERROR);
-				break;
-			}
+	case ZETES_TYPE_BOOL:
+		// compared as bytes, since reading a corrupt bool is undefined behaviour
+		return memcmp(&value->variant._bool, &no, sizeof(bool)) == 0 || memcmp(&value->variant._bool, &yes, sizeof(bool)) == 0;
 
-			key = state->token_value.variant._string;
+	case ZETES_TYPE_STRING:
+		str = (const char*) relocate(ls, value->variant._string, (size_t) value->length + 1, false);
+		value->variant._string = str;
+		return str && str[value->length] == 0;
 
-			next_token(state);
+	case ZETES_TYPE_ARRAY:
+		array = (zetes_array_t*) relocate(ls, value->variant._array, sizeof(zetes_array_t), true);
+		value->variant._array = array;
 
-			if ( !match_token(state, TOKEN_TYPE_KEY_VAL_SEPARATOR) ) {
-				break;
-			}
+		if ( !array || array->count != array->size || array->first || array->last || array->lazy ) {
+			return false;
+		}
 
-			parse_value(state);
-			object_set_with_interned_key(ctx, key);
+		if ( array->size == 0 ) {
+			return !array->values;
+		}
 
-			if ( match_token(state, TOKEN_TYPE_COMMA) ) {
-				continue;
-			}
+		if ( array->size > SIZE_MAX / sizeof(zetes_value_t) ) {
+			return false;
+		}
 
-			if ( !match_token(state, TOKEN_TYPE_OBJECT_CLOSE) ) {
-				set_error(ctx, ZETES_RESULT_SYNTAX_ERROR);
-			}
+		array->values = (zetes_value_t*) relocate(ls, array->values, array->size * sizeof(zetes_value_t), true);
+		return array->values != NULL;
 
-			break;
+	case ZETES_TYPE_OBJECT:
+		object = (zetes_object_t*) relocate(ls, value->variant._object, sizeof(zetes_object_t), true);
+		value->variant._object = object;
+
+		if ( !object || object->count != object->size || object->first || object->last || object->lazy ) {
+			return false;
 		}
-	}
-}
 
+		if ( object->size == 0 ) {
+			return !object->members && !object->index;
+		}
 
-static void parse_value(rstate_t* state) {
-	if ( !ok(state->ctx) ) return;
+		if ( object->size > SIZE_MAX / sizeof(zetes_object_member_t) ) {
+			return false;
+		}
 
-	if ( match_token(state, TOKEN_TYPE_ARRAY_OPEN) ) {
-		parse_array(state);
-	} else if ( match_token(state, TOKEN_TYPE_OBJECT_OPEN) ) {
-		parse_object(state);
-	} else {
-		if ( expect_token(state, TOKEN_TYPE_LITERAL ) ) {
-			zetes_value_t* slot = stack_emplace(state->ctx);
+		object->members = (zetes_object_member_t*) relocate(ls, object->members, object->size * sizeof(zetes_object_member_t), true);
 
-			if ( slot ) {
-				*slot = state->token_value;
-				next_token(state);
-			}
+		if ( !object->members ) {
+			return false;
 		}
+
+		return !object->index || relocate_index(ls, object);
+
+	default:
+		return false;
 	}
 }
 
 
-zetes_result_t zetes_read(zetes_t* ctx, zetes_read_func_t read_func, void* user_data) {
-	ZETES_ASSERT(ctx);
-	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
-	ZETES_ASSERT(read_func);
+static bool relocate_tree(zetes_t* ctx, lstate_t* ls, zetes_value_t* value, size_t max_depth) {
+	// Visits values in the order they were laid out. Nothing is allocated, so the frames are kept as
+	// write_value() keeps them, with any beyond the value stack's free slots in a scratch area sized
+	// from the depth the header gives, which the tree mustn't exceed.
+	frames_t frames;
+	size_t depth = 0;
+	size_t spill = 0;
 
-	if ( ok(ctx) ) {
-		rstate_t rstate;
+	init_frames(&frames, ctx, NULL, NULL);
 
-		rstate.ctx = ctx;
-		rstate.read_func = read_func;
-		rstate.user_data = user_data;
-		rstate.buffer_i = NULL;
-		rstate.buffer_e = NULL;
-		rstate.prev_char = 0;
-		rstate.token_type = TOKEN_TYPE_UNDEFINED;
+	if ( max_depth > WFRAME_FIXED + frames.stack_count ) {
+		spill = max_depth - WFRAME_FIXED - frames.stack_count;
+	}
 
-		next_token(&rstate);
-		parse_value(&rstate);
+	frames.spill_b = (wframe_t*) push_scratch(ctx, spill * sizeof(wframe_t));
+	frames.spill_e = frames.spill_b + spill;
 
-		if ( ok(ctx) ) {
-			expect_token(&rstate, TOKEN_TYPE_END_OF_INPUT);
-		}
+	if ( !frames.spill_b ) {
+		return false;
 	}
 
-	return ctx->result;
-}
+	for (;;) {
+		if ( !relocate_value(ls, value) ) {
+			set_error(ctx, ZETES_RESULT_INVALID_SNAPSHOT);
+			return false;
+		}
 
+		if ( (value->type == ZETES_TYPE_ARRAY && value->variant._array->size > 0) ||
+				(value->type == ZETES_TYPE_OBJECT && value->variant._object->size > 0) ) {
+			if ( depth == max_depth ) {
+				set_error(ctx, ZETES_RESULT_INVALID_SNAPSHOT);
+				return false;
+			}
 
-static int read_buffer_func(void* buffer, int length, void* user_data) {
-	read_buffer_state_t* state = (read_buffer_state_t*) user_data;
-	size_t remaining = state->e - state->i;
+			frame_begin(frame_at(&frames, depth++), value->variant._array, NULL, value->type == ZETES_TYPE_OBJECT);
+		}
 
-	if ( length > remaining ) {
-		length = remaining;
-	}
+		// the next value, with its key if it's a member
+		for (;;) {
+			wframe_t* top;
 
-	memcpy(buffer, state->i, length);
-	state->i += length;
+			if ( depth == 0 ) {
+				return true;
+			}
 
-	return length;
+			top = frame_at(&frames, depth - 1);
+
+			if ( frame_is_object(top) ) {
+				zetes_object_t* object = (zetes_object_t*) top->cursor;
+
+				if ( frame_position(top) < object->size ) {
+					zetes_object_member_t* member = &object->members[frame_position(top)];
+
+					top->index++;
+					member->key = (const char*) relocate(ls, member->key, (size_t) member->key_length + 1, false);
+
+					if ( !member->key || member->key[member->key_length] != 0 ) {
+						set_error(ctx, ZETES_RESULT_INVALID_SNAPSHOT);
+						return false;
+					}
+
+					value = &member->value;
+					break;
+				}
+			} else {
+				zetes_array_t* array = (zetes_array_t*) top->cursor;
+
+				if ( frame_position(top) < array->size ) {
+					value = &array->values[frame_position(top)];
+					top->index++;
+					break;
+				}
+			}
+
+			depth--;
+		}
+	}
 }
 
 
-zetes_result_t zetes_read_buffer(zetes_t* ctx, const char* buffer, size_t buffer_size) {
-	read_buffer_state_t state;
+zetes_result_t zetes_load_snapshot(zetes_t* ctx, void* buffer, size_t buffer_size) {
+	ZETES_ASSERT(ctx);
+	ZETES_ASSERT(ctx->result != ZETES_RESULT_UNINITIALIZED);
+	ZETES_ASSERT(buffer);
+	ZETES_ASSERT((uintptr_t) buffer % ZETES_ALIGN == 0);
 
-	state.i = buffer;
-	state.e = buffer + buffer_size;
+	if ( ok(ctx) ) {
+		snapshot_t* header = (snapshot_t*) buffer;
+		zetes_value_t* slot;
+
+		if ( buffer_size < sizeof(snapshot_t) || header->magic != SNAPSHOT_MAGIC || header->layout != snapshot_layout() ||
+				header->size < sizeof(snapshot_t) || header->size > buffer_size ||
+				header->depth > header->size / sizeof(zetes_value_t) ) {
+			set_error(ctx, ZETES_RESULT_INVALID_SNAPSHOT);
+			return ctx->result;
+		}
 
-	return zetes_read(ctx, read_buffer_func, &state);
+		// Relocated in place, checking every pointer on the way, so loading takes time in proportion to
+		// the snapshot's size even where it was made. base comes from the file too, so a snapshot loaded
+		// where it was made, or where it was loaded before, is checked all the same, just moved by
+		// nothing. A failure leaves it partly relocated. Since the tree is used in place, changes to it
+		// can point into the arena, and such a snapshot is rejected when loaded again.
+		size_t saved_depth = scratch_depth(ctx);
+		size_t base = (size_t) ((char*) ctx->buffer_top - (char*) align_down(ctx->buffer_end));
+		lstate_t ls;
+		bool relocated;
+
+		ls.begin = (uintptr_t) buffer + sizeof(snapshot_t);
+		ls.end = (uintptr_t) buffer + (size_t) header->size;
+		ls.delta = (uintptr_t) buffer - (uintptr_t) header->base;
+		ls.high = ls.begin;
+
+		ctx->buffer_end = scratch_at(ctx, base);
+		relocated = relocate_tree(ctx, &ls, &header->root, (size_t) header->depth);
+		ctx->buffer_end = scratch_at(ctx, saved_depth);
+
+		if ( !relocated ) {
+			return ctx->result;
+		}
+
+		header->base = buffer;
+
+		slot = stack_emplace(ctx);
+
+		if ( slot ) {
+			*slot = header->root;
+		}
+	}
+
+	return ctx->result;
 }
@@ -32,6 +32,12 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 
 #ifndef ZETES_ASSERT
@@ -49,11 +55,61 @@
 #endif
 
 
+#ifndef ZETES_DIRECT_READ
+#define ZETES_DIRECT_READ		1
+#endif
+
+
+#ifndef ZETES_INTEGER_TYPE
+#define ZETES_INTEGER_TYPE		int64_t
+#endif
+
+
+#ifndef ZETES_EXACT_NUMBERS
+#define ZETES_EXACT_NUMBERS		1
+#endif
+
+
+#ifndef ZETES_OBJECT_INDEX_THRESHOLD
+#define ZETES_OBJECT_INDEX_THRESHOLD	16
+#endif
+
+
+#ifndef ZETES_SIMD
+#define ZETES_SIMD				1
+#endif
+
+
+#ifndef ZETES_MAX_DEPTH
+#define ZETES_MAX_DEPTH			128
+#endif
+
+
 #ifndef ZETES_TEMP_BUFFER_SIZE
 #define ZETES_TEMP_BUFFER_SIZE	16
 #endif
 
 
+#ifndef ZETES_STATS
+#define ZETES_STATS				0
+#endif
+
+
+#ifndef ZETES_BLOCK_SIZE
+#define ZETES_BLOCK_SIZE		4096
+#endif
+
+
+#ifndef ZETES_WRITEV_SEGMENTS
+#define ZETES_WRITEV_SEGMENTS	16
+#endif
+
+
+#ifndef ZETES_WRITEV_MIN_LENGTH
+#define ZETES_WRITEV_MIN_LENGTH	64
+#endif
+
+
 typedef enum {
 	ZETES_RESULT_UNINITIALIZED,
 	ZETES_RESULT_OK,
@@ -71,7 +127,11 @@ typedef enum {
 	ZETES_RESULT_INVALID_STRING,
 	ZETES_RESULT_UNKNOWN_KEYWORD,
 	ZETES_RESULT_UNEXPECTED_END_OF_INPUT,
-	ZETES_RESULT_SYNTAX_ERROR
+	ZETES_RESULT_SYNTAX_ERROR,
+	ZETES_RESULT_NESTING_TOO_DEEP,
+	ZETES_RESULT_NEED_MORE,
+	ZETES_RESULT_INVALID_PATH,
+	ZETES_RESULT_INVALID_SNAPSHOT
 } zetes_result_t;
 
 
@@ -82,17 +142,68 @@ typedef enum {
 	ZETES_TYPE_NUMBER,
 	ZETES_TYPE_STRING,
 	ZETES_TYPE_ARRAY,
-	ZETES_TYPE_OBJECT
+	ZETES_TYPE_OBJECT,
+	ZETES_TYPE_INTEGER
 } zetes_type_t;
 
 
+typedef enum {
+	ZETES_EVENT_NONE,
+	ZETES_EVENT_END,
+	ZETES_EVENT_OBJECT_BEGIN,
+	ZETES_EVENT_OBJECT_END,
+	ZETES_EVENT_ARRAY_BEGIN,
+	ZETES_EVENT_ARRAY_END,
+	ZETES_EVENT_KEY,
+	ZETES_EVENT_VALUE
+} zetes_event_t;
+
+
 typedef ZETES_NUMBER_TYPE zetes_number_t;
 
+typedef ZETES_INTEGER_TYPE zetes_int_t;
+
+
+typedef struct {
+	void* buffer_ptr;
+	void* stack_ptr;
+	void* block;
+} zetes_mark_t;
+
+
+#if ZETES_STATS
+typedef struct {
+	size_t read_calls;
+	size_t write_calls;
+	size_t read_bytes;
+	size_t write_bytes;
+	size_t arena_peak;
+	size_t block_bytes;
+	size_t stack_peak;
+	size_t depth_peak;
+	size_t string_bytes;
+	size_t node_bytes;
+	size_t padding_bytes;
+} zetes_stats_t;
+#endif
+
+
+typedef struct {
+	const void* buffer;
+	size_t length;
+} zetes_segment_t;
+
 
 typedef int (*zetes_write_func_t) (const void* buffer, int length, void* user_data);
 
+typedef int (*zetes_writev_func_t) (const zetes_segment_t* segments, int count, void* user_data);
+
 typedef int (*zetes_read_func_t) (void* buffer, int length, void* user_data);
 
+typedef void* (*zetes_alloc_func_t) (size_t size, void* user_data);
+
+typedef void (*zetes_free_func_t) (void* ptr, size_t size, void* user_data);
+
 
 typedef struct zetes_t zetes_t;
 
@@ -103,18 +214,40 @@ void zetes_cleanup(zetes_t* ctx);
 
 void zetes_reset(zetes_t* ctx);
 
+void zetes_set_allocator(zetes_t* ctx, zetes_alloc_func_t alloc_func, zetes_free_func_t free_func, void* user_data);
+
+void zetes_enable_interning(zetes_t* ctx, size_t capacity);
+
+const char* zetes_intern(zetes_t* ctx, const char* key);
+
+zetes_mark_t zetes_mark(const zetes_t* ctx);
+
+void zetes_rollback(zetes_t* ctx, zetes_mark_t mark);
+
 zetes_result_t zetes_result(const zetes_t* ctx);
 
+#if ZETES_STATS
+const zetes_stats_t* zetes_stats(const zetes_t* ctx);
+
+void zetes_reset_stats(zetes_t* ctx);
+#endif
+
 bool zetes_ok(const zetes_t* ctx);
 
+void zetes_set_error(zetes_t* ctx, zetes_result_t result);
+
 void zetes_push_null(zetes_t* ctx);
 
 void zetes_push_bool(zetes_t* ctx, bool value);
 
 void zetes_push_number(zetes_t* ctx, zetes_number_t value);
 
+void zetes_push_int(zetes_t* ctx, zetes_int_t value);
+
 void zetes_push_string(zetes_t* ctx, const char* value);
 
+void zetes_push_string_n(zetes_t* ctx, const char* value, size_t length);
+
 void zetes_push_new_array(zetes_t* ctx);
 
 void zetes_push_new_object(zetes_t* ctx);
@@ -129,32 +262,145 @@ bool zetes_pop_bool(zetes_t* ctx);
 
 zetes_number_t zetes_pop_number(zetes_t* ctx);
 
+zetes_int_t zetes_pop_int(zetes_t* ctx);
+
 const char* zetes_pop_string(zetes_t* ctx);
 
+const char* zetes_pop_string_n(zetes_t* ctx, size_t* length);
+
 size_t zetes_array_size(zetes_t* ctx);
 
 void zetes_array_index(zetes_t* ctx, size_t index);
 
 void zetes_array_append(zetes_t* ctx);
 
+void zetes_array_freeze(zetes_t* ctx);
+
 size_t zetes_object_size(zetes_t* ctx);
 
 void zetes_object_index(zetes_t* ctx, size_t index);
 
 bool zetes_object_has(zetes_t* ctx, const char* key);
 
+bool zetes_object_has_n(zetes_t* ctx, const char* key, size_t key_length);
+
 void zetes_object_get(zetes_t* ctx, const char* key);
 
+void zetes_object_get_n(zetes_t* ctx, const char* key, size_t key_length);
+
 void zetes_object_set(zetes_t* ctx, const char* key);
 
+void zetes_object_set_n(zetes_t* ctx, const char* key, size_t key_length);
+
+void zetes_get_path(zetes_t* ctx, const char* path);
+
+void zetes_get_path_n(zetes_t* ctx, const char* path, size_t path_length);
+
+void zetes_set_write_buffer(zetes_t* ctx, void* buffer, size_t buffer_size);
+
+void zetes_set_raw_utf8(zetes_t* ctx, bool enable);
+
 zetes_result_t zetes_write(zetes_t* ctx, zetes_write_func_t write_func, void* user_data);
 
 zetes_result_t zetes_write_buffer(zetes_t* ctx, char* buffer, size_t buffer_size);
 
+zetes_result_t zetes_writev(zetes_t* ctx, zetes_writev_func_t writev_func, void* user_data);
+
+size_t zetes_measure(zetes_t* ctx);
+
+zetes_result_t zetes_write_cbor(zetes_t* ctx, zetes_write_func_t write_func, void* user_data);
+
+zetes_result_t zetes_write_cbor_buffer(zetes_t* ctx, void* buffer, size_t buffer_size, size_t* length);
+
+void zetes_writer_begin(zetes_t* ctx, zetes_write_func_t write_func, void* user_data);
+
+void zetes_writer_begin_buffer(zetes_t* ctx, char* buffer, size_t buffer_size);
+
+void zetes_writer_begin_object(zetes_t* ctx);
+
+void zetes_writer_end_object(zetes_t* ctx);
+
+void zetes_writer_begin_array(zetes_t* ctx);
+
+void zetes_writer_end_array(zetes_t* ctx);
+
+void zetes_writer_key(zetes_t* ctx, const char* key);
+
+void zetes_writer_key_n(zetes_t* ctx, const char* key, size_t key_length);
+
+void zetes_writer_null(zetes_t* ctx);
+
+void zetes_writer_bool(zetes_t* ctx, bool value);
+
+void zetes_writer_number(zetes_t* ctx, zetes_number_t value);
+
+void zetes_writer_int(zetes_t* ctx, zetes_int_t value);
+
+void zetes_writer_string(zetes_t* ctx, const char* value);
+
+void zetes_writer_string_n(zetes_t* ctx, const char* value, size_t length);
+
+void zetes_writer_value(zetes_t* ctx);
+
+zetes_result_t zetes_writer_finish(zetes_t* ctx, size_t* length);
+
+void zetes_set_max_depth(zetes_t* ctx, size_t max_depth);
+
+void zetes_set_read_buffer(zetes_t* ctx, void* buffer, size_t buffer_size);
+
 zetes_result_t zetes_read(zetes_t* ctx, zetes_read_func_t read_func, void* user_data);
 
 zetes_result_t zetes_read_buffer(zetes_t* ctx, const char* buffer, size_t buffer_size);
 
+zetes_result_t zetes_read_insitu(zetes_t* ctx, char* buffer, size_t buffer_size);
+
+zetes_result_t zetes_read_lazy(zetes_t* ctx, const char* buffer, size_t buffer_size);
+
+zetes_result_t zetes_read_cbor(zetes_t* ctx, zetes_read_func_t read_func, void* user_data);
+
+zetes_result_t zetes_read_cbor_buffer(zetes_t* ctx, const void* buffer, size_t buffer_size);
+
+zetes_result_t zetes_snapshot(zetes_t* ctx, void* buffer, size_t buffer_size, size_t* length);
+
+zetes_result_t zetes_load_snapshot(zetes_t* ctx, void* buffer, size_t buffer_size);
+
+zetes_result_t zetes_feed(zetes_t* ctx, const void* data, size_t length);
+
+void zetes_begin_documents(zetes_t* ctx, zetes_read_func_t read_func, void* user_data);
+
+void zetes_begin_documents_buffer(zetes_t* ctx, const char* buffer, size_t buffer_size);
+
+void zetes_begin_documents_insitu(zetes_t* ctx, char* buffer, size_t buffer_size);
+
+bool zetes_read_next(zetes_t* ctx);
+
+size_t zetes_split_documents(const char* buffer, size_t buffer_size, size_t* offsets, size_t count);
+
+zetes_result_t zetes_validate(zetes_read_func_t read_func, void* user_data, char* buffer, size_t buffer_size,
+		size_t* error_offset);
+
+zetes_result_t zetes_validate_buffer(const char* buffer, size_t buffer_size, size_t* error_offset);
+
+void zetes_begin_events(zetes_t* ctx, zetes_read_func_t read_func, void* user_data);
+
+void zetes_begin_events_buffer(zetes_t* ctx, const char* buffer, size_t buffer_size);
+
+void zetes_begin_events_insitu(zetes_t* ctx, char* buffer, size_t buffer_size);
+
+zetes_event_t zetes_next_event(zetes_t* ctx);
+
+void zetes_skip_event(zetes_t* ctx);
+
+size_t zetes_event_depth(const zetes_t* ctx);
+
+zetes_type_t zetes_event_type(const zetes_t* ctx);
+
+const char* zetes_event_string_n(zetes_t* ctx, size_t* length);
+
+void zetes_push_event_value(zetes_t* ctx);
+
+void zetes_extract(zetes_t* ctx, const char* const* paths, size_t path_count);
+
 
 #ifndef _DOXYGEN
 
@@ -163,12 +409,18 @@ typedef struct zetes_value_t zetes_value_t;
 typedef struct zetes_array_element_t zetes_array_element_t;
 typedef struct zetes_array_t zetes_array_t;
 typedef struct zetes_object_member_t zetes_object_member_t;
+typedef struct zetes_object_element_t zetes_object_element_t;
 typedef struct zetes_object_t zetes_object_t;
+typedef struct zetes_intern_t zetes_intern_t;
+typedef struct zetes_reader_t zetes_reader_t;
+typedef struct zetes_writer_t zetes_writer_t;
+typedef struct zetes_block_t zetes_block_t;
 
 
 union zetes_variant_t {
 	bool _bool;
 	zetes_number_t _number;
+	zetes_int_t _int;
 	const char* _string;
 	zetes_array_t* _array;
 	zetes_object_t* _object;
@@ -177,6 +429,7 @@ union zetes_variant_t {
 
 struct zetes_value_t {
 	zetes_type_t type;
+	uint32_t length;
 	zetes_variant_t variant;
 };
 
@@ -188,35 +441,131 @@ struct zetes_array_element_t {
 
 
 struct zetes_array_t {
+	zetes_value_t* values;
+	size_t count;
+	size_t size;
 	zetes_array_element_t* first;
 	zetes_array_element_t* last;
+	const char* lazy;
+	const char* lazy_end;
 };
 
 
 struct zetes_object_member_t {
-	zetes_object_member_t* next;
 	const char* key;
+	uint32_t key_length;
+	uint32_t key_hash;
 	zetes_value_t value;
 };
 
 
+struct zetes_object_element_t {
+	zetes_object_element_t* next;
+	zetes_object_member_t member;
+};
+
+
 struct zetes_object_t {
-	zetes_object_member_t* first;
-	zetes_object_member_t* last;
+	zetes_object_member_t* members;
+	size_t count;
+	size_t size;
+	zetes_object_element_t* first;
+	zetes_object_element_t* last;
+	zetes_object_member_t** index;
+	uint32_t index_mask;
+	const char* lazy;
+	const char* lazy_end;
+};
+
+
+struct zetes_intern_t {
+	const char* key;
+	uint32_t key_length;
+	uint32_t key_hash;
+};
+
+
+struct zetes_reader_t {
+	zetes_read_func_t read_func;
+	void* user_data;
+	char* buffer_i;
+	char* buffer_e;
+	bool insitu;
+	uint8_t state;
+	zetes_event_t event;
+	size_t depth;
+	void* transient;
+	void* transient_end;
+	zetes_value_t value;
+	size_t saved_depth;
+	char* carry;
+	size_t carry_length;
+	bool carry_escape;
+	uint8_t* nesting_ext;
+	size_t max_depth;
+	uint8_t nesting[(ZETES_MAX_DEPTH + 7) / 8];
+};
+
+
+struct zetes_writer_t {
+	zetes_write_func_t write_func;
+	void* user_data;
+	char* buffer_b;
+	char* buffer_i;
+	char* buffer_e;
+	size_t emitted;
+	uint8_t state;
+	size_t depth;
+	uint8_t nesting[(ZETES_MAX_DEPTH + 7) / 8];
+};
+
+
+struct zetes_block_t {
+	zetes_block_t* prev;
+	size_t size;
 };
 
 
 struct zetes_t {
 	zetes_result_t result;
 	void* buffer_begin;
+	size_t buffer_size;
+	void* buffer_base;
 	void* buffer_end;
 	void* buffer_ptr;
+	void* buffer_top;
+	zetes_block_t* block;
+	zetes_block_t* base_block;
+	size_t block_count;
+	zetes_alloc_func_t alloc_func;
+	zetes_free_func_t free_func;
+	void* alloc_user_data;
 	zetes_value_t* stack_begin;
 	zetes_value_t* stack_end;
 	zetes_value_t* stack_ptr;
+	char* read_buffer;
+	size_t read_buffer_size;
+	char* write_buffer;
+	size_t write_buffer_size;
+	bool raw_utf8;
+	zetes_intern_t* intern_table;
+	uint32_t intern_mask;
+	size_t intern_count;
+	zetes_reader_t reader;
+	zetes_writer_t writer;
 	char temp[ZETES_TEMP_BUFFER_SIZE];
+#if ZETES_STATS
+	zetes_stats_t stats;
+#endif
 };
 
+void zetes_push_member_value(zetes_t* ctx, const zetes_object_member_t* member);
+
 #endif // _DOXYGEN
 
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* _ZETES_H_ */
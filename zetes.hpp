@@ -0,0 +1,403 @@
+/** @file zetes.hpp
+ * @brief Header-only C++17 interface to zetes.
+ *
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+#ifndef _ZETES_HPP_
+#define _ZETES_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "zetes.h"
+
+
+namespace zetes {
+
+
+// Structs are bound to JSON objects by specialising binding<T> with a tuple of fields, for example
+//
+//     template<> struct zetes::binding<point> {
+//         static constexpr auto fields = std::make_tuple(zetes::field("x", &point::x), zetes::field("y", &point::y));
+//     };
+//
+// Members may be bool, arithmetic, std::string, std::string_view (which refers into the tree), bound
+// structs, or std::optional and std::vector of any of them.
+template<class T>
+struct binding;
+
+
+constexpr uint32_t hash_key(std::string_view key) {
+	// FNV-1a, as hash_key() in zetes.c, so that member hashes can be compared with these
+	uint32_t hash = 2166136261UL;
+
+	for (char c : key) {
+		hash = (hash ^ (uint8_t) c) * 16777619UL;
+	}
+
+	return hash;
+}
+
+
+template<class T, class M>
+struct field_t {
+	std::string_view name;
+	uint32_t hash;
+	M T::* member;
+};
+
+
+template<class T, class M>
+constexpr field_t<T, M> field(std::string_view name, M T::* member) {
+	return field_t<T, M> {name, hash_key(name), member};
+}
+
+
+namespace detail {
+
+
+template<class T, class = void>
+struct is_bound : std::false_type {};
+
+template<class T>
+struct is_bound<T, std::void_t<decltype(binding<T>::fields)>> : std::true_type {};
+
+template<class T>
+struct is_optional : std::false_type {};
+
+template<class T>
+struct is_optional<std::optional<T>> : std::true_type {};
+
+template<class T>
+struct is_vector : std::false_type {};
+
+template<class T, class A>
+struct is_vector<std::vector<T, A>> : std::true_type {};
+
+
+inline int append_func(const void* buffer, int length, void* user_data) {
+	// exceptions can't pass back through the C code, so running out of memory is a write error
+	try {
+		static_cast<std::string*>(user_data)->append(static_cast<const char*>(buffer), (size_t) length);
+	} catch (const std::bad_alloc&) {
+		return -1;
+	}
+
+	return length;
+}
+
+
+template<class T>
+void decode(zetes_t* ctx, T& out);
+
+
+template<class T, class F>
+bool bind_field(zetes_t* ctx, const zetes_object_member_t* member, T& out, const F& f) {
+	// the hash rules out nearly every other field before any key is compared
+	if ( member->key_hash != f.hash || f.name != std::string_view(member->key, member->key_length) ) {
+		return false;
+	}
+
+	zetes_push_member_value(ctx, member);
+	decode(ctx, out.*(f.member));
+
+	return true;
+}
+
+
+template<class T>
+void bind_object(zetes_t* ctx, T& out) {
+	// One pass over the members of the object on top of the stack, which stays there. Unknown keys
+	// are skipped, and fields without a member keep their value.
+	zetes_object_size(ctx);
+
+	if ( !zetes_ok(ctx) ) {
+		return;
+	}
+
+	const zetes_object_t* object = ctx->stack_ptr->variant._object;
+	const zetes_object_element_t* element;
+	size_t i;
+
+	auto visit = [&](const zetes_object_member_t* member) {
+		std::apply([&](const auto&... fields) {
+			(bind_field(ctx, member, out, fields) || ...);
+		}, binding<T>::fields);
+	};
+
+	for (i = 0; i < object->count && zetes_ok(ctx); i++) {
+		visit(&object->members[i]);
+	}
+
+	for (element = object->first; element && zetes_ok(ctx); element = element->next) {
+		visit(&element->member);
+	}
+}
+
+
+template<class T>
+void decode(zetes_t* ctx, T& out) {
+	// pops the value on top of the stack into out
+	if constexpr ( std::is_same_v<T, bool> ) {
+		out = zetes_pop_bool(ctx);
+	} else if constexpr ( std::is_integral_v<T> ) {
+		zetes_int_t value = zetes_pop_int(ctx);
+
+		if constexpr ( std::is_signed_v<T> ) {
+			if ( (intmax_t) value < (intmax_t) std::numeric_limits<T>::min() || (intmax_t) value > (intmax_t) std::numeric_limits<T>::max() ) {
+				zetes_set_error(ctx, ZETES_RESULT_TYPE_MISMATCH);
+			}
+		} else {
+			if ( value < 0 || (uintmax_t) value > (uintmax_t) std::numeric_limits<T>::max() ) {
+				zetes_set_error(ctx, ZETES_RESULT_TYPE_MISMATCH);
+			}
+		}
+
+		out = static_cast<T>(value);
+	} else if constexpr ( std::is_floating_point_v<T> ) {
+		out = static_cast<T>(zetes_pop_number(ctx));
+	} else if constexpr ( std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view> ) {
+		size_t length = 0;
+		const char* value = zetes_pop_string_n(ctx, &length);
+
+		if ( value ) {
+			out = T(value, length);
+		}
+	} else if constexpr ( is_optional<T>::value ) {
+		if ( zetes_type(ctx) == ZETES_TYPE_NULL ) {
+			zetes_pop(ctx);
+			out.reset();
+		} else {
+			decode(ctx, out.emplace());
+		}
+	} else if constexpr ( is_vector<T>::value ) {
+		size_t size = zetes_array_size(ctx);
+
+		out.clear();
+		out.reserve(size);
+
+		for (size_t i = 0; i < size && zetes_ok(ctx); i++) {
+			zetes_array_index(ctx, i);
+			decode(ctx, out.emplace_back());
+		}
+
+		zetes_pop(ctx);
+	} else if constexpr ( is_bound<T>::value ) {
+		bind_object(ctx, out);
+		zetes_pop(ctx);
+	} else {
+		static_assert(is_bound<T>::value, "zetes: no binding for this type");
+	}
+}
+
+
+template<class T>
+void encode(zetes_t* ctx, const T& in);
+
+
+template<class T, class F>
+void encode_field(zetes_t* ctx, const T& in, const F& f) {
+	const auto& value = in.*(f.member);
+
+	// an empty optional leaves its member out
+	if constexpr ( is_optional<std::decay_t<decltype(value)>>::value ) {
+		if ( !value ) {
+			return;
+		}
+	}
+
+	zetes_writer_key_n(ctx, f.name.data(), f.name.size());
+	encode(ctx, value);
+}
+
+
+template<class T>
+void encode(zetes_t* ctx, const T& in) {
+	if constexpr ( std::is_same_v<T, bool> ) {
+		zetes_writer_bool(ctx, in);
+	} else if constexpr ( std::is_integral_v<T> ) {
+		// as decode() on the way in, a value zetes_int_t can't hold is a mismatch rather than wrapped
+		if constexpr ( std::is_signed_v<T> ) {
+			if ( (intmax_t) in < (intmax_t) std::numeric_limits<zetes_int_t>::min() || (intmax_t) in > (intmax_t) std::numeric_limits<zetes_int_t>::max() ) {
+				zetes_set_error(ctx, ZETES_RESULT_TYPE_MISMATCH);
+				return;
+			}
+		} else {
+			if ( (uintmax_t) in > (uintmax_t) std::numeric_limits<zetes_int_t>::max() ) {
+				zetes_set_error(ctx, ZETES_RESULT_TYPE_MISMATCH);
+				return;
+			}
+		}
+
+		zetes_writer_int(ctx, static_cast<zetes_int_t>(in));
+	} else if constexpr ( std::is_floating_point_v<T> ) {
+		zetes_writer_number(ctx, static_cast<zetes_number_t>(in));
+	} else if constexpr ( std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view> ) {
+		zetes_writer_string_n(ctx, in.data(), in.size());
+	} else if constexpr ( is_optional<T>::value ) {
+		if ( in ) {
+			encode(ctx, *in);
+		} else {
+			zetes_writer_null(ctx);
+		}
+	} else if constexpr ( is_vector<T>::value ) {
+		zetes_writer_begin_array(ctx);
+
+		for (const auto& value : in) {
+			encode(ctx, value);
+		}
+
+		zetes_writer_end_array(ctx);
+	} else if constexpr ( is_bound<T>::value ) {
+		zetes_writer_begin_object(ctx);
+
+		std::apply([&](const auto&... fields) {
+			(encode_field(ctx, in, fields), ...);
+		}, binding<T>::fields);
+
+		zetes_writer_end_object(ctx);
+	} else {
+		static_assert(is_bound<T>::value, "zetes: no binding for this type");
+	}
+}
+
+
+} // namespace detail
+
+
+class context {
+public:
+	context(void* buffer, size_t buffer_size, size_t stack_depth = 32) {
+		zetes_init(&ctx_, stack_depth, buffer, buffer_size);
+	}
+
+	~context() {
+		zetes_cleanup(&ctx_);
+	}
+
+	context(const context&) = delete;
+	context& operator=(const context&) = delete;
+
+	zetes_t* get() { return &ctx_; }
+	const zetes_t* get() const { return &ctx_; }
+
+	zetes_result_t result() const { return zetes_result(&ctx_); }
+	bool ok() const { return zetes_ok(&ctx_); }
+	void reset() { zetes_reset(&ctx_); }
+
+	void set_allocator(zetes_alloc_func_t alloc_func, zetes_free_func_t free_func, void* user_data) {
+		zetes_set_allocator(&ctx_, alloc_func, free_func, user_data);
+	}
+
+	zetes_result_t read(std::string_view json) { return zetes_read_buffer(&ctx_, json.data(), json.size()); }
+	zetes_result_t read_lazy(std::string_view json) { return zetes_read_lazy(&ctx_, json.data(), json.size()); }
+
+	zetes_result_t write(std::string& out) { return zetes_write(&ctx_, detail::append_func, &out); }
+
+	zetes_type_t type() { return zetes_type(&ctx_); }
+	void pop() { zetes_pop(&ctx_); }
+
+	void push_null() { zetes_push_null(&ctx_); }
+	void push_bool(bool value) { zetes_push_bool(&ctx_, value); }
+	void push_number(zetes_number_t value) { zetes_push_number(&ctx_, value); }
+	void push_int(zetes_int_t value) { zetes_push_int(&ctx_, value); }
+	void push_string(std::string_view value) { zetes_push_string_n(&ctx_, value.data(), value.size()); }
+	void push_new_array() { zetes_push_new_array(&ctx_); }
+	void push_new_object() { zetes_push_new_object(&ctx_); }
+
+	bool pop_bool() { return zetes_pop_bool(&ctx_); }
+	zetes_number_t pop_number() { return zetes_pop_number(&ctx_); }
+	zetes_int_t pop_int() { return zetes_pop_int(&ctx_); }
+
+	std::string_view pop_string() {
+		size_t length = 0;
+		const char* value = zetes_pop_string_n(&ctx_, &length);
+
+		return value ? std::string_view(value, length) : std::string_view();
+	}
+
+	size_t array_size() { return zetes_array_size(&ctx_); }
+	void array_index(size_t index) { zetes_array_index(&ctx_, index); }
+	void array_append() { zetes_array_append(&ctx_); }
+
+	size_t object_size() { return zetes_object_size(&ctx_); }
+	bool has(std::string_view key) { return zetes_object_has_n(&ctx_, key.data(), key.size()); }
+	void get(std::string_view key) { zetes_object_get_n(&ctx_, key.data(), key.size()); }
+	void set(std::string_view key) { zetes_object_set_n(&ctx_, key.data(), key.size()); }
+	void get_path(std::string_view path) { zetes_get_path_n(&ctx_, path.data(), path.size()); }
+
+	template<class T>
+	zetes_result_t bind(T& out) {
+		// pops the value on top of the stack into out
+		detail::decode(&ctx_, out);
+		return result();
+	}
+
+	template<class T>
+	zetes_result_t read(std::string_view json, T& out) {
+		return read(json) == ZETES_RESULT_OK ? bind(out) : result();
+	}
+
+	template<class T>
+	zetes_result_t write(const T& in, zetes_write_func_t write_func, void* user_data) {
+		// straight from the struct through the streaming writer, without building a tree
+		zetes_writer_begin(&ctx_, write_func, user_data);
+		detail::encode(&ctx_, in);
+		return zetes_writer_finish(&ctx_, nullptr);
+	}
+
+	template<class T>
+	zetes_result_t write(const T& in, std::string& out) {
+		return write(in, detail::append_func, &out);
+	}
+
+private:
+	zetes_t ctx_;
+};
+
+
+template<size_t BufferSize, size_t StackDepth = 32>
+class static_context : public context {
+public:
+	static_context() : context(buffer_, BufferSize, StackDepth) {}
+
+private:
+	alignas(ZETES_ALIGN) char buffer_[BufferSize];
+};
+
+
+} // namespace zetes
+
+#endif /* _ZETES_HPP_ */